@@ -20,4 +20,18 @@ public:
   // Get the dimensions of the screen.
   virtual int numRows() const = 0;
   virtual int numCols() const = 0;
+
+  // Draw a string at the given position and color.
+  virtual void drawString(int row, int col, int color, const char *str) = 0;
+
+  // Counters of the performance overlay (see PerformanceOverlay.h): frames
+  // written to the screen, frames that were dropped and bytes written so
+  // far (-1 if unknown).
+  virtual long long getRenderedFrames() const = 0;
+  virtual long long getDroppedFrames() const = 0;
+  virtual long long getBytesWritten() const = 0;
+  // Keys measured, total and maximum input to draw latency in
+  // microseconds since the last call (the counters start again at 0).
+  virtual void takeInputToDraw(long long *count, long long *totalUs,
+                               long long *maxUs) = 0;
 };
@@ -2,10 +2,12 @@
 // Code snippets from the lectures where used
 
 #include "./AbstractTetrisGame.h"
+#include "./AllocationTracker.h"
+#include "./Trace.h"
 #include "./Tetromino.h"
-#include <chrono>
-#include <random>
-#include <string>
+#include "./Zobrist.h"
+#include <algorithm>
+#include <cstring>
 #include <vector>
 
 void AbstractTetrisGame::updateLevelAndSpeed(int increaseLevelBy) {
@@ -35,6 +37,8 @@ void AbstractTetrisGame::updateScore() { currentPoints += earnedPoints; }
 Collision AbstractTetrisGame::isColliding(bool downPressed, bool leftRotaion,
                                           bool rightRotation,
                                           std::vector<Point> previousLocation) {
+  ALLOCATION_SCOPE("isColliding");
+  TRACE_SCOPE("isColliding");
 
   // currentLocation is different from previousLocation because we have
   // performed moving by this point
@@ -193,71 +197,61 @@ Collision AbstractTetrisGame::isColliding(bool downPressed, bool leftRotaion,
   return Collision::Nothing;
 }
 
+int AbstractTetrisGame::dropDistance() const {
+  int distance = BitBoard::rows;
+  for (auto point : currentTetromino->getCurrentLocation()) {
+    // Board rows below this cell start at `below`, cells above the roof
+    // have negative rows.
+    int below = point.row - offset_row;
+    int col = point.col - offset_col - 1;
+    uint32_t mask = columnMasks[col];
+    uint32_t blocks = below >= 0 ? mask >> below : mask << -below;
+
+    // Without blocks below, the cell can fall down to the last row.
+    int free = blocks == 0 ? BitBoard::rows - below : __builtin_ctz(blocks);
+    distance = std::min(distance, free);
+  }
+  return distance;
+}
+
 void AbstractTetrisGame::updateSurface() {
-  // We are traversing gameField from column to column
-  // and searching for the first drawn pixel in each column
-  // and then going to the next column. Vector of such pixels
-  // will form the "surface" of the gameField, which we will
-  // need for the collision
+  TRACE_SCOPE("updateSurface");
+  // The first drawn pixel in each column forms the "surface" of the
+  // gameField, which we will need for the collision. It's the lowest
+  // set bit of the column mask (the wall column has no mask).
 
   for (int j = offset_col; j < offset_col + cols_; j++) {
-    // Temporary variable to store index i
-    char index = 0;
-
-    for (int i = offset_row; i < offset_row + rows_; i++) {
-      // If there exists (Point{i, j} = true) then we found our first
-      // non zero point in column and we can store it's index and go to the next
-      // column
-      if (gameField[Point{i, j, NamedColors::BLACK}]) {
-        index = i;
-        break;
-      }
-    }
+    int col = j - offset_col - 1;
+    uint32_t mask = col >= 0 ? columnMasks[col] : 0;
 
-    // If index == 0 it means that the column is empty
-    // and we will set point from last row as the highest point in this column.
-    if (index == 0) {
+    // If the column is empty we will set point from last row as the
+    // highest point in this column.
+    if (mask == 0) {
       surface.insert(Point{offset_row + rows_, j, NamedColors::BLACK});
-
-    }
-    // If index != 0 then column i have the highest point at (i, j)
-    else {
+    } else {
+      int index = offset_row + 1 + __builtin_ctz(mask);
       surface.insert(Point{index, j, NamedColors::BLACK});
     }
   }
 }
 
 NewAbstractTetromino *AbstractTetrisGame::chooseTetromino(int randomNumber) {
-  if (randomNumber == 0) {
-    return new TetrominoI();
-  } else if (randomNumber == 1) {
-    return new TetrominoJ();
-  } else if (randomNumber == 2) {
-    return new TetrominoL();
-  } else if (randomNumber == 3) {
-    return new TetrominoO();
-  } else if (randomNumber == 4) {
-    return new TetrominoS();
-  } else if (randomNumber == 5) {
-    return new TetrominoZ();
-  } else if (randomNumber == 6) {
-    return new TetrominoT();
-  }
-
-  // Just to supress warning
-  return new TetrominoO();
+  ALLOCATION_SCOPE("chooseTetromino");
+  return TetrominoFactory::create(randomNumber);
 }
 
 int AbstractTetrisGame::generateRandomNumber(int a, int b) {
-  // Use current time as seed to get a new number each time
-  unsigned seed = std::chrono::system_clock::now().time_since_epoch().count();
-  static std::default_random_engine generator(seed);
-
-  // Create uniforme distribution of numbers from 0 to 6
-  std::uniform_int_distribution<int> distribution(a, b);
-
-  // Return num in [0, 6] with p(num) = 1/7.
-  return distribution(generator);
+  // SplitMix64 step, like PieceGenerator. The state is a member, so it can
+  // be saved in a snapshot.
+  rngState += 0x9e3779b97f4a7c15;
+  uint64_t z = rngState;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  z = z ^ (z >> 31);
+
+  // Return num in [a, b] with p(num) = 1/(b - a + 1) (the bias is
+  // negligible for a few values).
+  return a + static_cast<int>((z >> 32) % (b - a + 1));
 }
 
 void AbstractTetrisGame::generateCurrentAndNext(int a, int b) {
@@ -278,9 +272,150 @@ void AbstractTetrisGame::generateCurrentAndNext(int a, int b) {
   previousRandomNumber = nextRandomNumber;
 }
 
-std::string AbstractTetrisGame::intToString(int number, int maxLength) {
-  std::string stringNumber = std::to_string(number);
-  int leadingZeroes = maxLength - stringNumber.length();
-  stringNumber.insert(0, leadingZeroes, '0');
-  return stringNumber;
+void AbstractTetrisGame::formatNumber(int number, int maxLength, char *text) {
+  int largest = 1;
+  for (int i = 0; i < maxLength; i++) {
+    largest *= 10;
+  }
+  number = std::clamp(number, 0, largest - 1);
+  for (int i = maxLength - 1; i >= 0; i--) {
+    text[i] = '0' + number % 10;
+    number /= 10;
+  }
+  text[maxLength] = '\0';
+}
+
+void AbstractTetrisGame::toggleCell(Point point) {
+  int row = point.row - offset_row - 1;
+  int col = point.col - offset_col - 1;
+  boardHash ^= Zobrist::cellKey(row, col);
+  if (row >= 0 && row < BitBoard::rows && col >= 0 && col < BitBoard::cols) {
+    columnMasks[col] ^= 1u << row;
+  }
+}
+
+void AbstractTetrisGame::updatePieceHash(int currentIndex, int nextIndex) {
+  pieceHash = Zobrist::pieceKey(currentIndex) ^ Zobrist::previewKey(nextIndex);
+}
+
+uint64_t AbstractTetrisGame::computeBoardHash() {
+  uint64_t hash = 0;
+  for (auto &[point, isAlive] : gameField) {
+    if (isAlive) {
+      hash ^= Zobrist::cellKey(point.row - offset_row - 1,
+                               point.col - offset_col - 1);
+    }
+  }
+  return hash;
+}
+
+BitBoard AbstractTetrisGame::toBitBoard() {
+  BitBoard board;
+  for (int j = 0; j < BitBoard::cols; j++) {
+    uint32_t mask = columnMasks[j];
+    while (mask != 0) {
+      board.setCell(__builtin_ctz(mask), j);
+      mask &= mask - 1;
+    }
+  }
+  return board;
+}
+
+GameSnapshot AbstractTetrisGame::takeSnapshot() const {
+  GameSnapshot snapshot;
+  // Zero everything, so equal games give equal bytes (and checksums).
+  std::memset(&snapshot, 0, sizeof(snapshot));
+
+  snapshot.rngState = rngState;
+  snapshot.level = currentLevel;
+  snapshot.previousQuotient = previousQuotient;
+  snapshot.lines = destroyedLines;
+  snapshot.score = currentPoints;
+  for (int i = 0; i < numberOfTetrominos; i++) {
+    snapshot.statistics[i] = statistics.at(i);
+  }
+
+  for (auto &[point, isAlive] : gameField) {
+    int row = point.row - offset_row - 1;
+    int col = point.col - offset_col - 1;
+    if (isAlive && row >= 0 && row < GameSnapshot::rows && col >= 0 &&
+        col < GameSnapshot::cols) {
+      snapshot.boardRows[row] |= 1 << col;
+      snapshot.colors[row][col] = static_cast<uint8_t>(point.color);
+    }
+  }
+
+  // The deque holds the preview and, after a new pair was generated, the
+  // second tetromino of the pair.
+  snapshot.nextPiece = deque.empty() ? -1 : deque[0];
+  snapshot.pendingPiece = deque.size() > 1 ? deque[1] : -1;
+  snapshot.previousPiece = previousRandomNumber;
+
+  snapshot.currentPiece = currentTetromino != nullptr ? currentTetrominoIndex
+                                                      : -1;
+  if (currentTetromino != nullptr) {
+    snapshot.currentAngle = currentTetromino->getCurrentAngle() / 90;
+    std::vector<Point> location = currentTetromino->getCurrentLocation();
+    for (int i = 0; i < currentTetromino->getTetrominoSize(); i++) {
+      snapshot.currentRows[i] = location[i].row - offset_row - 1;
+      snapshot.currentCols[i] = location[i].col - offset_col - 1;
+    }
+  }
+
+  snapshot.seal();
+  return snapshot;
+}
+
+void AbstractTetrisGame::restoreSnapshot(const GameSnapshot &snapshot) {
+  rngState = snapshot.rngState;
+  currentLevel = snapshot.level;
+  updateLevelAndSpeed();
+  previousQuotient = snapshot.previousQuotient;
+  destroyedLines = snapshot.lines;
+  currentPoints = snapshot.score;
+  for (int i = 0; i < numberOfTetrominos; i++) {
+    statistics[i] = snapshot.statistics[i];
+  }
+
+  // toggleCell keeps the hash and the column masks in sync, and the point
+  // is inserted again for its color.
+  for (int i = 0; i < GameSnapshot::rows; i++) {
+    for (int j = 0; j < GameSnapshot::cols; j++) {
+      bool isAlive = (snapshot.boardRows[i] >> j) & 1;
+      Point point{offset_row + 1 + i, offset_col + 1 + j,
+                  isAlive ? static_cast<NamedColors>(snapshot.colors[i][j])
+                          : NamedColors::BLACK};
+      if (gameField[point] != isAlive) {
+        toggleCell(point);
+      }
+      gameField.erase(point);
+      gameField.insert(std::pair(point, isAlive));
+    }
+  }
+  surface.clear();
+  updateSurface();
+
+  deque.clear();
+  if (snapshot.nextPiece != -1) {
+    deque.push_back(snapshot.nextPiece);
+  }
+  if (snapshot.pendingPiece != -1) {
+    deque.push_back(snapshot.pendingPiece);
+  }
+  previousRandomNumber = snapshot.previousPiece;
+
+  delete currentTetromino;
+  currentTetromino = nullptr;
+  currentTetrominoIndex = snapshot.currentPiece;
+  if (currentTetrominoIndex != -1) {
+    currentTetromino = chooseTetromino(currentTetrominoIndex);
+    std::vector<Point> location = currentTetromino->getCurrentLocation();
+    for (int i = 0; i < currentTetromino->getTetrominoSize(); i++) {
+      location[i].row = offset_row + 1 + snapshot.currentRows[i];
+      location[i].col = offset_col + 1 + snapshot.currentCols[i];
+    }
+    currentTetromino->setCurrentLocation(location);
+    currentTetromino->setCurrentAngle(snapshot.currentAngle * 90);
+  }
+  updatePieceHash(currentTetrominoIndex, snapshot.nextPiece);
 }
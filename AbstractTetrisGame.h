@@ -4,8 +4,11 @@
 #pragma once
 
 #include "./AbstractTetromino.h"
+#include "./BitBoard.h"
 #include "./Point.h"
+#include "./Snapshot.h"
 #include "./TerminalManager.h"
+#include <cstdint>
 #include <deque>
 #include <functional>
 #include <set>
@@ -43,6 +46,10 @@ public:
 
   Collision isColliding(bool downPressed, bool leftRotaion, bool rightRotation,
                         std::vector<Point> previousLocation);
+  // Number of rows the current tetromino can move down before it lands.
+  // Comes from the column masks, so no collision test per row is needed
+  // (used for hard drop and the ghost tetromino).
+  int dropDistance() const;
   void updateSurface();
   // Should be implemented separetly by
   // MockTetrsGame and TetrisGame.
@@ -55,10 +62,42 @@ public:
   // Calculations.
   int generateRandomNumber(int a, int b);
   void generateCurrentAndNext(int a = 0, int b = 6);
-  std::string intToString(int number, int maxLength);
+  // Write `number` with leading zeroes as exactly `maxLength` digits and
+  // a '\0' into `text` (no allocation). Too large numbers show all 9s.
+  static void formatNumber(int number, int maxLength, char *text);
+
+  // Zobrist hashing (see Zobrist.h).
+  // XOR the key of a single cell into the board hash and flip its bit in
+  // columnMasks. Must be called every time a point is added to or removed
+  // from gameField.
+  void toggleCell(Point point);
+  // Remember which tetrominos are current and in the preview box.
+  void updatePieceHash(int currentIndex, int nextIndex);
+  // Hash of the whole position: board, current and next tetromino.
+  uint64_t getPositionHash() const { return boardHash ^ pieceHash; }
+  uint64_t getBoardHash() const { return boardHash; }
+  // Recompute the board hash from scratch (used to verify the
+  // incremental updates).
+  uint64_t computeBoardHash();
+
+  // Copy of gameField in the compact form used by the bot.
+  BitBoard toBitBoard();
+
+  // Occupied cells of a playable column (0 is the first column right of
+  // the wall), bit i is row offset_row + 1 + i.
+  uint32_t getColumnMask(int col) const { return columnMasks[col]; }
+
+  // Whole state of the game (see Snapshot.h). After a restore the game
+  // continues with the same tetromino, in the same place, and the same
+  // sequence of tetrominos. Only playable snapshots can be restored (see
+  // GameSnapshot::isPlayable, MappedSnapshot checks it).
+  GameSnapshot takeSnapshot() const;
+  void restoreSnapshot(const GameSnapshot &snapshot);
 
 protected:
-  NewAbstractTetromino *currentTetromino;
+  NewAbstractTetromino *currentTetromino = nullptr;
+  // Index of currentTetromino (see chooseTetromino).
+  int currentTetrominoIndex = -1;
 
   const int numberOfTetrominos = 7;
   const int rows_ = 21;
@@ -73,9 +112,12 @@ protected:
 
   // Variables to store rundom numbers, based on which
   // we will create current and next tetrominos.
-  int previousRandomNumber;
+  int previousRandomNumber = -1;
   int currentRandomNumber;
   int nextRandomNumber;
+  // State of the random number generator. The same seed gives the same
+  // tetrominos as PieceGenerator (and HeadlessGame).
+  uint64_t rngState = 0;
 
   // Keys for rotation.
   char leftRotationKey;
@@ -105,6 +147,16 @@ protected:
   // the current figure dies and the new one starts its cycle.
   std::set<Point> surface;
 
+  // Incrementally updated Zobrist hashes of the occupied cells of gameField
+  // and of the current / next tetromino.
+  uint64_t boardHash = 0;
+  uint64_t pieceHash = 0;
+
+  // The same cells as gameField, but one bitmask per column (see
+  // getColumnMask). The highest cell of a column is its lowest set bit,
+  // so the surface doesn't need a scan of gameField.
+  uint32_t columnMasks[BitBoard::cols] = {};
+
   // Falling speed. It's a bit misleading that it's in ms, but I've
   // found such a representation rather conviniet.
   // See TetrisGame play() for more details.
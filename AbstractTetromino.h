@@ -3,6 +3,7 @@
 
 #pragma once
 
+#include "./AllocationTracker.h"
 #include "./Point.h"
 #include <cmath>
 #include <vector>
@@ -20,7 +21,10 @@ public:
   virtual void rotate(bool left);
 
   // Getters
-  std::vector<Point> getCurrentLocation() const { return currentLocation_; }
+  std::vector<Point> getCurrentLocation() const {
+    ALLOCATION_SCOPE("getCurrentLocation");
+    return currentLocation_;
+  }
   NamedColors getTetrominoColor() const { return color_; }
   int getTetrominoSize() const { return size_; };
   int getCurrentAngle() const { return currentAngle_; }
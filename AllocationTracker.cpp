@@ -0,0 +1,210 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./AllocationTracker.h"
+#include <algorithm>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Plain thread locals, the hooks can't allocate for their own state.
+thread_local AllocationTracker::Counts threadCounts_;
+thread_local int currentFunction_ = -1;
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+void *allocate(size_t size) {
+  AllocationTracker::recordAllocation(size);
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void *allocateAligned(size_t size, std::align_val_t alignment) {
+  AllocationTracker::recordAllocation(size);
+  size_t align = static_cast<size_t>(alignment);
+  // aligned_alloc needs a multiple of the alignment.
+  size_t rounded = (std::max(size, size_t(1)) + align - 1) / align * align;
+  return std::aligned_alloc(align, rounded);
+}
+
+void deallocate(void *pointer) {
+  if (pointer != nullptr) {
+    AllocationTracker::recordFree();
+    std::free(pointer);
+  }
+}
+#endif
+
+} // namespace
+
+AllocationTracker::Function AllocationTracker::functions_[maxFunctions];
+std::atomic<int> AllocationTracker::numberOfFunctions_{0};
+
+AllocationTracker::Counts AllocationTracker::threadCounts() {
+  return threadCounts_;
+}
+
+void AllocationTracker::recordAllocation(size_t bytes) {
+  threadCounts_.allocations += 1;
+  threadCounts_.bytes += bytes;
+  if (currentFunction_ >= 0) {
+    Function &function = functions_[currentFunction_];
+    function.allocations.fetch_add(1, std::memory_order_relaxed);
+    function.bytes.fetch_add(bytes, std::memory_order_relaxed);
+  }
+}
+
+void AllocationTracker::recordFree() { threadCounts_.frees += 1; }
+
+int AllocationTracker::registerFunction(const char *name) {
+  int function = numberOfFunctions_.fetch_add(1);
+  if (function >= maxFunctions) {
+    numberOfFunctions_ = maxFunctions;
+    return -1;
+  }
+  functions_[function].name = name;
+  return function;
+}
+
+int AllocationTracker::numberOfFunctions() {
+  return std::min(numberOfFunctions_.load(), maxFunctions);
+}
+
+const char *AllocationTracker::functionName(int function) {
+  return functions_[function].name;
+}
+
+AllocationTracker::Counts AllocationTracker::functionCounts(int function) {
+  Counts counts;
+  counts.allocations = functions_[function].allocations.load();
+  counts.bytes = functions_[function].bytes.load();
+  return counts;
+}
+
+void AllocationTracker::printFunctions(std::ostream &out) {
+  for (int function = 0; function < numberOfFunctions(); function++) {
+    Counts counts = functionCounts(function);
+    if (counts.allocations == 0) {
+      continue;
+    }
+    out << functionName(function) << ": " << counts.allocations
+        << " allocations, " << counts.bytes << " bytes" << std::endl;
+  }
+}
+
+AllocationTracker::Scope::Scope(int function) : previous_(currentFunction_) {
+  if (function >= 0) {
+    currentFunction_ = function;
+  }
+}
+
+AllocationTracker::Scope::~Scope() { currentFunction_ = previous_; }
+
+void AllocationTracker::Meter::start() {
+  startAllocations_ = threadCounts_.allocations;
+  isRunning_ = true;
+}
+
+void AllocationTracker::Meter::stop() {
+  if (!isRunning_) {
+    return;
+  }
+  long long allocations = threadCounts_.allocations - startAllocations_;
+  periods_ += 1;
+  allocations_ += allocations;
+  maxAllocations_ = std::max(maxAllocations_, allocations);
+  isRunning_ = false;
+}
+
+void AllocationTracker::Meter::mark() {
+  stop();
+  start();
+}
+
+double AllocationTracker::Meter::averageAllocations() const {
+  return periods_ == 0 ? 0 : (double)allocations_ / periods_;
+}
+
+// Replacements of the global operator new / delete, only in the
+// instrumentation build: they would replace the new / delete of
+// AddressSanitizer as well (and its alloc-dealloc-mismatch checks).
+// ____________________________________________________________________________
+#ifdef TETRIS_TRACK_ALLOCATIONS
+void *operator new(size_t size) {
+  void *pointer = allocate(size);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept {
+  return allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment) {
+  void *pointer = allocateAligned(size, alignment);
+  if (pointer == nullptr) {
+    throw std::bad_alloc();
+  }
+  return pointer;
+}
+
+void *operator new[](size_t size, std::align_val_t alignment) {
+  return operator new(size, alignment);
+}
+
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t &) noexcept {
+  return allocateAligned(size, alignment);
+}
+
+void *operator new[](size_t size, std::align_val_t alignment,
+                     const std::nothrow_t &) noexcept {
+  return allocateAligned(size, alignment);
+}
+
+void operator delete(void *pointer) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer) noexcept { deallocate(pointer); }
+void operator delete(void *pointer, size_t) noexcept { deallocate(pointer); }
+void operator delete[](void *pointer, size_t) noexcept { deallocate(pointer); }
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete(void *pointer, size_t, std::align_val_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void *pointer, size_t, std::align_val_t) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t,
+                     const std::nothrow_t &) noexcept {
+  deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t,
+                       const std::nothrow_t &) noexcept {
+  deallocate(pointer);
+}
+#endif
@@ -0,0 +1,99 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Replacing the global operator new / delete:
+// https://en.cppreference.com/w/cpp/memory/new/operator_new
+//
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+
+// Counts the allocations of every thread. In the instrumentation build
+// (make tracked, -DTETRIS_TRACK_ALLOCATIONS) the global operator new and
+// delete are replaced in AllocationTracker.cpp, so every allocation of the
+// program is counted (one thread local addition per allocation). In the
+// normal build nothing is replaced and all counts stay 0.
+//
+// Allocations can also be attributed to functions: inside an
+// ALLOCATION_SCOPE the allocations are added to the innermost scope. The
+// scopes are only compiled into the instrumentation build as well, so the
+// hot functions cost nothing in the normal build.
+class AllocationTracker {
+public:
+  struct Counts {
+    long long allocations = 0;
+    long long frees = 0;
+    long long bytes = 0;
+  };
+
+  // Counts of the calling thread since it started.
+  static Counts threadCounts();
+
+  // Called by the operator new / delete hooks.
+  static void recordAllocation(size_t bytes);
+  static void recordFree();
+
+  // Functions that allocations are attributed to. Registering never
+  // allocates, at most maxFunctions names are kept.
+  static constexpr int maxFunctions = 32;
+  static int registerFunction(const char *name);
+  static int numberOfFunctions();
+  static const char *functionName(int function);
+  static Counts functionCounts(int function);
+
+  // Attribute the allocations of the calling thread to `function` while
+  // the scope lives.
+  class Scope {
+  public:
+    explicit Scope(int function);
+    ~Scope();
+
+  private:
+    int previous_;
+  };
+
+  // Allocations of the calling thread in a repeated period (one frame, one
+  // tetromino, ...): start() begins a period, stop() ends it.
+  class Meter {
+  public:
+    void start();
+    void stop();
+    // stop() and start() in one step, for periods that follow each other.
+    void mark();
+
+    long long getPeriods() const { return periods_; }
+    long long getAllocations() const { return allocations_; }
+    long long getMaxAllocations() const { return maxAllocations_; }
+    double averageAllocations() const;
+
+  private:
+    long long startAllocations_ = 0;
+    bool isRunning_ = false;
+    long long periods_ = 0;
+    long long allocations_ = 0;
+    long long maxAllocations_ = 0;
+  };
+
+  // Allocations of all registered functions that allocated.
+  static void printFunctions(std::ostream &out);
+
+private:
+  struct Function {
+    const char *name;
+    std::atomic<long long> allocations;
+    std::atomic<long long> bytes;
+  };
+  static Function functions_[maxFunctions];
+  static std::atomic<int> numberOfFunctions_;
+};
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+#define ALLOCATION_SCOPE(name)                                                 \
+  static const int allocationFunction_ =                                       \
+      AllocationTracker::registerFunction(name);                               \
+  AllocationTracker::Scope allocationScope_(allocationFunction_)
+#else
+#define ALLOCATION_SCOPE(name)
+#endif
@@ -0,0 +1,61 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Animations.h"
+#include <algorithm>
+
+void Animations::add(int durationMs, Update update, Finish finish) {
+  if (!isEnabled_) {
+    if (update) {
+      update(1.0);
+    }
+    if (finish) {
+      finish();
+    }
+    return;
+  }
+
+  Animation animation{now_, std::chrono::milliseconds(durationMs),
+                      std::move(update), std::move(finish)};
+  // Callbacks of running animations can add new ones, animations_ must not
+  // change while they run.
+  if (isTicking_) {
+    added_.push_back(std::move(animation));
+  } else {
+    animations_.push_back(std::move(animation));
+  }
+}
+
+void Animations::tick(Clock::time_point now) {
+  now_ = now;
+  for (auto &animation : added_) {
+    animations_.push_back(std::move(animation));
+  }
+  added_.clear();
+
+  isTicking_ = true;
+  for (auto &animation : animations_) {
+    double progress = 1.0;
+    if (animation.duration > Clock::duration::zero()) {
+      progress = std::chrono::duration<double>(now - animation.start) /
+                 animation.duration;
+      progress = std::clamp(progress, 0.0, 1.0);
+    }
+    if (animation.update) {
+      animation.update(progress);
+    }
+    if (progress >= 1.0) {
+      if (animation.finish) {
+        animation.finish();
+      }
+      animation.isDone = true;
+    }
+  }
+  isTicking_ = false;
+
+  animations_.erase(std::remove_if(animations_.begin(), animations_.end(),
+                                   [](const Animation &animation) {
+                                     return animation.isDone;
+                                   }),
+                    animations_.end());
+}
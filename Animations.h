@@ -0,0 +1,60 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#pragma once
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// Timed animations ("tweens") that run on the ticks of the game loop, so
+// drawing them never blocks the game. An animation gets its progress in
+// [0, 1] on every tick; the last call has progress 1, then it finishes.
+//
+// Time is the frame clock: the time of the last tick. An animation that is
+// added between two ticks starts at the last tick.
+class Animations {
+public:
+  using Clock = std::chrono::steady_clock;
+  using Update = std::function<void(double progress)>;
+  using Finish = std::function<void()>;
+
+  Animations() : now_(Clock::now()) {}
+
+  // `update` and `finish` may be empty. Both may add new animations (for
+  // example the next part of a sequence).
+  void add(int durationMs, Update update, Finish finish = nullptr);
+
+  // Advance all animations to `now`.
+  void tick(Clock::time_point now);
+
+  bool isRunning() const {
+    return !animations_.empty() || !added_.empty();
+  }
+
+  // Stop all animations without finishing them (not from a callback).
+  void clear() {
+    animations_.clear();
+    added_.clear();
+  }
+
+  // Disabled animations jump to their end (progress 1 and finish) right
+  // when they are added. For headless and benchmark runs.
+  void setEnabled(bool isEnabled) { isEnabled_ = isEnabled; }
+  bool isEnabled() const { return isEnabled_; }
+
+private:
+  struct Animation {
+    Clock::time_point start;
+    Clock::duration duration;
+    Update update;
+    Finish finish;
+    bool isDone = false;
+  };
+
+  std::vector<Animation> animations_;
+  // Animations added during tick(), they start with the next tick.
+  std::vector<Animation> added_;
+  bool isTicking_ = false;
+  bool isEnabled_ = true;
+  Clock::time_point now_;
+};
@@ -0,0 +1,59 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./AutoShift.h"
+#include <algorithm>
+
+AutoShift::AutoShift(int dasMs, int arrMs, int releaseMs)
+    : das_(std::chrono::milliseconds(dasMs)),
+      arr_(std::chrono::milliseconds(arrMs)),
+      release_(std::chrono::milliseconds(releaseMs)),
+      maxRepeatDelay_(std::chrono::milliseconds(maxRepeatDelayMs)) {}
+
+int AutoShift::press(int direction, Clock::time_point time) {
+  Clock::duration sinceLastEvent = time - lastEvent_;
+  bool isNewTap = direction != direction_ || time - firstPress_ < das_ ||
+                  sinceLastEvent > (isHeld_ ? release_ : maxRepeatDelay_);
+  lastEvent_ = time;
+  if (isNewTap) {
+    direction_ = direction;
+    isHeld_ = false;
+    firstPress_ = time;
+    return 1;
+  }
+  if (isHeld_) {
+    return 0;
+  }
+
+  // First repeat of the terminal: the key is held. The terminal repeats
+  // later than das, so move now and go on with arr from here instead of
+  // catching up all missed moves at once.
+  isHeld_ = true;
+  nextMove_ = std::max(firstPress_ + das_, time + arr_);
+  return 1;
+}
+
+int AutoShift::update(Clock::time_point now) {
+  if (direction_ == 0 || !isHeld_) {
+    return 0;
+  }
+  if (now - lastEvent_ > release_) {
+    direction_ = 0;
+    isHeld_ = false;
+    return 0;
+  }
+  if (now < nextMove_) {
+    return 0;
+  }
+
+  if (arr_ == Clock::duration::zero()) {
+    nextMove_ = now;
+    return maxMoves;
+  }
+  int moves = 0;
+  while (nextMove_ <= now && moves < maxMoves) {
+    moves += 1;
+    nextMove_ += arr_;
+  }
+  return moves;
+}
@@ -0,0 +1,64 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// DAS / ARR as in the Tetris guideline:
+// https://tetris.wiki/DAS
+//
+
+#pragma once
+#include <chrono>
+
+// Sideways auto repeat timed by the game instead of by the terminal.
+//
+// A key moves the tetromino once. If the key is still held after `das` ms
+// (delayed auto shift), the tetromino moves every `arr` ms (auto repeat
+// rate), with arr = 0 it moves to the wall at once.
+//
+// A terminal only sends key presses, never releases. A held key shows up
+// as the repeats of the terminal, which start after its own delay (usually
+// more than das) and come at its own rate. So a second key event before
+// das is over is a new tap, a later one (but not later than the longest
+// repeat delay) means the key is held, and the key counts as released when
+// the repeats stop for `release` ms. While the key is held, the repeats of
+// the terminal only keep it held, the moves come from update(). Two slow
+// taps in a row look like a held key, that can cost one extra move.
+class AutoShift {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  // 10 and 2 frames of 1/60 s.
+  static constexpr int defaultDasMs = 167;
+  static constexpr int defaultArrMs = 33;
+  // Longer than the repeat interval of common terminals (25 - 30 per s).
+  static constexpr int defaultReleaseMs = 60;
+  // Longest delay before a terminal starts repeating (X11 uses 660 ms).
+  static constexpr int maxRepeatDelayMs = 700;
+
+  AutoShift(int dasMs = defaultDasMs, int arrMs = defaultArrMs,
+            int releaseMs = defaultReleaseMs);
+
+  // Key event for `direction` (-1 left, 1 right) read at `time`.
+  // Returns the number of moves to do now.
+  int press(int direction, Clock::time_point time);
+
+  // Number of auto repeat moves that are due at `now`.
+  int update(Clock::time_point now);
+
+  // Direction of the held key, 0 if none.
+  int getDirection() const { return direction_; }
+
+  // Upper bound for the moves of one update() (enough to reach a wall).
+  static constexpr int maxMoves = 10;
+
+private:
+  Clock::duration das_;
+  Clock::duration arr_;
+  Clock::duration release_;
+  Clock::duration maxRepeatDelay_;
+
+  int direction_ = 0;
+  bool isHeld_ = false;
+  Clock::time_point firstPress_;
+  Clock::time_point lastEvent_;
+  Clock::time_point nextMove_;
+};
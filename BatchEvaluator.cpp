@@ -0,0 +1,250 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./BatchEvaluator.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TETRIS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int rows = BitBoard::rows;
+constexpr int cols = BitBoard::cols;
+
+// Row with a full wall on both sides (bit 0 and bit cols + 1).
+constexpr uint16_t walls = 1 | (1 << (cols + 1));
+constexpr uint16_t rowWithWallsMask = (1 << (cols + 1)) - 1;
+
+} // namespace
+
+BatchEvaluator::BatchEvaluator() : useAvx2_(hasAvx2()) {
+  std::memset(rows_, 0, sizeof(rows_));
+}
+
+bool BatchEvaluator::hasAvx2() {
+#ifdef TETRIS_X86_SIMD
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+int BatchEvaluator::add(const BitBoard &board) {
+  for (int i = 0; i < rows; i++) {
+    rows_[i][count_] = board.getRow(i);
+  }
+  count_ += 1;
+  return count_ - 1;
+}
+
+void BatchEvaluator::computeFeatures(double *features) const {
+  const int numberOfFeatures = EvaluationWeights::numberOfFeatures;
+  for (int block = 0; block * lanes < count_; block++) {
+    BlockFeatures blockFeatures;
+    if (useAvx2_) {
+      computeBlockAvx2(block, &blockFeatures);
+    } else {
+      computeBlockScalar(block, &blockFeatures);
+    }
+
+    int lastLane = std::min(lanes, count_ - block * lanes);
+    for (int lane = 0; lane < lastLane; lane++) {
+      double *boardFeatures =
+          features + (block * lanes + lane) * numberOfFeatures;
+      for (int f = 0; f < numberOfFeatures; f++) {
+        boardFeatures[f] = blockFeatures.values[f][lane];
+      }
+    }
+  }
+}
+
+void BatchEvaluator::evaluate(const EvaluationWeights &weights,
+                              double *values) const {
+  const int numberOfFeatures = EvaluationWeights::numberOfFeatures;
+  double features[maxBoards * numberOfFeatures];
+  computeFeatures(features);
+
+  // Same order of additions as TetrisBot::evaluateBoard,
+  // so the values are exactly the same.
+  for (int i = 0; i < count_; i++) {
+    double score = 0;
+    for (int f = 0; f < numberOfFeatures; f++) {
+      score += weights.values[f] * features[i * numberOfFeatures + f];
+    }
+    values[i] = score;
+  }
+}
+
+void BatchEvaluator::computeBlockScalar(int block,
+                                        BlockFeatures *features) const {
+  for (int lane = 0; lane < lanes; lane++) {
+    int board = block * lanes + lane;
+
+    int heights[cols] = {};
+    int cells = 0;
+    int rowTransitions = 0;
+    int columnTransitions = 0;
+    uint16_t seen = 0;
+    uint16_t previous = 0;
+
+    for (int i = 0; i < rows; i++) {
+      uint16_t row = rows_[i][board];
+      seen |= row;
+      for (int j = 0; j < cols; j++) {
+        heights[j] += (seen >> j) & 1;
+      }
+      cells += __builtin_popcount(row);
+      columnTransitions += __builtin_popcount(seen & (row ^ previous));
+      if (seen != 0) {
+        uint16_t withWalls = (row << 1) | walls;
+        rowTransitions += __builtin_popcount((withWalls ^ (withWalls >> 1)) &
+                                             rowWithWallsMask);
+      }
+      previous = row;
+    }
+    // The floor is full.
+    columnTransitions += __builtin_popcount(seen & ~previous);
+
+    int aggregateHeight = 0;
+    int maxHeight = 0;
+    int bumpiness = 0;
+    int wells = 0;
+    for (int j = 0; j < cols; j++) {
+      aggregateHeight += heights[j];
+      maxHeight = std::max(maxHeight, heights[j]);
+      if (j + 1 < cols) {
+        bumpiness += std::abs(heights[j] - heights[j + 1]);
+      }
+      int left = j == 0 ? rows : heights[j - 1];
+      int right = j == cols - 1 ? rows : heights[j + 1];
+      int depth = std::max(0, std::min(left, right) - heights[j]);
+      wells += depth * (depth + 1) / 2;
+    }
+
+    features->values[(int)Feature::AggregateHeight][lane] = aggregateHeight;
+    // Every empty cell below the top of its column is a hole.
+    features->values[(int)Feature::Holes][lane] = aggregateHeight - cells;
+    features->values[(int)Feature::Bumpiness][lane] = bumpiness;
+    features->values[(int)Feature::RemovedRows][lane] = 0;
+    features->values[(int)Feature::Wells][lane] = wells;
+    features->values[(int)Feature::RowTransitions][lane] = rowTransitions;
+    features->values[(int)Feature::ColumnTransitions][lane] =
+        columnTransitions;
+    features->values[(int)Feature::MaxHeight][lane] = maxHeight;
+  }
+}
+
+#ifdef TETRIS_X86_SIMD
+
+namespace {
+
+// Number of set bits in every 16 bit lane.
+__attribute__((target("avx2"))) __m256i popcount16(__m256i v) {
+  const __m256i table = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2,
+                                         3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1, 2,
+                                         2, 3, 2, 3, 3, 4);
+  const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+  __m256i low = _mm256_and_si256(v, lowNibble);
+  __m256i high = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble);
+  __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+                                  _mm256_shuffle_epi8(table, high));
+  // Add the two bytes of every lane.
+  return _mm256_maddubs_epi16(bytes, _mm256_set1_epi8(1));
+}
+
+} // namespace
+
+__attribute__((target("avx2"))) void
+BatchEvaluator::computeBlockAvx2(int block, BlockFeatures *features) const {
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i wallBits = _mm256_set1_epi16(walls);
+  const __m256i wallMask = _mm256_set1_epi16(rowWithWallsMask);
+
+  __m256i heights[cols];
+  for (int j = 0; j < cols; j++) {
+    heights[j] = zero;
+  }
+  __m256i cells = zero;
+  __m256i rowTransitions = zero;
+  __m256i columnTransitions = zero;
+  __m256i seen = zero;
+  __m256i previous = zero;
+
+  for (int i = 0; i < rows; i++) {
+    __m256i row = _mm256_load_si256(
+        reinterpret_cast<const __m256i *>(&rows_[i][block * lanes]));
+    seen = _mm256_or_si256(seen, row);
+    for (int j = 0; j < cols; j++) {
+      heights[j] = _mm256_add_epi16(
+          heights[j], _mm256_and_si256(_mm256_srli_epi16(seen, j), one));
+    }
+    cells = _mm256_add_epi16(cells, popcount16(row));
+    columnTransitions = _mm256_add_epi16(
+        columnTransitions,
+        popcount16(_mm256_and_si256(seen, _mm256_xor_si256(row, previous))));
+
+    // Only rows at or below the highest cell count.
+    __m256i withWalls = _mm256_or_si256(_mm256_slli_epi16(row, 1), wallBits);
+    __m256i changes = _mm256_and_si256(
+        _mm256_xor_si256(withWalls, _mm256_srli_epi16(withWalls, 1)),
+        wallMask);
+    __m256i isEmpty = _mm256_cmpeq_epi16(seen, zero);
+    rowTransitions = _mm256_add_epi16(
+        rowTransitions, _mm256_andnot_si256(isEmpty, popcount16(changes)));
+    previous = row;
+  }
+  columnTransitions = _mm256_add_epi16(
+      columnTransitions, popcount16(_mm256_andnot_si256(previous, seen)));
+
+  const __m256i fullColumn = _mm256_set1_epi16(rows);
+  __m256i aggregateHeight = zero;
+  __m256i maxHeight = zero;
+  __m256i bumpiness = zero;
+  __m256i wells = zero;
+  for (int j = 0; j < cols; j++) {
+    aggregateHeight = _mm256_add_epi16(aggregateHeight, heights[j]);
+    maxHeight = _mm256_max_epi16(maxHeight, heights[j]);
+    if (j + 1 < cols) {
+      bumpiness = _mm256_add_epi16(
+          bumpiness,
+          _mm256_abs_epi16(_mm256_sub_epi16(heights[j], heights[j + 1])));
+    }
+    __m256i left = j == 0 ? fullColumn : heights[j - 1];
+    __m256i right = j == cols - 1 ? fullColumn : heights[j + 1];
+    __m256i depth = _mm256_max_epi16(
+        zero, _mm256_sub_epi16(_mm256_min_epi16(left, right), heights[j]));
+    // depth * (depth + 1) / 2
+    wells = _mm256_add_epi16(
+        wells, _mm256_srli_epi16(
+                   _mm256_mullo_epi16(depth, _mm256_add_epi16(depth, one)), 1));
+  }
+
+  __m256i values[EvaluationWeights::numberOfFeatures];
+  values[(int)Feature::AggregateHeight] = aggregateHeight;
+  values[(int)Feature::Holes] = _mm256_sub_epi16(aggregateHeight, cells);
+  values[(int)Feature::Bumpiness] = bumpiness;
+  values[(int)Feature::RemovedRows] = zero;
+  values[(int)Feature::Wells] = wells;
+  values[(int)Feature::RowTransitions] = rowTransitions;
+  values[(int)Feature::ColumnTransitions] = columnTransitions;
+  values[(int)Feature::MaxHeight] = maxHeight;
+  for (int f = 0; f < EvaluationWeights::numberOfFeatures; f++) {
+    _mm256_store_si256(reinterpret_cast<__m256i *>(features->values[f]),
+                       values[f]);
+  }
+}
+
+#else
+
+void BatchEvaluator::computeBlockAvx2(int block,
+                                      BlockFeatures *features) const {
+  computeBlockScalar(block, features);
+}
+
+#endif
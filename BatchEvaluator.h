@@ -0,0 +1,56 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Counting bits with a lookup table in vector registers ("pshufb" trick):
+// http://0x80.pl/articles/sse-popcount.html
+//
+
+#pragma once
+#include "./BitBoard.h"
+#include "./TetrisBot.h"
+#include <cstdint>
+
+// Evaluates all candidate boards of one tetromino in one pass. The boards
+// are packed like in SimdBoards (row r of all candidates next to each
+// other), and the features of TetrisBot::computeFeatures are computed for
+// 16 candidates at once with AVX2, or with plain loops without AVX2.
+//
+// Everything is computed from a top-down pass over the rows: "seen" is the
+// OR of all rows so far, so bit j of seen is set from the highest cell of
+// column j downwards. Column heights, holes (seen but empty), transitions
+// and wells follow from that without looking at single cells.
+class BatchEvaluator {
+public:
+  static constexpr int lanes = 16;
+  static constexpr int maxBoards = BitBoard::maxPlacements;
+
+  BatchEvaluator();
+
+  void clear() { count_ = 0; }
+  // Add a board, returns its index (at most maxBoards boards).
+  int add(const BitBoard &board);
+  int size() const { return count_; }
+
+  // Features of all boards, `features` gets numberOfFeatures values per
+  // board. RemovedRows is always 0, it depends on the move.
+  void computeFeatures(double *features) const;
+
+  // Same value as TetrisBot::evaluateBoard for every board.
+  void evaluate(const EvaluationWeights &weights, double *values) const;
+
+  static bool hasAvx2();
+  bool isUsingAvx2() const { return useAvx2_; }
+  void setUseAvx2(bool useAvx2) { useAvx2_ = useAvx2 && hasAvx2(); }
+
+private:
+  // Features of one block of 16 boards, one 16 bit value per board.
+  struct BlockFeatures {
+    alignas(32) int16_t values[EvaluationWeights::numberOfFeatures][lanes];
+  };
+  void computeBlockScalar(int block, BlockFeatures *features) const;
+  void computeBlockAvx2(int block, BlockFeatures *features) const;
+
+  alignas(32) uint16_t rows_[BitBoard::rows][maxBoards];
+  int count_ = 0;
+  bool useAvx2_;
+};
@@ -0,0 +1,349 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./BitBoard.h"
+#include "./Tetromino.h"
+#include "./Zobrist.h"
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+// All orientations of all tetrominos.
+struct OrientationTable {
+  OrientationTable();
+  Orientation orientations[7][4];
+  int count[7];
+};
+
+// Shape without position, used to find duplicated orientations
+// (for example S has only two different ones).
+std::vector<Point> normalizedShape(const Orientation &orientation) {
+  int minRow = *std::min_element(orientation.rows, orientation.rows + 4);
+  std::vector<Point> shape;
+  for (int i = 0; i < 4; i++) {
+    shape.push_back(Point{orientation.rows[i] - minRow,
+                          orientation.cols[i] - orientation.minCol,
+                          NamedColors::BLACK});
+  }
+  std::sort(shape.begin(), shape.end());
+  return shape;
+}
+
+OrientationTable::OrientationTable() {
+  for (int piece = 0; piece < 7; piece++) {
+    count[piece] = 0;
+    std::vector<std::vector<Point>> seenShapes;
+
+    // Rotate a real tetromino to the right, like the player would do,
+    // and remember every new shape.
+    NewAbstractTetromino *tetromino = TetrominoFactory::create(piece);
+    for (int rotations = 0; rotations < 4; rotations++) {
+      Orientation orientation;
+      orientation.rotations = rotations;
+
+      std::vector<Point> location = tetromino->getCurrentLocation();
+      for (int i = 0; i < 4; i++) {
+        orientation.rows[i] = location[i].row - BitBoard::firstRow;
+        orientation.cols[i] = location[i].col - BitBoard::firstCol;
+      }
+      orientation.minCol =
+          *std::min_element(orientation.cols, orientation.cols + 4);
+      orientation.maxCol =
+          *std::max_element(orientation.cols, orientation.cols + 4);
+      int minRow = *std::min_element(orientation.rows, orientation.rows + 4);
+      orientation.startRow = std::max(0, -minRow);
+
+      std::vector<Point> shape = normalizedShape(orientation);
+      if (std::find(seenShapes.begin(), seenShapes.end(), shape) ==
+          seenShapes.end()) {
+        seenShapes.push_back(shape);
+        orientations[piece][count[piece]] = orientation;
+        count[piece] += 1;
+      }
+
+      tetromino->rotate(false);
+    }
+    delete tetromino;
+  }
+}
+
+const OrientationTable &orientationTable() {
+  static const OrientationTable table;
+  return table;
+}
+
+} // namespace
+
+BitBoard::BitBoard() : hash_(0) {
+  for (int i = 0; i < rows; i++) {
+    rows_[i] = 0;
+  }
+  for (int j = 0; j < cols; j++) {
+    columns_[j] = 0;
+  }
+}
+
+bool BitBoard::isOccupied(int row, int col) const {
+  if (row < 0 || row >= rows || col < 0 || col >= cols) {
+    return false;
+  }
+  return (rows_[row] >> col) & 1;
+}
+
+bool BitBoard::setCell(int row, int col) {
+  if (row < 0 || row >= rows || col < 0 || col >= cols ||
+      isOccupied(row, col)) {
+    return false;
+  }
+  rows_[row] |= 1 << col;
+  columns_[col] |= 1u << row;
+  hash_ ^= Zobrist::cellKey(row, col);
+  return true;
+}
+
+bool BitBoard::isEmpty() const {
+  for (int i = 0; i < rows; i++) {
+    if (rows_[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int BitBoard::columnHeight(int col) const {
+  if (columns_[col] == 0) {
+    return 0;
+  }
+  return rows - __builtin_ctz(columns_[col]);
+}
+
+int BitBoard::numberOfOrientations(int piece) {
+  return orientationTable().count[piece];
+}
+
+const Orientation &BitBoard::getOrientation(int piece, int orientation) {
+  return orientationTable().orientations[piece][orientation];
+}
+
+bool BitBoard::collides(int piece, int orientation, int rowShift,
+                        int colShift) const {
+  const Orientation &o = getOrientation(piece, orientation);
+  for (int i = 0; i < 4; i++) {
+    int row = o.rows[i] + rowShift;
+    int col = o.cols[i] + colShift;
+
+    if (col < 0 || col >= cols || row >= rows) {
+      return true;
+    }
+    if (row >= 0 && ((rows_[row] >> col) & 1)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int BitBoard::generatePlacements(int piece, Placement *placements) const {
+  int count = 0;
+
+  for (int o = 0; o < numberOfOrientations(piece); o++) {
+    // If the rotation itself is blocked, the game would undo it.
+    // The same holds for moving down into the field.
+    int startRow = getOrientation(piece, o).startRow;
+    bool isBlocked = false;
+    for (int row = 0; row <= startRow; row++) {
+      isBlocked = isBlocked || collides(piece, o, row, 0);
+    }
+    if (isBlocked) {
+      continue;
+    }
+
+    // Move to the left as far as possible, then to the right. The game
+    // moves the tetromino one column at a time, so we stop at the first
+    // blocked column.
+    int leftmost = 0;
+    while (!collides(piece, o, startRow, leftmost - 1)) {
+      leftmost -= 1;
+    }
+    int rightmost = 0;
+    while (!collides(piece, o, startRow, rightmost + 1)) {
+      rightmost += 1;
+    }
+
+    for (int shift = leftmost; shift <= rightmost; shift++) {
+      int drop = startRow;
+      while (!collides(piece, o, drop + 1, shift)) {
+        drop += 1;
+      }
+      placements[count] = Placement{piece, o, shift, drop};
+      count += 1;
+    }
+  }
+
+  return count;
+}
+
+int BitBoard::apply(const Placement &placement) {
+  return apply(placement, nullptr);
+}
+
+int BitBoard::apply(const Placement &placement, BoardUndo *undo) {
+  const Orientation &o = getOrientation(placement.piece, placement.orientation);
+  bool isGameOver = false;
+  uint32_t placedCells = 0;
+  uint64_t hash = hash_;
+
+  for (int i = 0; i < 4; i++) {
+    int row = o.rows[i] + placement.dropRows;
+    int col = o.cols[i] + placement.shift;
+    // Same rule as placeTetromino: touching the spawn row is game over.
+    if (row <= 0) {
+      isGameOver = true;
+    }
+    if (setCell(row, col)) {
+      placedCells |= 1u << i;
+    }
+  }
+
+  if (undo != nullptr) {
+    undo->placement = placement;
+    undo->placedCells = placedCells;
+    undo->removedRows = fullRows();
+    undo->hash = hash;
+  }
+  int removedRows = clearFullRows();
+  return isGameOver ? -1 : removedRows;
+}
+
+void BitBoard::undo(const BoardUndo &undo) {
+  if (undo.removedRows != 0) {
+    // Row i was moved down by the removed rows below it. Going from the
+    // top down, every row is read before it is written.
+    for (int i = 0; i < rows; i++) {
+      if ((undo.removedRows >> i) & 1) {
+        rows_[i] = fullRow;
+      } else {
+        int moved = __builtin_popcount(undo.removedRows >> i);
+        rows_[i] = rows_[i + moved];
+      }
+    }
+
+    // Inverse of clearFullRows, the lowest removed row first: the rows
+    // above it move one row up again.
+    for (uint32_t removed = undo.removedRows; removed != 0;) {
+      uint32_t row = 1u << (31 - __builtin_clz(removed));
+      uint32_t above = row - 1;
+      for (int j = 0; j < cols; j++) {
+        columns_[j] = ((columns_[j] >> 1) & above) |
+                      (columns_[j] & ~(above | row)) | row;
+      }
+      removed &= ~row;
+    }
+  }
+
+  const Orientation &o =
+      getOrientation(undo.placement.piece, undo.placement.orientation);
+  for (int i = 0; i < 4; i++) {
+    if ((undo.placedCells >> i) & 1) {
+      int row = o.rows[i] + undo.placement.dropRows;
+      int col = o.cols[i] + undo.placement.shift;
+      rows_[row] &= ~(1 << col);
+      columns_[col] &= ~(1u << row);
+    }
+  }
+  hash_ = undo.hash;
+}
+
+uint32_t BitBoard::fullRows() const {
+  // A row is full if its bit is set in every column.
+  uint32_t full = columns_[0];
+  for (int j = 1; j < cols; j++) {
+    full &= columns_[j];
+  }
+  return full;
+}
+
+int BitBoard::clearFullRows() {
+  uint32_t fullRows = this->fullRows();
+  if (fullRows == 0) {
+    return 0;
+  }
+
+  // Remove the full rows from the columns, from the top down: the rows
+  // above a removed row move one row down, the rows below stay.
+  for (uint32_t full = fullRows; full != 0; full &= full - 1) {
+    uint32_t row = full & -full;
+    uint32_t above = row - 1;
+    for (int j = 0; j < cols; j++) {
+      columns_[j] = ((columns_[j] & above) << 1) |
+                    (columns_[j] & ~(above | row));
+    }
+  }
+
+  int removedRows = 0;
+  int target = rows - 1;
+
+  // Copy every row that is not full to the lowest free position.
+  for (int i = rows - 1; i >= 0; i--) {
+    if (rows_[i] == fullRow) {
+      removedRows += 1;
+      continue;
+    }
+    rows_[target] = rows_[i];
+    target -= 1;
+  }
+
+  for (int i = target; i >= 0; i--) {
+    rows_[i] = 0;
+  }
+
+  // Almost every cell moved, so recompute the hash.
+  recomputeHash();
+  return removedRows;
+}
+
+bool BitBoard::addGarbage(int count, int holeCol) {
+  count = std::min(count, (int)rows);
+  if (count <= 0) {
+    return true;
+  }
+  bool isOverflowing = false;
+  for (int i = 0; i < count; i++) {
+    isOverflowing = isOverflowing || rows_[i] != 0;
+  }
+
+  uint16_t garbageRow = fullRow & ~(1 << holeCol);
+  for (int i = 0; i < rows; i++) {
+    rows_[i] = i + count < rows ? rows_[i + count] : garbageRow;
+  }
+  uint32_t garbageColumn = ((1u << count) - 1) << (rows - count);
+  for (int j = 0; j < cols; j++) {
+    columns_[j] >>= count;
+    if (j != holeCol) {
+      columns_[j] |= garbageColumn;
+    }
+  }
+
+  recomputeHash();
+  return !isOverflowing;
+}
+
+void BitBoard::recomputeHash() {
+  hash_ = 0;
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      if ((rows_[i] >> j) & 1) {
+        hash_ ^= Zobrist::cellKey(i, j);
+      }
+    }
+  }
+}
+
+bool BitBoard::operator==(const BitBoard &other) const {
+  for (int i = 0; i < rows; i++) {
+    if (rows_[i] != other.rows_[i]) {
+      return false;
+    }
+  }
+  return true;
+}
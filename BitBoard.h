@@ -0,0 +1,132 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#pragma once
+#include <cstdint>
+
+// One way a tetromino can be turned. Cells are stored in board coordinates
+// (see BitBoard) for a tetromino that has just spawned and was rotated
+// `rotations` times to the right. Because rotation and movement in the game
+// are translation invariant, the cells of a moved tetromino are these cells
+// plus the movement.
+//
+// Rotating at the spawn row can put cells above the roof. The game doesn't
+// undo that, but moving sideways from there is not checked properly, so the
+// tetromino is first moved down `startRow` rows until it is fully inside
+// the field and only then moved sideways.
+struct Orientation {
+  int rotations;
+  int rows[4];
+  int cols[4];
+  int minCol;
+  int maxCol;
+  int startRow;
+};
+
+// A final position of a tetromino: turn it into `orientation`, move it by
+// `shift` columns (negative means to the left) and let it fall `dropRows`
+// rows down.
+struct Placement {
+  int piece;
+  int orientation;
+  int shift;
+  int dropRows;
+};
+
+// What BitBoard::apply changed, so that BitBoard::undo can take it back
+// without a copy of the board.
+struct BoardUndo {
+  Placement placement;
+  // Bit i: cell i of the orientation was set (cells above the roof and
+  // cells that were occupied already are not).
+  uint32_t placedCells;
+  // Bit i: row i was full and removed (rows before the removal).
+  uint32_t removedRows;
+  // Hash before the placement.
+  uint64_t hash;
+};
+
+// Compact representation of the game field for headless games and the bot.
+// Every row is a 16 bit word, bit j is column j. Row 0 is the spawn row
+// (offset_row + 1 in AbstractTetrisGame) and column 0 is the first column
+// to the right of the left wall (offset_col + 1). Walls, roof and floor
+// are not stored.
+//
+// The same cells are also kept column by column: bit i of a column mask is
+// row i, so the highest cell of a column is its lowest set bit and a
+// column height is one count of trailing zeros.
+class BitBoard {
+public:
+  static constexpr int rows = 20;
+  static constexpr int cols = 10;
+  static constexpr uint16_t fullRow = (1 << cols) - 1;
+
+  // Screen coordinates of board cell (0, 0).
+  static constexpr int firstRow = 15;
+  static constexpr int firstCol = 41;
+
+  // Upper bound for the number of placements of one tetromino.
+  static constexpr int maxPlacements = 48;
+
+  BitBoard();
+
+  // Cells.
+  bool isOccupied(int row, int col) const;
+  // Returns false if the cell is outside of the board or occupied already.
+  bool setCell(int row, int col);
+  uint16_t getRow(int row) const { return rows_[row]; }
+  uint32_t getColumn(int col) const { return columns_[col]; }
+  bool isEmpty() const;
+  int columnHeight(int col) const;
+
+  // Zobrist hash of the occupied cells (same keys as AbstractTetrisGame,
+  // so a BitBoard made from a game field has the same hash).
+  uint64_t getHash() const { return hash_; }
+
+  // Orientations of the tetromino with the given index (I, J, L, O, S, Z, T).
+  // They are computed once from the Tetromino classes, so the bot uses
+  // exactly the same rotation rules as the game.
+  static int numberOfOrientations(int piece);
+  static const Orientation &getOrientation(int piece, int orientation);
+
+  // Check if a tetromino in the given orientation, moved by rowShift rows
+  // and colShift columns from its spawn position, hits a wall, the floor
+  // or an occupied cell. Cells above the spawn row are always free.
+  bool collides(int piece, int orientation, int rowShift, int colShift) const;
+
+  // Write all placements that can be reached from the spawn position
+  // (rotate first, then move down to startRow, then move sideways, then
+  // fall) into `placements`, which must have room for maxPlacements
+  // elements. Returns their number.
+  int generatePlacements(int piece, Placement *placements) const;
+
+  // Put the tetromino on the board and remove full rows.
+  // Returns the number of removed rows, or -1 if the tetromino was placed
+  // on the spawn row (game over).
+  int apply(const Placement &placement);
+  // The same, and write into `undo` what changed.
+  int apply(const Placement &placement, BoardUndo *undo);
+  // Take back the last apply (or the last one that isn't undone yet):
+  // put the removed rows back and remove the tetromino.
+  void undo(const BoardUndo &undo);
+
+  // Remove full rows and let everything above fall down.
+  int clearFullRows();
+
+  // Push everything up by `count` rows and fill the bottom rows except
+  // column `holeCol` (garbage in versus games). Returns false if occupied
+  // cells were pushed out at the top.
+  bool addGarbage(int count, int holeCol);
+
+  bool operator==(const BitBoard &other) const;
+
+private:
+  // Bit i: row i is full.
+  uint32_t fullRows() const;
+  // After almost every cell moved.
+  void recomputeHash();
+
+  uint16_t rows_[rows];
+  uint32_t columns_[cols];
+  uint64_t hash_;
+};
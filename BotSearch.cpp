@@ -0,0 +1,254 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./BotSearch.h"
+#include "./Zobrist.h"
+#include <algorithm>
+
+BotSearch::BotSearch(const EvaluationWeights &weights,
+                     TranspositionTable *table)
+    : bot_(weights), table_(table) {}
+
+BotSearch::~BotSearch() { stopThread(); }
+
+void BotSearch::stopThread() {
+  stop_.store(true);
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+std::unique_ptr<BotSearch::BoardNode>
+BotSearch::createNode(const BitBoard &board, bool isGameOver,
+                      double staticValue) {
+  auto node = std::make_unique<BoardNode>();
+  node->board = board;
+  node->isGameOver = isGameOver;
+  node->staticValue = isGameOver ? TetrisBot::gameOverScore : staticValue;
+  createdNodes_ += 1;
+  return node;
+}
+
+BotSearch::PieceBranch *BotSearch::expand(BoardNode *node, int piece) {
+  if (node->branches[piece] != nullptr) {
+    return node->branches[piece].get();
+  }
+
+  auto branch = std::make_unique<PieceBranch>();
+  Placement placements[BitBoard::maxPlacements];
+  int count = node->board.generatePlacements(piece, placements);
+  double rowWeight = bot_.getWeights()[Feature::RemovedRows];
+
+  BitBoard children[BitBoard::maxPlacements];
+  int removedRows[BitBoard::maxPlacements];
+  batch_.clear();
+  for (int i = 0; i < count; i++) {
+    children[i] = node->board;
+    removedRows[i] = children[i].apply(placements[i]);
+    batch_.add(children[i]);
+  }
+  double values[BatchEvaluator::maxBoards];
+  batch_.evaluate(bot_.getWeights(), values);
+
+  for (int i = 0; i < count; i++) {
+    branch->placements.push_back(placements[i]);
+    branch->rowsValue.push_back(rowWeight * std::max(0, removedRows[i]));
+    branch->children.push_back(
+        createNode(children[i], removedRows[i] == -1, values[i]));
+    branch->order.push_back(i);
+  }
+
+  // Look at the most promising placements first, they are the ones
+  // that get searched deeper.
+  PieceBranch *b = branch.get();
+  std::stable_sort(b->order.begin(), b->order.end(), [b](int x, int y) {
+    return b->rowsValue[x] + b->children[x]->staticValue >
+           b->rowsValue[y] + b->children[y]->staticValue;
+  });
+
+  node->branches[piece] = std::move(branch);
+  return b;
+}
+
+bool BotSearch::shouldStop() const {
+  // The first iteration always finishes, we need at least some answer.
+  if (completedDepth_.load(std::memory_order_relaxed) == 0) {
+    return false;
+  }
+  return stop_.load(std::memory_order_relaxed) || createdNodes_ >= maxNodes_ ||
+         std::chrono::steady_clock::now() >= deadline_;
+}
+
+double BotSearch::valueOfBoard(BoardNode *node, int next, int depth) {
+  if (next != -1) {
+    return valueOfPiece(node, next, -1, depth, false, nullptr);
+  }
+
+  // Unknown tetromino: average over all of them.
+  double sum = 0;
+  for (int piece = 0; piece < 7; piece++) {
+    sum += valueOfPiece(node, piece, -1, depth, false, nullptr);
+    if (shouldStop()) {
+      break;
+    }
+  }
+  return sum / 7;
+}
+
+double BotSearch::valueOfPiece(BoardNode *node, int piece, int next,
+                               int depth, bool isRoot, int *bestIndex) {
+  uint64_t hash = node->board.getHash() ^ Zobrist::pieceKey(piece) ^
+                  Zobrist::previewKey(next);
+
+  // Many different orders of placements lead to the same board.
+  TranspositionEntry entry;
+  if (!isRoot && table_ != nullptr && table_->probe(hash, &entry) &&
+      entry.depth >= depth) {
+    return entry.score;
+  }
+
+  PieceBranch *branch = expand(node, piece);
+  double bestValue = TetrisBot::gameOverScore;
+  int best = -1;
+
+  for (size_t k = 0; k < branch->order.size(); k++) {
+    int i = branch->order[k];
+    BoardNode *child = branch->children[i].get();
+
+    double value;
+    if (child->isGameOver) {
+      value = TetrisBot::gameOverScore;
+    } else if (depth == 1 || (!isRoot && (int)k >= beamWidth_)) {
+      value = branch->rowsValue[i] + child->staticValue;
+    } else {
+      value = branch->rowsValue[i] + valueOfBoard(child, next, depth - 1);
+    }
+
+    if (best == -1 || value > bestValue) {
+      bestValue = value;
+      best = i;
+    }
+
+    // Unfinished values are useless, the caller throws them away.
+    if (shouldStop()) {
+      return bestValue;
+    }
+  }
+
+  if (table_ != nullptr && !isRoot) {
+    table_->store(hash, bestValue, depth, best);
+  }
+  if (bestIndex != nullptr) {
+    *bestIndex = best;
+  }
+  return bestValue;
+}
+
+void BotSearch::run(std::chrono::steady_clock::time_point deadline,
+                    int maxDepth) {
+  deadline_ = deadline;
+
+  for (int depth = 1; depth <= maxDepth; depth++) {
+    int bestIndex = -1;
+    valueOfPiece(root_.get(), current_, next_, depth, true, &bestIndex);
+
+    if (depth > 1 && shouldStop()) {
+      break;
+    }
+
+    if (bestIndex != -1) {
+      std::lock_guard<std::mutex> lock(bestMutex_);
+      bestPlacement_ = root_->branches[current_]->placements[bestIndex];
+      hasBest_ = true;
+    }
+    completedDepth_.store(depth);
+
+    if (createdNodes_ >= maxNodes_) {
+      break;
+    }
+  }
+
+  isFinished_.store(true);
+}
+
+std::unique_ptr<BotSearch::BoardNode>
+BotSearch::takeSubtree(const BitBoard &board) {
+  if (root_ == nullptr || root_->branches[current_] == nullptr) {
+    return nullptr;
+  }
+
+  // The board after the placed tetromino is one of the children of the
+  // current tetromino's branch (unless the player did something else).
+  for (auto &child : root_->branches[current_]->children) {
+    if (!child->isGameOver && child->board.getHash() == board.getHash() &&
+        child->board == board) {
+      return std::move(child);
+    }
+  }
+  return nullptr;
+}
+
+long long BotSearch::countNodes(const BoardNode *node) {
+  long long count = 1;
+  for (const auto &branch : node->branches) {
+    if (branch == nullptr) {
+      continue;
+    }
+    for (const auto &child : branch->children) {
+      count += countNodes(child.get());
+    }
+  }
+  return count;
+}
+
+void BotSearch::prepare(const BitBoard &board, int current, int next) {
+  stopThread();
+
+  // Everything else of the old tree is freed here.
+  std::unique_ptr<BoardNode> subtree = takeSubtree(board);
+  if (subtree != nullptr) {
+    reusedNodes_ = countNodes(subtree.get());
+    root_ = std::move(subtree);
+  } else {
+    reusedNodes_ = 0;
+    root_ = createNode(board, false, bot_.evaluateBoard(board));
+  }
+  current_ = current;
+  next_ = next;
+  createdNodes_ = 0;
+  hasBest_ = false;
+  completedDepth_.store(0);
+  isFinished_.store(false);
+  stop_.store(false);
+  if (table_ != nullptr) {
+    table_->newGeneration();
+  }
+}
+
+void BotSearch::start(const BitBoard &board, int current, int next) {
+  prepare(board, current, next);
+
+  // No deadline, commit() stops the search.
+  thread_ = std::thread([this]() {
+    run(std::chrono::steady_clock::time_point::max(), maxDepth_);
+  });
+}
+
+bool BotSearch::commit(Placement *best) {
+  stopThread();
+
+  std::lock_guard<std::mutex> lock(bestMutex_);
+  if (hasBest_) {
+    *best = bestPlacement_;
+  }
+  return hasBest_;
+}
+
+bool BotSearch::search(const BitBoard &board, int current, int next,
+                       std::chrono::steady_clock::time_point deadline,
+                       int maxDepth, Placement *best) {
+  prepare(board, current, next);
+
+  run(deadline, maxDepth);
+  return commit(best);
+}
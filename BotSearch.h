@@ -0,0 +1,142 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Expectimax and iterative deepening:
+// https://en.wikipedia.org/wiki/Expectiminimax
+// https://www.chessprogramming.org/Iterative_Deepening
+//
+
+#pragma once
+#include "./BatchEvaluator.h"
+#include "./BitBoard.h"
+#include "./TetrisBot.h"
+#include "./TranspositionTable.h"
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Anytime search for the bot. The search looks one tetromino deeper in
+// every iteration: first only the current tetromino, then also the next
+// one (known from the preview box), then every possible tetromino after
+// that (average over all seven). It can be stopped at any time and then
+// answers with the best placement of the last finished iteration.
+//
+// Only the most promising placements of every tetromino (beam) are looked
+// at in more depth, the others keep their static evaluation.
+//
+// The tree is kept between tetrominos: if the new board is one of the
+// boards the last search already looked at (usually the one of the chosen
+// placement), its subtree becomes the new root and its expanded placements
+// are not computed again.
+class BotSearch {
+public:
+  BotSearch(const EvaluationWeights &weights, TranspositionTable *table);
+  ~BotSearch();
+
+  // Start searching in a background thread (pondering).
+  void start(const BitBoard &board, int current, int next);
+
+  // Stop the background search and return the best placement found so far.
+  // Returns false if there is no possible placement.
+  bool commit(Placement *best);
+
+  // True if the background search can't go any deeper.
+  bool isFinished() const { return isFinished_.load(); }
+
+  // Search in the calling thread until the deadline or maxDepth.
+  bool search(const BitBoard &board, int current, int next,
+              std::chrono::steady_clock::time_point deadline, int maxDepth,
+              Placement *best);
+
+  // Statistics of the last search.
+  int getCompletedDepth() const { return completedDepth_.load(); }
+  long long getCreatedNodes() const { return createdNodes_; }
+  // Nodes taken over from the previous search.
+  long long getReusedNodes() const { return reusedNodes_; }
+
+  // Settings
+  void setBeamWidth(int beamWidth) { beamWidth_ = beamWidth; }
+  void setMaxDepth(int maxDepth) { maxDepth_ = maxDepth; }
+  void setMaxNodes(long long maxNodes) { maxNodes_ = maxNodes; }
+
+private:
+  struct PieceBranch;
+
+  // A board that waits for the next tetromino.
+  struct BoardNode {
+    BitBoard board;
+    // Evaluation of the board itself.
+    double staticValue;
+    // True if the placement that lead to this board ended the game.
+    bool isGameOver;
+    // Placements of each of the seven tetrominos (created when needed).
+    std::unique_ptr<PieceBranch> branches[7];
+  };
+
+  // All placements of one tetromino on a board.
+  struct PieceBranch {
+    std::vector<Placement> placements;
+    // Value of the removed rows of each placement.
+    std::vector<double> rowsValue;
+    std::vector<std::unique_ptr<BoardNode>> children;
+    // Children sorted by rowsValue + staticValue (best first).
+    std::vector<int> order;
+  };
+
+  // Value of placing `piece` on the node's board and `depth - 1`
+  // tetrominos after it. `next` is the tetromino after `piece`,
+  // or -1 if it is not known.
+  double valueOfPiece(BoardNode *node, int piece, int next, int depth,
+                      bool isRoot, int *bestIndex);
+
+  // Value of a board with `depth` more tetrominos to come.
+  double valueOfBoard(BoardNode *node, int next, int depth);
+
+  PieceBranch *expand(BoardNode *node, int piece);
+  std::unique_ptr<BoardNode> createNode(const BitBoard &board,
+                                        bool isGameOver, double staticValue);
+
+  // Stop a running search and set up a new root.
+  void prepare(const BitBoard &board, int current, int next);
+
+  // Take the subtree of the old root whose board is `board`
+  // (nullptr if there is none).
+  std::unique_ptr<BoardNode> takeSubtree(const BitBoard &board);
+  static long long countNodes(const BoardNode *node);
+
+  // Iterative deepening on the current root.
+  void run(std::chrono::steady_clock::time_point deadline, int maxDepth);
+
+  bool shouldStop() const;
+  void stopThread();
+
+  TetrisBot bot_;
+  TranspositionTable *table_;
+  // Evaluates all children of a node at once.
+  BatchEvaluator batch_;
+
+  std::unique_ptr<BoardNode> root_;
+  int current_ = -1;
+  int next_ = -1;
+
+  int beamWidth_ = 6;
+  int maxDepth_ = 4;
+  long long maxNodes_ = 300'000;
+  long long createdNodes_ = 0;
+  long long reusedNodes_ = 0;
+
+  std::chrono::steady_clock::time_point deadline_;
+  std::atomic<bool> stop_{false};
+  std::atomic<bool> isFinished_{false};
+  std::atomic<int> completedDepth_{0};
+
+  // Best placement of the last finished iteration.
+  std::mutex bestMutex_;
+  Placement bestPlacement_;
+  bool hasBest_ = false;
+
+  std::thread thread_;
+};
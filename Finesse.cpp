@@ -0,0 +1,187 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Finesse.h"
+#include "./Tetromino.h"
+#include <algorithm>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr int numberOfShifts = 2 * BitBoard::cols - 1;
+
+struct FinesseTable {
+  FinesseTable();
+  FinesseEntry entries[7][4][numberOfShifts];
+  int maxRow = 0;
+};
+
+// One position of the tetromino during the search.
+struct SearchState {
+  int angle;
+  std::vector<Point> location;
+  std::vector<FinesseKey> keys;
+};
+
+void press(NewAbstractTetromino *tetromino, FinesseKey key) {
+  switch (key) {
+  case FinesseKey::Left:
+    tetromino->moveLeft();
+    break;
+  case FinesseKey::Right:
+    tetromino->moveRight();
+    break;
+  case FinesseKey::RotateLeft:
+    tetromino->rotate(true);
+    break;
+  case FinesseKey::RotateRight:
+    tetromino->rotate(false);
+    break;
+  }
+}
+
+// On an empty field the game only undoes a move if it hits a wall.
+// Cells above the roof are allowed, like in the game.
+bool isInsideWalls(const std::vector<Point> &location) {
+  for (const Point &point : location) {
+    int col = point.col - BitBoard::firstCol;
+    int row = point.row - BitBoard::firstRow;
+    if (col < 0 || col >= BitBoard::cols || row >= BitBoard::rows) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Find the orientation and shift of a location. Returns false if the
+// location is not a moved orientation (can't happen for real tetrominos).
+bool findPlacement(int piece, const std::vector<Point> &location,
+                   int *orientation, int *shift) {
+  std::vector<std::pair<int, int>> cells;
+  for (const Point &point : location) {
+    cells.push_back({point.row - BitBoard::firstRow,
+                     point.col - BitBoard::firstCol});
+  }
+  std::sort(cells.begin(), cells.end());
+  int minRow = cells.front().first;
+  int minCol = std::min_element(cells.begin(), cells.end(),
+                                [](const auto &a, const auto &b) {
+                                  return a.second < b.second;
+                                })
+                   ->second;
+
+  for (int o = 0; o < BitBoard::numberOfOrientations(piece); o++) {
+    const Orientation &candidate = BitBoard::getOrientation(piece, o);
+    int rowShift =
+        minRow - *std::min_element(candidate.rows, candidate.rows + 4);
+    int colShift = minCol - candidate.minCol;
+
+    std::vector<std::pair<int, int>> moved;
+    for (int i = 0; i < 4; i++) {
+      moved.push_back(
+          {candidate.rows[i] + rowShift, candidate.cols[i] + colShift});
+    }
+    std::sort(moved.begin(), moved.end());
+    if (moved == cells) {
+      *orientation = o;
+      *shift = colShift;
+      return true;
+    }
+  }
+  return false;
+}
+
+FinesseTable::FinesseTable() {
+  for (auto &piece : entries) {
+    for (auto &orientation : piece) {
+      for (FinesseEntry &entry : orientation) {
+        entry.length = -1;
+      }
+    }
+  }
+
+  const FinesseKey allKeys[] = {FinesseKey::Left, FinesseKey::Right,
+                                FinesseKey::RotateRight,
+                                FinesseKey::RotateLeft};
+
+  for (int piece = 0; piece < 7; piece++) {
+    NewAbstractTetromino *tetromino = TetrominoFactory::create(piece);
+
+    // Breadth-first search: the first time a placement is seen,
+    // it was reached with the fewest keys.
+    std::map<std::pair<int, std::vector<Point>>, bool> visited;
+    std::queue<SearchState> queue;
+    queue.push(SearchState{tetromino->getCurrentAngle(),
+                           tetromino->getCurrentLocation(), {}});
+    visited[{queue.front().angle, queue.front().location}] = true;
+
+    while (!queue.empty()) {
+      SearchState state = queue.front();
+      queue.pop();
+
+      int orientation, shift;
+      if (findPlacement(piece, state.location, &orientation, &shift)) {
+        FinesseEntry &entry =
+            entries[piece][orientation][shift + BitBoard::cols - 1];
+        if (entry.length == -1) {
+          entry.length = state.keys.size();
+          std::copy(state.keys.begin(), state.keys.end(), entry.keys);
+        }
+      }
+      for (const Point &point : state.location) {
+        maxRow = std::max(maxRow, point.row - BitBoard::firstRow);
+      }
+
+      if ((int)state.keys.size() == FinesseEntry::maxLength) {
+        continue;
+      }
+
+      for (FinesseKey key : allKeys) {
+        tetromino->setCurrentLocation(state.location);
+        tetromino->setCurrentAngle(state.angle);
+        press(tetromino, key);
+
+        SearchState next{tetromino->getCurrentAngle(),
+                         tetromino->getCurrentLocation(), state.keys};
+        if (!isInsideWalls(next.location) ||
+            visited.count({next.angle, next.location}) != 0) {
+          continue;
+        }
+        visited[{next.angle, next.location}] = true;
+        next.keys.push_back(key);
+        queue.push(next);
+      }
+    }
+    delete tetromino;
+  }
+}
+
+const FinesseTable &finesseTable() {
+  static const FinesseTable table;
+  return table;
+}
+
+} // namespace
+
+const FinesseEntry *Finesse::get(int piece, int orientation, int shift) {
+  if (piece < 0 || piece >= 7 || orientation < 0 || orientation >= 4 ||
+      shift <= -BitBoard::cols || shift >= BitBoard::cols) {
+    return nullptr;
+  }
+  const FinesseEntry &entry =
+      finesseTable().entries[piece][orientation][shift + BitBoard::cols - 1];
+  return entry.length == -1 ? nullptr : &entry;
+}
+
+int Finesse::maxRow() { return finesseTable().maxRow; }
+
+int Finesse::wastedInputs(const Placement &placement, int usedInputs) {
+  const FinesseEntry *entry = get(placement);
+  if (entry == nullptr) {
+    return 0;
+  }
+  return std::max(0, usedInputs - entry->length);
+}
@@ -0,0 +1,45 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// "Finesse" is the name players use for reaching a placement with the
+// fewest possible keys:
+// https://harddrop.com/wiki/Finesse
+//
+
+#pragma once
+#include "./BitBoard.h"
+#include <cstdint>
+
+// Keys that move a tetromino without letting it fall.
+enum class FinesseKey : uint8_t { Left, Right, RotateLeft, RotateRight };
+
+// Shortest key sequence from the spawn position to one placement.
+struct FinesseEntry {
+  static constexpr int maxLength = 10;
+  // Number of keys, -1 if the placement can't be reached.
+  int8_t length;
+  FinesseKey keys[maxLength];
+};
+
+// Table of the shortest key sequences for every (tetromino, orientation,
+// shift) on an empty field. It is computed once with a breadth-first search
+// over the real Tetromino classes (moveLeft, moveRight, rotate), so it uses
+// exactly the same movement rules as the game.
+//
+// After the keys the tetromino only has to fall. On a field that is not
+// empty the keys are still right as long as rows 0..maxRow() are empty,
+// because the tetromino never leaves these rows while it is moved.
+class Finesse {
+public:
+  // Returns nullptr if the placement can't be reached.
+  static const FinesseEntry *get(int piece, int orientation, int shift);
+  static const FinesseEntry *get(const Placement &placement) {
+    return get(placement.piece, placement.orientation, placement.shift);
+  }
+
+  // Lowest board row any tetromino touches while it is moved.
+  static int maxRow();
+
+  // Keys that were pressed more than needed for the placement.
+  static int wastedInputs(const Placement &placement, int usedInputs);
+};
@@ -0,0 +1,241 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./GameServer.h"
+#include <cstring>
+#include <sys/epoll.h>
+#include <unistd.h>
+
+void RemoteGame::reset() {
+  board_ = BitBoard();
+  std::memset(&last_, 0, sizeof(last_));
+}
+
+bool RemoteGame::apply(const uint8_t *body, size_t size) {
+  UpdateMessage update;
+  if (size < sizeof(update)) {
+    return false;
+  }
+  std::memcpy(&update, body, sizeof(update));
+  int changed = __builtin_popcount(update.changedRows);
+  if (size != sizeof(update) + changed * sizeof(uint16_t) ||
+      update.changedRows >> BitBoard::rows != 0) {
+    return false;
+  }
+
+  // Rebuild the board from its rows, the changed ones from the message.
+  uint16_t rows[BitBoard::rows];
+  const uint8_t *changedRow = body + sizeof(update);
+  for (int i = 0; i < BitBoard::rows; i++) {
+    rows[i] = board_.getRow(i);
+    if ((update.changedRows >> i) & 1) {
+      std::memcpy(&rows[i], changedRow, sizeof(uint16_t));
+      changedRow += sizeof(uint16_t);
+    }
+  }
+  board_ = BitBoard();
+  for (int i = 0; i < BitBoard::rows; i++) {
+    for (int j = 0; j < BitBoard::cols; j++) {
+      if ((rows[i] >> j) & 1) {
+        board_.setCell(i, j);
+      }
+    }
+  }
+  last_ = update;
+  return (uint32_t)board_.getHash() == update.boardHash;
+}
+
+// ____________________________________________________________________________
+GameServer::~GameServer() { stop(); }
+
+bool GameServer::start(const std::string &path) {
+  listenFd_ = LocalSocket::listen(path);
+  epollFd_ = epoll_create1(0);
+  if (listenFd_ == -1 || epollFd_ == -1) {
+    stop();
+    return false;
+  }
+  path_ = path;
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listenFd_;
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event) == -1) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+void GameServer::stop() {
+  for (size_t fd = 0; fd < sessions_.size(); fd++) {
+    if (sessions_[fd] != nullptr) {
+      closeSession(fd);
+    }
+  }
+  if (listenFd_ != -1) {
+    close(listenFd_);
+    unlink(path_.c_str());
+    listenFd_ = -1;
+  }
+  if (epollFd_ != -1) {
+    close(epollFd_);
+    epollFd_ = -1;
+  }
+}
+
+void GameServer::poll(int timeoutMs) {
+  epoll_event events[256];
+  int count = epoll_wait(epollFd_, events, 256, timeoutMs);
+  for (int i = 0; i < count; i++) {
+    int fd = events[i].data.fd;
+    if (fd == listenFd_) {
+      acceptClients();
+      continue;
+    }
+    Session *session = sessions_[fd].get();
+    if (session == nullptr) {
+      continue;
+    }
+    bool isOpen = true;
+    if (events[i].events & EPOLLOUT) {
+      isOpen = session->connection.flush();
+    }
+    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      // Messages that arrived before a hang up are still answered.
+      isOpen = session->connection.receive() && isOpen;
+      isOpen = handleMessages(session) && isOpen;
+    }
+    if (!isOpen || session->connection.pending() > maxPendingBytes) {
+      closeSession(fd);
+    } else {
+      updateEvents(session);
+    }
+  }
+}
+
+size_t GameServer::getSessionBytes() const {
+  size_t bytes = sessions_.capacity() * sizeof(sessions_[0]);
+  for (const auto &session : sessions_) {
+    if (session != nullptr) {
+      bytes += sizeof(Session) + session->connection.getBufferBytes();
+    }
+  }
+  return bytes;
+}
+
+void GameServer::acceptClients() {
+  while (true) {
+    int fd = LocalSocket::accept(listenFd_);
+    if (fd == -1) {
+      return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+      close(fd);
+      continue;
+    }
+    if ((size_t)fd >= sessions_.size()) {
+      sessions_.resize(fd + 1);
+    }
+    sessions_[fd] = std::make_unique<Session>(fd);
+    numberOfSessions_ += 1;
+  }
+}
+
+bool GameServer::handleMessages(Session *session) {
+  MessageConnection &connection = session->connection;
+  ServerMessageHeader header;
+  while (connection.peek(&header, sizeof(header)) &&
+         connection.available() >= sizeof(header) + header.size) {
+    uint8_t body[256];
+    connection.pop(&header, sizeof(header));
+    connection.pop(body, header.size);
+    requests_ += 1;
+
+    auto type = static_cast<ServerMessageType>(header.type);
+    if (type == ServerMessageType::Start &&
+        header.size == sizeof(StartMessage)) {
+      StartMessage start;
+      std::memcpy(&start, body, sizeof(start));
+      session->game.reset(start.seed, start.level);
+      std::memset(session->sentRows, 0, sizeof(session->sentRows));
+      session->isStarted = true;
+      if (!queueUpdate(session, 0)) {
+        return false;
+      }
+    } else if (type == ServerMessageType::Input &&
+               header.size == sizeof(VersusInput) && session->isStarted) {
+      VersusInput input;
+      std::memcpy(&input, body, sizeof(input));
+      Placement placement;
+      int removedRows = -1;
+      if (VersusGame::findPlacement(session->game, input, &placement)) {
+        removedRows = session->game.play(placement);
+      }
+      if (!queueUpdate(session, removedRows)) {
+        return false;
+      }
+    } else {
+      // Not this protocol.
+      return false;
+    }
+  }
+  return true;
+}
+
+bool GameServer::queueUpdate(Session *session, int removedRows) {
+  const HeadlessGame &game = session->game;
+  const BitBoard &board = game.getBoard();
+
+  // Header, update and at most all rows in one write.
+  uint8_t message[sizeof(ServerMessageHeader) + sizeof(UpdateMessage) +
+                  BitBoard::rows * sizeof(uint16_t)];
+  UpdateMessage update;
+  std::memset(&update, 0, sizeof(update));
+  update.score = game.getScore();
+  update.boardHash = (uint32_t)board.getHash();
+  update.lines = game.getDestroyedLines();
+  update.level = game.getLevel();
+  update.currentPiece = game.getCurrentPiece();
+  update.nextPiece = game.getNextPiece();
+  update.removedRows = removedRows;
+  update.isGameOver = game.isGameOver();
+
+  size_t size = sizeof(ServerMessageHeader) + sizeof(UpdateMessage);
+  for (int i = 0; i < BitBoard::rows; i++) {
+    uint16_t row = board.getRow(i);
+    if (row != session->sentRows[i]) {
+      update.changedRows |= 1u << i;
+      std::memcpy(message + size, &row, sizeof(row));
+      size += sizeof(row);
+      session->sentRows[i] = row;
+    }
+  }
+
+  ServerMessageHeader header{static_cast<uint8_t>(ServerMessageType::Update),
+                             static_cast<uint8_t>(size - sizeof(header))};
+  std::memcpy(message, &header, sizeof(header));
+  std::memcpy(message + sizeof(header), &update, sizeof(update));
+  bytesSent_ += size;
+  return session->connection.queue(message, size);
+}
+
+void GameServer::updateEvents(Session *session) {
+  bool isWaiting = session->connection.pending() > 0;
+  if (isWaiting == session->isWaitingForOutput) {
+    return;
+  }
+  epoll_event event{};
+  event.events = isWaiting ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  event.data.fd = session->connection.getFd();
+  epoll_ctl(epollFd_, EPOLL_CTL_MOD, event.data.fd, &event);
+  session->isWaitingForOutput = isWaiting;
+}
+
+void GameServer::closeSession(int fd) {
+  // Closing the descriptor also removes it from the epoll set.
+  sessions_[fd].reset();
+  numberOfSessions_ -= 1;
+}
@@ -0,0 +1,137 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// epoll:
+// https://man7.org/linux/man-pages/man7/epoll.7.html
+//
+
+#pragma once
+#include "./HeadlessGame.h"
+#include "./LocalSocket.h"
+#include "./Versus.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Messages between TetrisServerMain and its clients. A message is a
+// ServerMessageHeader followed by `size` bytes. Clients run on the same
+// machine, so all fields are in host byte order.
+enum class ServerMessageType : uint8_t {
+  // Client: start a new game (StartMessage).
+  Start = 1,
+  // Client: place the current tetromino (VersusInput, the same two bytes
+  // as in versus games).
+  Input = 2,
+  // Server: the game after the last client message (UpdateMessage and
+  // one uint16_t per changed row).
+  Update = 3,
+};
+
+struct ServerMessageHeader {
+  uint8_t type;
+  uint8_t size;
+};
+
+struct StartMessage {
+  uint64_t seed;
+  int32_t level;
+  int32_t reserved;
+};
+
+// Only rows that changed since the last update are sent: bit i of
+// changedRows is row i, and the rows follow from the top down. After a
+// start all non-empty rows are sent (the client starts with an empty
+// board).
+struct UpdateMessage {
+  int32_t score;
+  uint32_t changedRows;
+  // Lower half of the Zobrist hash of the board, so the client can check
+  // its copy.
+  uint32_t boardHash;
+  int32_t lines;
+  int32_t level;
+  int8_t currentPiece;
+  int8_t nextPiece;
+  // Of the last placement, -1 if it ended the game.
+  int8_t removedRows;
+  uint8_t isGameOver;
+};
+
+static_assert(sizeof(UpdateMessage) == 24, "UpdateMessage has no padding");
+
+// Client side copy of a game on the server, built from the updates.
+class RemoteGame {
+public:
+  RemoteGame() { reset(); }
+
+  // Empty board, like the server after a start.
+  void reset();
+  // Apply the body of an update message. Returns false if it is broken
+  // or the rows don't match the hash.
+  bool apply(const uint8_t *body, size_t size);
+
+  const BitBoard &getBoard() const { return board_; }
+  const UpdateMessage &getLastUpdate() const { return last_; }
+
+private:
+  BitBoard board_;
+  UpdateMessage last_;
+};
+
+// Many headless games in one process, one per connection of a Unix domain
+// socket, all served by one epoll loop on one thread. A session is a
+// HeadlessGame, the rows its client has and the buffers of its connection
+// (a few hundred bytes), so thousands of sessions fit in one process.
+class GameServer {
+public:
+  // A client that doesn't read its updates is disconnected when this many
+  // bytes wait for it.
+  static constexpr size_t maxPendingBytes = 64 * 1024;
+
+  GameServer() = default;
+  ~GameServer();
+  GameServer(const GameServer &) = delete;
+  GameServer &operator=(const GameServer &) = delete;
+
+  // Listen on the socket `path`, false if that fails.
+  bool start(const std::string &path);
+  // Wait up to `timeoutMs` for clients and serve them.
+  void poll(int timeoutMs);
+  // Close all sessions and the socket.
+  void stop();
+
+  int getSessions() const { return numberOfSessions_; }
+  long long getRequests() const { return requests_; }
+  long long getBytesSent() const { return bytesSent_; }
+  // Memory of all sessions, game state and connection buffers.
+  size_t getSessionBytes() const;
+
+private:
+  struct Session {
+    explicit Session(int fd) : connection(fd) {}
+    MessageConnection connection;
+    HeadlessGame game;
+    bool isStarted = false;
+    bool isWaitingForOutput = false;
+    // Rows as the client has them.
+    uint16_t sentRows[BitBoard::rows] = {};
+  };
+
+  void acceptClients();
+  // Handle all complete messages, false if the session has to be closed.
+  bool handleMessages(Session *session);
+  bool queueUpdate(Session *session, int removedRows);
+  // Watch for output only while bytes are kept.
+  void updateEvents(Session *session);
+  void closeSession(int fd);
+
+  int epollFd_ = -1;
+  int listenFd_ = -1;
+  std::string path_;
+  // Indexed by file descriptor.
+  std::vector<std::unique_ptr<Session>> sessions_;
+  int numberOfSessions_ = 0;
+  long long requests_ = 0;
+  long long bytesSent_ = 0;
+};
@@ -0,0 +1,170 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./HeadlessGame.h"
+#include "./Zobrist.h"
+#include <cstdlib>
+
+HeadlessGame::HeadlessGame(uint64_t seed, int level) { reset(seed, level); }
+
+void HeadlessGame::reset(uint64_t seed, int level) {
+  board_ = BitBoard();
+  generator_.reset(seed);
+
+  currentLevel_ = level;
+  previousQuotient_ = 0;
+  destroyedLines_ = 0;
+  currentPoints_ = 0;
+  for (int i = 0; i < 7; i++) {
+    statistics_[i] = 0;
+  }
+  piecesPlaced_ = 0;
+  isGameOver_ = false;
+
+  next_ = generator_.nextPiece();
+  spawn();
+}
+
+void HeadlessGame::restore(const GameSnapshot &snapshot) {
+  board_ = BitBoard();
+  for (int i = 0; i < GameSnapshot::rows; i++) {
+    for (int j = 0; j < GameSnapshot::cols; j++) {
+      if ((snapshot.boardRows[i] >> j) & 1) {
+        board_.setCell(i, j);
+      }
+    }
+  }
+  // The game generates tetrominos like PieceGenerator.
+  generator_.setState(PieceGenerator::State{
+      snapshot.rngState, snapshot.previousPiece, snapshot.pendingPiece});
+
+  currentLevel_ = snapshot.level;
+  previousQuotient_ = snapshot.previousQuotient;
+  destroyedLines_ = snapshot.lines;
+  currentPoints_ = snapshot.score;
+  piecesPlaced_ = 0;
+  for (int i = 0; i < 7; i++) {
+    statistics_[i] = snapshot.statistics[i];
+    piecesPlaced_ += statistics_[i];
+  }
+  isGameOver_ = false;
+
+  next_ = snapshot.nextPiece;
+  if (snapshot.currentPiece != -1) {
+    current_ = snapshot.currentPiece;
+  } else {
+    // Taken between two tetrominos.
+    spawn();
+  }
+}
+
+void HeadlessGame::spawn() {
+  current_ = next_;
+  next_ = generator_.nextPiece();
+
+  // If there is no space for the new tetromino, the game is over.
+  if (board_.collides(current_, 0, 0, 0)) {
+    isGameOver_ = true;
+  }
+}
+
+int HeadlessGame::play(const Placement &placement) {
+  return play(placement, nullptr);
+}
+
+int HeadlessGame::play(const Placement &placement, Undo *undo) {
+  if (undo != nullptr) {
+    undo->generator = generator_.getState();
+    undo->current = current_;
+    undo->next = next_;
+    undo->currentLevel = currentLevel_;
+    undo->previousQuotient = previousQuotient_;
+    undo->destroyedLines = destroyedLines_;
+    undo->currentPoints = currentPoints_;
+    undo->isGameOver = isGameOver_;
+    undo->isPlaced = !isGameOver_;
+  }
+  if (isGameOver_) {
+    return -1;
+  }
+
+  int removedRows =
+      board_.apply(placement, undo != nullptr ? &undo->board : nullptr);
+  statistics_[current_] += 1;
+  piecesPlaced_ += 1;
+
+  if (removedRows == -1) {
+    isGameOver_ = true;
+    return -1;
+  }
+
+  // Same as reshapeGameField and decideAction in the game.
+  if (removedRows > 0) {
+    destroyedLines_ += removedRows;
+    currentPoints_ += pointsForRemovedRows(removedRows, currentLevel_);
+
+    div_t divresult = std::div(destroyedLines_, 10);
+    if (divresult.quot > previousQuotient_) {
+      currentLevel_ += 1;
+      previousQuotient_ = divresult.quot;
+    }
+  }
+
+  spawn();
+  return isGameOver_ ? -1 : removedRows;
+}
+
+void HeadlessGame::undo(const Undo &undo) {
+  if (undo.isPlaced) {
+    board_.undo(undo.board);
+    statistics_[undo.current] -= 1;
+    piecesPlaced_ -= 1;
+  }
+  generator_.setState(undo.generator);
+  current_ = undo.current;
+  next_ = undo.next;
+  currentLevel_ = undo.currentLevel;
+  previousQuotient_ = undo.previousQuotient;
+  destroyedLines_ = undo.destroyedLines;
+  currentPoints_ = undo.currentPoints;
+  isGameOver_ = undo.isGameOver;
+}
+
+void HeadlessGame::addGarbage(int count, int holeCol) {
+  if (isGameOver_ || count <= 0) {
+    return;
+  }
+  if (!board_.addGarbage(count, holeCol) || board_.getRow(0) != 0 ||
+      board_.collides(current_, 0, 0, 0)) {
+    isGameOver_ = true;
+  }
+}
+
+int HeadlessGame::getSpeed() const { return fallingSpeed(currentLevel_); }
+
+uint64_t HeadlessGame::getPositionHash() const {
+  return board_.getHash() ^ Zobrist::pieceKey(current_) ^
+         Zobrist::previewKey(next_);
+}
+
+int HeadlessGame::pointsForRemovedRows(int removedRows, int level) {
+  static const int points[5] = {0, 40, 100, 300, 1200};
+  if (removedRows < 0 || removedRows > 4) {
+    return 0;
+  }
+  return (level + 1) * points[removedRows];
+}
+
+int HeadlessGame::fallingSpeed(int level) {
+  static const int speed[30] = {800, 716, 633, 550, 466, 383, 300, 216,
+                                133, 100, 83,  83,  83,  66,  66,  66,
+                                50,  50,  50,  33,  33,  33,  33,  33,
+                                33,  33,  33,  33,  33,  16};
+  if (level < 0) {
+    return speed[0];
+  }
+  if (level > 29) {
+    return speed[29];
+  }
+  return speed[level];
+}
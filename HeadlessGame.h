@@ -0,0 +1,102 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#pragma once
+#include "./BitBoard.h"
+#include "./PieceGenerator.h"
+#include "./Snapshot.h"
+#include <cstdint>
+
+// Tetris without a screen, used by the bot, the tuner and other tools that
+// need to play many games fast. One step is a whole placement instead of
+// single key presses. Scoring, level and speed follow the same rules as
+// AbstractTetrisGame (without the points for pressing "down").
+//
+// The state has a fixed size, so playing never allocates memory.
+class HeadlessGame {
+public:
+  explicit HeadlessGame(uint64_t seed = 0, int level = 0);
+
+  // Start a new game with the given seed and starting level.
+  void reset(uint64_t seed, int level = 0);
+
+  // Continue the game of a snapshot (see Snapshot.h), for example to start
+  // a benchmark in the middle of a game instead of replaying it. Only the
+  // type of the current tetromino is used, it starts at the spawn position.
+  // The snapshot must be playable (see GameSnapshot::isPlayable).
+  void restore(const GameSnapshot &snapshot);
+
+  // Placements of the current tetromino (see BitBoard::generatePlacements).
+  int generatePlacements(Placement *placements) const {
+    return board_.generatePlacements(current_, placements);
+  }
+
+  // Place the current tetromino. Returns the number of removed rows,
+  // or -1 if the game is over after this placement.
+  int play(const Placement &placement);
+
+  // What play() changed (a few dozen bytes instead of the whole game).
+  struct Undo {
+    BoardUndo board;
+    PieceGenerator::State generator;
+    int current;
+    int next;
+    int currentLevel;
+    int previousQuotient;
+    int destroyedLines;
+    int currentPoints;
+    bool isGameOver;
+    // False if the game was over already and nothing was placed.
+    bool isPlaced;
+  };
+  // The same as play(), and write into `undo` what changed, for search
+  // and rollback (make / unmake).
+  int play(const Placement &placement, Undo *undo);
+  // Take back the last play (or the last one that isn't undone yet), the
+  // game is exactly as before, including the tetromino sequence.
+  void undo(const Undo &undo);
+
+  // Rows from the opponent in a versus game (see BitBoard::addGarbage).
+  // The game is over if they push cells onto the spawn row or under the
+  // current tetromino. Not covered by undo().
+  void addGarbage(int count, int holeCol);
+
+  // Getters
+  const BitBoard &getBoard() const { return board_; }
+  int getCurrentPiece() const { return current_; }
+  int getNextPiece() const { return next_; }
+  int getLevel() const { return currentLevel_; }
+  int getSpeed() const;
+  int getDestroyedLines() const { return destroyedLines_; }
+  int getScore() const { return currentPoints_; }
+  int getStatistics(int piece) const { return statistics_[piece]; }
+  int getPiecesPlaced() const { return piecesPlaced_; }
+  bool isGameOver() const { return isGameOver_; }
+
+  // Zobrist hash of board, current and next tetromino.
+  uint64_t getPositionHash() const;
+
+  // Points for removing 1, 2, 3 or 4 rows at once on the given level.
+  static int pointsForRemovedRows(int removedRows, int level);
+
+  // Falling speed in ms (same table as in AbstractTetrisGame).
+  static int fallingSpeed(int level);
+
+private:
+  // Take the next tetromino from the generator.
+  void spawn();
+
+  BitBoard board_;
+  PieceGenerator generator_;
+
+  int current_;
+  int next_;
+
+  int currentLevel_;
+  int previousQuotient_;
+  int destroyedLines_;
+  int currentPoints_;
+  int statistics_[7];
+  int piecesPlaced_;
+  bool isGameOver_;
+};
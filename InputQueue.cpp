@@ -0,0 +1,35 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./InputQueue.h"
+#include <algorithm>
+
+bool InputQueue::push(const UserInput &userInput) {
+  uint32_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == capacity) {
+    droppedInputs_ += 1;
+    return false;
+  }
+  buffer_[tail & (capacity - 1)] = userInput;
+  // The key must be written before the consumer can see the new tail.
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+bool InputQueue::pop(UserInput *userInput) {
+  uint32_t head = head_.load(std::memory_order_relaxed);
+  if (head == tail_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  *userInput = buffer_[head & (capacity - 1)];
+  // The slot can be reused by the producer only after it was read.
+  head_.store(head + 1, std::memory_order_release);
+  return true;
+}
+
+void InputLatency::add(std::chrono::steady_clock::duration latency) {
+  double ms = std::chrono::duration<double, std::milli>(latency).count();
+  count += 1;
+  totalMs += ms;
+  maxMs = std::max(maxMs, ms);
+}
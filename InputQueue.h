@@ -0,0 +1,55 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Single producer / single consumer ring buffer with acquire / release
+// atomics:
+// https://www.1024cores.net/home/lock-free-algorithms/queues
+//
+
+#pragma once
+#include "./TerminalManager.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Keys read by the input thread (see TerminalManager::startInputThread) on
+// their way to the game thread. Exactly one thread may push and exactly one
+// thread may pop, then no lock is needed: the producer only writes tail_,
+// the consumer only writes head_.
+class InputQueue {
+public:
+  // Power of two, so the index wraps with a mask.
+  static constexpr uint32_t capacity = 256;
+
+  // Producer side. Returns false (and counts the key as dropped) if the
+  // queue is full.
+  bool push(const UserInput &userInput);
+
+  // Consumer side. Returns false if the queue is empty.
+  bool pop(UserInput *userInput);
+
+  long long getDroppedInputs() const { return droppedInputs_; }
+  // Keys waiting right now (only exact on the consumer thread).
+  uint32_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+private:
+  UserInput buffer_[capacity];
+  // Both indices only grow, the slot is index & (capacity - 1). They are
+  // on different cache lines, so the two threads don't share one.
+  alignas(64) std::atomic<uint32_t> head_{0};
+  alignas(64) std::atomic<uint32_t> tail_{0};
+  std::atomic<long long> droppedInputs_{0};
+};
+
+// Time from reading a key to applying it in the game.
+struct InputLatency {
+  long long count = 0;
+  double totalMs = 0;
+  double maxMs = 0;
+
+  void add(std::chrono::steady_clock::duration latency);
+  double averageMs() const { return count == 0 ? 0 : totalMs / count; }
+};
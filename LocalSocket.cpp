@@ -0,0 +1,216 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./LocalSocket.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+bool makeAddress(const std::string &path, sockaddr_un *address) {
+  std::memset(address, 0, sizeof(*address));
+  address->sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address->sun_path)) {
+    return false;
+  }
+  std::memcpy(address->sun_path, path.c_str(), path.size());
+  return true;
+}
+
+bool setNonBlocking(int fd) {
+  int flags = fcntl(fd, F_GETFL, 0);
+  return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+} // namespace
+
+int LocalSocket::listen(const std::string &path) {
+  sockaddr_un address;
+  if (!makeAddress(path, &address)) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return -1;
+  }
+  unlink(path.c_str());
+  if (bind(fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) ==
+          -1 ||
+      ::listen(fd, SOMAXCONN) == -1 || !setNonBlocking(fd)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+int LocalSocket::connect(const std::string &path, int timeoutMs) {
+  sockaddr_un address;
+  if (!makeAddress(path, &address)) {
+    return -1;
+  }
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (true) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1) {
+      return -1;
+    }
+    if (::connect(fd, reinterpret_cast<sockaddr *>(&address),
+                  sizeof(address)) == 0) {
+      if (!setNonBlocking(fd)) {
+        close(fd);
+        return -1;
+      }
+      return fd;
+    }
+    close(fd);
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return -1;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
+int LocalSocket::accept(int listenFd) {
+  int fd = ::accept(listenFd, nullptr, nullptr);
+  if (fd == -1) {
+    return -1;
+  }
+  if (!setNonBlocking(fd)) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// ____________________________________________________________________________
+void MessageConnection::close() {
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+bool MessageConnection::send(const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  while (size > 0 && fd_ != -1) {
+    // No SIGPIPE if the peer is gone, send fails instead.
+    ssize_t written = ::send(fd_, bytes, size, MSG_NOSIGNAL);
+    if (written > 0) {
+      bytes += written;
+      size -= written;
+    } else if (written == -1 && (errno == EAGAIN || errno == EINTR)) {
+      pollfd waiting{fd_, POLLOUT, 0};
+      poll(&waiting, 1, 100);
+    } else {
+      return false;
+    }
+  }
+  return fd_ != -1;
+}
+
+ssize_t MessageConnection::write(const uint8_t *data, size_t size) {
+  size_t written = 0;
+  while (written < size && fd_ != -1) {
+    ssize_t count = ::send(fd_, data + written, size - written, MSG_NOSIGNAL);
+    if (count > 0) {
+      written += count;
+    } else if (count == -1 && errno == EINTR) {
+      continue;
+    } else if (count == -1 && errno == EAGAIN) {
+      break;
+    } else {
+      return -1;
+    }
+  }
+  return fd_ != -1 ? (ssize_t)written : -1;
+}
+
+bool MessageConnection::queue(const void *data, size_t size) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  // Keep the order: nothing is written past kept bytes.
+  if (outgoing_.empty()) {
+    ssize_t written = write(bytes, size);
+    if (written == -1) {
+      return false;
+    }
+    bytes += written;
+    size -= written;
+  }
+  outgoing_.insert(outgoing_.end(), bytes, bytes + size);
+  return true;
+}
+
+bool MessageConnection::flush() {
+  if (outgoing_.empty()) {
+    return fd_ != -1;
+  }
+  ssize_t written = write(outgoing_.data(), outgoing_.size());
+  if (written == -1) {
+    return false;
+  }
+  outgoing_.erase(outgoing_.begin(), outgoing_.begin() + written);
+  return true;
+}
+
+bool MessageConnection::receive() {
+  if (fd_ == -1) {
+    return false;
+  }
+  // Move the rest to the front instead of growing forever.
+  if (begin_ > 0) {
+    buffer_.erase(buffer_.begin(), buffer_.begin() + begin_);
+    begin_ = 0;
+  }
+  uint8_t chunk[4096];
+  while (true) {
+    ssize_t count = read(fd_, chunk, sizeof(chunk));
+    if (count > 0) {
+      buffer_.insert(buffer_.end(), chunk, chunk + count);
+    } else if (count == -1 && errno == EINTR) {
+      continue;
+    } else {
+      // EAGAIN: everything is read. 0: the peer closed the connection.
+      return count == -1 && errno == EAGAIN;
+    }
+  }
+}
+
+bool MessageConnection::peek(void *data, size_t size) const {
+  if (available() < size) {
+    return false;
+  }
+  std::memcpy(data, buffer_.data() + begin_, size);
+  return true;
+}
+
+bool MessageConnection::pop(void *data, size_t size) {
+  if (!peek(data, size)) {
+    return false;
+  }
+  begin_ += size;
+  return true;
+}
+
+void ServerProcess::raiseFileLimit() {
+  rlimit limit;
+  if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+    limit.rlim_cur = limit.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &limit);
+  }
+}
+
+int64_t ServerProcess::cpuTimeUs() {
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1'000'000ll +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
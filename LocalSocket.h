@@ -0,0 +1,85 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Unix domain sockets:
+// https://man7.org/linux/man-pages/man7/unix.7.html
+//
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+#include <vector>
+
+// Stream sockets in the file system (AF_UNIX) for processes on the same
+// machine. All returned descriptors are non-blocking, -1 means failure.
+class LocalSocket {
+public:
+  // Listen on `path` (an old socket file there is removed).
+  static int listen(const std::string &path);
+  // Connect to `path`, retrying for up to `timeoutMs` until someone
+  // listens there.
+  static int connect(const std::string &path, int timeoutMs);
+  // Next waiting connection, -1 if there is none.
+  static int accept(int listenFd);
+};
+
+// Process wide helpers of the programs that serve many sockets.
+class ServerProcess {
+public:
+  // Raise the limit of open files to the hard limit, every connection is
+  // one file descriptor.
+  static void raiseFileLimit();
+  // User and system CPU time of the process so far.
+  static int64_t cpuTimeUs();
+};
+
+// Messages over a non-blocking stream socket. Bytes that arrived are kept
+// until whole messages can be taken out, so partial reads don't matter.
+class MessageConnection {
+public:
+  explicit MessageConnection(int fd = -1) : fd_(fd) {}
+  ~MessageConnection() { close(); }
+  MessageConnection(const MessageConnection &) = delete;
+  MessageConnection &operator=(const MessageConnection &) = delete;
+
+  int getFd() const { return fd_; }
+  bool isOpen() const { return fd_ != -1; }
+  void close();
+
+  // Write all bytes, waiting while the socket buffer is full. Returns
+  // false if the connection is closed.
+  bool send(const void *data, size_t size);
+  // Write what the socket takes now and keep the rest for flush(), never
+  // waits (for servers with many connections). Returns false if the
+  // connection is closed.
+  bool queue(const void *data, size_t size);
+  // Write kept bytes, false if the connection is closed.
+  bool flush();
+  // Bytes kept by queue() that weren't written yet.
+  size_t pending() const { return outgoing_.size(); }
+  // Memory of the buffers.
+  size_t getBufferBytes() const {
+    return buffer_.capacity() + outgoing_.capacity();
+  }
+  // Read everything that arrived. Returns false if the peer closed the
+  // connection (the received bytes can still be taken).
+  bool receive();
+  // Received bytes that weren't taken yet.
+  size_t available() const { return buffer_.size() - begin_; }
+  // Copy the next `size` bytes without taking them, false if they didn't
+  // arrive yet.
+  bool peek(void *data, size_t size) const;
+  // Take the next `size` bytes, false if they didn't arrive yet.
+  bool pop(void *data, size_t size);
+
+private:
+  int fd_;
+  std::vector<uint8_t> buffer_;
+  size_t begin_ = 0;
+  std::vector<uint8_t> outgoing_;
+  // Write as much as possible without waiting, -1 if the connection is
+  // closed.
+  ssize_t write(const uint8_t *data, size_t size);
+};
@@ -3,6 +3,7 @@
 
 #include "./MockTerminalManager.h"
 #include "./Point.h"
+#include <algorithm>
 
 MockTerminalManager::MockTerminalManager(int numRows, int numCols) {
   numRows_ = numRows;
@@ -17,4 +18,36 @@ void MockTerminalManager::refresh() { return; }
 
 bool MockTerminalManager::isPixelDrawn(int row, int col) const {
   return drawnPixels_.count(Point{row, col, NamedColors::BLACK});
-}
\ No newline at end of file
+}
+
+void MockTerminalManager::drawString(int row, int col, int, const char *str) {
+  drawnStrings_[Point{row, col, NamedColors::BLACK}] = str;
+}
+
+std::string MockTerminalManager::getDrawnString(int row, int col) const {
+  auto it = drawnStrings_.find(Point{row, col, NamedColors::BLACK});
+  return it == drawnStrings_.end() ? "" : it->second;
+}
+
+void MockTerminalManager::takeInputToDraw(long long *count, long long *totalUs,
+                                          long long *maxUs) {
+  *count = inputs_;
+  *totalUs = inputTotalUs_;
+  *maxUs = inputMaxUs_;
+  inputs_ = 0;
+  inputTotalUs_ = 0;
+  inputMaxUs_ = 0;
+}
+
+void MockTerminalManager::renderFrames(long long frames, long long bytes,
+                                       long long dropped) {
+  renderedFrames_ += frames;
+  bytesWritten_ += bytes;
+  droppedFrames_ += dropped;
+}
+
+void MockTerminalManager::drawInput(long long latencyUs) {
+  inputs_ += 1;
+  inputTotalUs_ += latencyUs;
+  inputMaxUs_ = std::max(inputMaxUs_, latencyUs);
+}
@@ -6,6 +6,7 @@
 #pragma once
 #include "./AbstractTerminalManager.h"
 #include "./Point.h"
+#include <string>
 #include <unordered_map>
 
 // Mostly the same as in the previous exercise.
@@ -18,13 +19,34 @@ public:
   void refresh() override;
   int numRows() const override { return numRows_; }
   int numCols() const override { return numCols_; }
+  void drawString(int row, int col, int color, const char *str) override;
+
+  long long getRenderedFrames() const override { return renderedFrames_; }
+  long long getDroppedFrames() const override { return droppedFrames_; }
+  long long getBytesWritten() const override { return bytesWritten_; }
+  void takeInputToDraw(long long *count, long long *totalUs,
+                       long long *maxUs) override;
 
   bool isPixelDrawn(int row, int col) const;
   std::unordered_map<Point, int> getDrawnPixels() const { return drawnPixels_; }
+  // Last string drawn at the given position, empty if there is none.
+  std::string getDrawnString(int row, int col) const;
+
+  // Pretend that frames were written to the screen.
+  void renderFrames(long long frames, long long bytes, long long dropped);
+  // Pretend that a key was drawn `latencyUs` after it was read.
+  void drawInput(long long latencyUs);
 
 private:
   // Point & color
   std::unordered_map<Point, int> drawnPixels_;
+  std::unordered_map<Point, std::string> drawnStrings_;
+  long long renderedFrames_ = 0;
+  long long droppedFrames_ = 0;
+  long long bytesWritten_ = 0;
+  long long inputs_ = 0;
+  long long inputTotalUs_ = 0;
+  long long inputMaxUs_ = 0;
   int numCols_;
   int numRows_;
 };
\ No newline at end of file
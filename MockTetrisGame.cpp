@@ -36,6 +36,11 @@ void MockTetrisGame::placeTetromino() {
       gameOver();
     }
 
+    // Update board hash (only if the cell was empty before).
+    if (!gameField[point]) {
+      toggleCell(point);
+    }
+
     // We can't just write gameField[point] = true, because we out new point
     // can have new color.
     gameField.erase(point);
@@ -83,6 +88,18 @@ void MockTetrisGame::decideAction(UserInput userInput,
     }
   }
 
+  else if (userInput.isKeySpace()) {
+    int distance = dropDistance();
+    for (int i = 0; i < distance; i++) {
+      currentTetromino->moveDown();
+    }
+    previousLocation = currentTetromino->getCurrentLocation();
+    currentTetromino->moveDown();
+    if (!isArtificialMovement) {
+      earnedPoints += distance + 1;
+    }
+  }
+
   // Return Tetromino to previous location if there is a collision
   //
   // To decide correct collision type we need additional information,
@@ -97,9 +114,11 @@ void MockTetrisGame::decideAction(UserInput userInput,
   // current "surface" (see .h for exact information about surface points)
   // point, which will result in wrong collision.
 
-  Collision collision = isColliding(
-      userInput.isKeyDown(), userInput.isLeftRotationKey(leftRotationKey),
-      userInput.isRightRotationKey(rightRotationKey), previousLocation);
+  Collision collision =
+      isColliding(userInput.isKeyDown() || userInput.isKeySpace(),
+                  userInput.isLeftRotationKey(leftRotationKey),
+                  userInput.isRightRotationKey(rightRotationKey),
+                  previousLocation);
 
   // We will need this variable for testing.
   lastCollision = collision;
@@ -118,6 +137,10 @@ void MockTetrisGame::decideAction(UserInput userInput,
     // Remove full rows
     reshapeGameField();
 
+    // Cells that were covered by the removed rows can be on the surface now,
+    // without this the next tetromino would get stuck on them.
+    updateSurface();
+
     // Update number of destroyed lines and leve if needed
     div_t divresult = std::div(destroyedLines, 10);
     if (divresult.quot > previousQuotient) {
@@ -191,6 +214,7 @@ void MockTetrisGame::reshapeGameField() {
       }
 
       gameField[pointToRemove] = false;
+      toggleCell(pointToRemove);
     }
   }
   bool flag = false;
@@ -209,6 +233,7 @@ void MockTetrisGame::reshapeGameField() {
 
           // Set it to false
           gameField[currentPoint] = false;
+          toggleCell(currentPoint);
           // Immitates "falling"
 
           // Remove current point from screen
@@ -235,6 +260,7 @@ void MockTetrisGame::reshapeGameField() {
 
           // Put new on the screen and add it to the "logical screen".
           gameField[currentPoint] = true;
+          toggleCell(currentPoint);
         }
 
         flag = false;
@@ -13,6 +13,15 @@ public:
   friend class MockTetrisGameIsGameOver_MockTetrisGame_Test;
   friend class MockTetrisGameCollision_MockTetrisGame_Test;
   friend class MockTetrisGameLineRemoving_MockTetrisGame_Test;
+  friend class MockTetrisGameHashing_MockTetrisGame_Test;
+  friend class BitBoardPlacementsMatchGame_BitBoard_Test;
+  friend class BotSearchPlaysMockGame_BotSearch_Test;
+  friend class FinesseMatchesGame_Finesse_Test;
+  friend class ColumnMasksMatchCells_BitBoard_Test;
+  friend class MockTetrisGameHardDrop_MockTetrisGame_Test;
+  friend class MockTetrisGameFormatNumber_MockTetrisGame_Test;
+  friend class SnapshotRoundTrip_Snapshot_Test;
+  friend class SnapshotRejectsBadFields_Snapshot_Test;
 
   // We don't need terminal manager for this.
   MockTetrisGame(int level, char rrk, char lrk);
@@ -15,21 +15,57 @@ void Parser::printHelp() {
                "<letter>\n"
                "--rightRotationKey <letter>:       Set right rotation key to "
                "<letter>\n"
+               "--ai:                              Let the bot play\n"
+               "--weights <file>:                  Bot weights (from "
+               "TetrisTuneMain)\n"
+               "--das <ms>:                        Delay before a held key "
+               "repeats (\"10f\" for frames)\n"
+               "--arr <ms>:                        Time between repeats, 0 "
+               "moves to the wall\n"
+               "--noAnimations:                    Show removed rows and game "
+               "over at once\n"
+               "--trace <file>:                    Write a timeline (Chrome "
+               "trace JSON) at the end\n"
+               "--telemetry <name>:                Publish live counters in "
+               "shared memory /<name>\n"
+               "--save <file>:                     Where 'k' saves the game "
+               "(tetris.snapshot)\n"
+               "--load <file>:                     Continue a saved game\n"
+               "--spectate <socket>:               Stream the game to "
+               "TetrisSpectateMain --hub\n"
                "--help:                            Show help\n";
   exit(1);
 }
 
+int Parser::parseMilliseconds(const std::string &value) {
+  if (!value.empty() && value.back() == 'f') {
+    return (std::stoi(value) * 1000 + 30) / 60;
+  }
+  return std::stoi(value);
+}
+
 void Parser::parseArguments(int argc, char **argv) {
   // This C-style string tells us that we have 4 arguments.
   // : means that we are awaiting for some values after l, r and b.
-  const char *const shortOptions = "b:l:r:h";
+  const char *const shortOptions = "b:l:r:iw:d:a:nt:m:k:o:e:h";
 
   // Short arguments are kind of cryptic, so I've decided to add long arguments.
   const option longOPtions[] = {
       {"level", optional_argument, nullptr, 'b'},
       {"leftRotationKey", optional_argument, nullptr, 'l'},
       {"rightRotationKey", optional_argument, nullptr, 'r'},
-      {"help", optional_argument, nullptr, 'h'}};
+      {"ai", no_argument, nullptr, 'i'},
+      {"weights", required_argument, nullptr, 'w'},
+      {"das", required_argument, nullptr, 'd'},
+      {"arr", required_argument, nullptr, 'a'},
+      {"noAnimations", no_argument, nullptr, 'n'},
+      {"trace", required_argument, nullptr, 't'},
+      {"telemetry", required_argument, nullptr, 'm'},
+      {"save", required_argument, nullptr, 'k'},
+      {"load", required_argument, nullptr, 'o'},
+      {"spectate", required_argument, nullptr, 'e'},
+      {"help", optional_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
 
   // Parse all arguments
   while (true) {
@@ -52,6 +88,36 @@ void Parser::parseArguments(int argc, char **argv) {
     case 'r':
       rightRotationKey = *optarg;
       break;
+    case 'i':
+      botEnabled = true;
+      break;
+    case 'w':
+      weightsFile = optarg;
+      break;
+    case 'd':
+      dasMs = parseMilliseconds(optarg);
+      break;
+    case 'a':
+      arrMs = parseMilliseconds(optarg);
+      break;
+    case 'n':
+      animationsEnabled = false;
+      break;
+    case 't':
+      traceFile = optarg;
+      break;
+    case 'm':
+      telemetryName = optarg;
+      break;
+    case 'k':
+      snapshotFile = optarg;
+      break;
+    case 'o':
+      loadFile = optarg;
+      break;
+    case 'e':
+      spectateSocket = optarg;
+      break;
 
     case 'h':
       printHelp();
@@ -2,7 +2,9 @@
 // Code snippets from the lectures where used
 
 #pragma once
+#include "./AutoShift.h"
 #include <getopt.h>
+#include <string>
 
 // Parser class for parsing command line arguments.
 class Parser {
@@ -16,10 +18,34 @@ public:
   int getLevel() { return level; }
   char getLeftRotationKey() { return leftRotationKey; }
   char getRightRotationKey() { return rightRotationKey; }
+  bool isBotEnabled() { return botEnabled; }
+  std::string getWeightsFile() { return weightsFile; }
+  // Sideways auto repeat (see AutoShift.h), in ms.
+  int getDasMs() { return dasMs; }
+  int getArrMs() { return arrMs; }
+  bool isAnimationsEnabled() { return animationsEnabled; }
+  std::string getTraceFile() { return traceFile; }
+  std::string getTelemetryName() { return telemetryName; }
+  std::string getSnapshotFile() { return snapshotFile; }
+  std::string getLoadFile() { return loadFile; }
+  std::string getSpectateSocket() { return spectateSocket; }
+
+  // "<n>" is n ms, "<n>f" is n frames of 1/60 s.
+  static int parseMilliseconds(const std::string &value);
 
 private:
   // Default values.
   int level = 0;
   char leftRotationKey = 'a';
   char rightRotationKey = 's';
+  bool botEnabled = false;
+  std::string weightsFile;
+  int dasMs = AutoShift::defaultDasMs;
+  int arrMs = AutoShift::defaultArrMs;
+  bool animationsEnabled = true;
+  std::string traceFile;
+  std::string telemetryName;
+  std::string snapshotFile = "tetris.snapshot";
+  std::string loadFile;
+  std::string spectateSocket;
 };
\ No newline at end of file
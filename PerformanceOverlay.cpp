@@ -0,0 +1,92 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./PerformanceOverlay.h"
+#include "./AllocationTracker.h"
+#include "./Point.h"
+#include <cmath>
+#include <stdio.h>
+
+void PerformanceOverlay::toggle(Clock::time_point now) {
+  isVisible_ = !isVisible_;
+  if (isVisible_) {
+    reset(now);
+    update(now);
+    return;
+  }
+  for (int i = 0; i < lines; i++) {
+    tm_->drawString(row_ + i, col_, (int)NamedColors::WHITE,
+                    "                    ");
+  }
+  tm_->refresh();
+}
+
+void PerformanceOverlay::tick(Clock::time_point now) {
+  ticks_ += 1;
+  if (isVisible_ && now - lastUpdate_ >= std::chrono::milliseconds(updateMs)) {
+    update(now);
+  }
+}
+
+void PerformanceOverlay::startTetromino(Clock::time_point now) {
+  lastGravity_ = now;
+  lastGravityIntervalMs_ = -1;
+}
+
+void PerformanceOverlay::measureGravity(Clock::time_point now) {
+  double intervalMs =
+      std::chrono::duration<double, std::milli>(now - lastGravity_).count();
+  if (lastGravityIntervalMs_ >= 0) {
+    double difference = std::abs(intervalMs - lastGravityIntervalMs_);
+    gravityJitterMs_ += (difference - gravityJitterMs_) / 16;
+  }
+  lastGravityIntervalMs_ = intervalMs;
+  lastGravity_ = now;
+}
+
+void PerformanceOverlay::reset(Clock::time_point now) {
+  lastUpdate_ = now;
+  renderedFrames_ = tm_->getRenderedFrames();
+  bytesWritten_ = tm_->getBytesWritten();
+  allocations_ = AllocationTracker::threadCounts().allocations;
+  updateTicks_ = ticks_;
+  long long inputs, inputTotalUs, inputMaxUs;
+  tm_->takeInputToDraw(&inputs, &inputTotalUs, &inputMaxUs);
+}
+
+void PerformanceOverlay::update(Clock::time_point now) {
+  double seconds = std::chrono::duration<double>(now - lastUpdate_).count();
+  long long frames = tm_->getRenderedFrames() - renderedFrames_;
+  long long bytes = tm_->getBytesWritten() - bytesWritten_;
+  long long inputs, inputTotalUs, inputMaxUs;
+  tm_->takeInputToDraw(&inputs, &inputTotalUs, &inputMaxUs);
+
+  // Fixed buffers, drawing the overlay doesn't allocate either.
+  char text[lines][24];
+  snprintf(text[0], sizeof(text[0]), "PERFORMANCE         ");
+  snprintf(text[1], sizeof(text[1]), "FPS       %10.1f",
+           seconds > 0 ? frames / seconds : 0.0);
+  snprintf(text[2], sizeof(text[2]), "INPUT MS  %10.2f",
+           inputs > 0 ? inputTotalUs / 1000.0 / inputs : 0.0);
+  snprintf(text[3], sizeof(text[3]), "INPUT MAX %10.2f", inputMaxUs / 1000.0);
+  snprintf(text[4], sizeof(text[4]), "JITTER MS %10.2f", gravityJitterMs_);
+  snprintf(text[5], sizeof(text[5]), "BYTES/FR  %10lld",
+           frames > 0 ? bytes / frames : 0);
+#ifdef TETRIS_TRACK_ALLOCATIONS
+  long long ticks = ticks_ - updateTicks_;
+  long long allocations =
+      AllocationTracker::threadCounts().allocations - allocations_;
+  snprintf(text[6], sizeof(text[6]), "ALLOC/FR  %10.2f",
+           ticks > 0 ? (double)allocations / ticks : 0.0);
+#else
+  // Allocations are only counted in the instrumentation build.
+  snprintf(text[6], sizeof(text[6]), "ALLOC/FR         n/a");
+#endif
+  snprintf(text[7], sizeof(text[7]), "DROPPED   %10lld",
+           tm_->getDroppedFrames());
+  for (int i = 0; i < lines; i++) {
+    tm_->drawString(row_ + i, col_, (int)NamedColors::WHITE, text[i]);
+  }
+  tm_->refresh();
+  reset(now);
+}
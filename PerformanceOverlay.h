@@ -0,0 +1,65 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Interarrival jitter:
+// https://www.rfc-editor.org/rfc/rfc3550#section-6.4.1
+//
+
+#pragma once
+#include "./AbstractTerminalManager.h"
+#include <chrono>
+
+// Performance overlay of the game: frames per second, input to draw
+// latency, gravity jitter, bytes written per frame, allocations per frame
+// (only in the make tracked build) and dropped frames. The counters come
+// from the terminal manager, the overlay draws into it as well.
+//
+// The values are over the time since the last update, which happens every
+// `updateMs` while the overlay is visible.
+class PerformanceOverlay {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  static constexpr int lines = 8;
+  static constexpr int updateMs = 500;
+
+  // The overlay is drawn from (`row`, `col`) downwards.
+  PerformanceOverlay(AbstractTerminalManager *tm, int row, int col)
+      : tm_(tm), row_(row), col_(col) {}
+
+  // Show / hide it.
+  void toggle(Clock::time_point now);
+  bool isVisible() const { return isVisible_; }
+
+  // One tick of the game loop (a frame), updates the overlay when it is
+  // time.
+  void tick(Clock::time_point now);
+
+  // Gravity tick jitter (like in RFC 3550): running mean of the difference
+  // between two gravity intervals of the same tetromino. A new tetromino
+  // starts without a previous interval.
+  void startTetromino(Clock::time_point now);
+  void measureGravity(Clock::time_point now);
+  double getGravityJitterMs() const { return gravityJitterMs_; }
+
+private:
+  // Start new measurement periods.
+  void reset(Clock::time_point now);
+  void update(Clock::time_point now);
+
+  AbstractTerminalManager *tm_;
+  int row_;
+  int col_;
+  bool isVisible_ = false;
+  long long ticks_ = 0;
+  // Counters at the last update.
+  Clock::time_point lastUpdate_;
+  long long renderedFrames_ = 0;
+  long long bytesWritten_ = 0;
+  long long allocations_ = 0;
+  long long updateTicks_ = 0;
+
+  Clock::time_point lastGravity_;
+  double lastGravityIntervalMs_ = -1;
+  double gravityJitterMs_ = 0;
+};
@@ -0,0 +1,51 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// SplitMix64 is described here:
+// https://prng.di.unimi.it/splitmix64.c
+//
+
+#include "./PieceGenerator.h"
+
+void PieceGenerator::reset(uint64_t seed) {
+  rngState_ = seed;
+  previous_ = -1;
+  pending_ = -1;
+}
+
+void PieceGenerator::setState(const State &state) {
+  rngState_ = state.rngState;
+  previous_ = state.previous;
+  pending_ = state.pending;
+}
+
+int PieceGenerator::randomIndex() {
+  // SplitMix64 step. Small state and good enough for a game.
+  rngState_ += 0x9e3779b97f4a7c15;
+  uint64_t z = rngState_;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  z = z ^ (z >> 31);
+
+  // Use the upper bits, the bias for 7 values is negligible.
+  return static_cast<int>((z >> 32) % 7);
+}
+
+int PieceGenerator::nextPiece() {
+  if (pending_ != -1) {
+    int piece = pending_;
+    pending_ = -1;
+    return piece;
+  }
+
+  // Same as generateCurrentAndNext: new pair, current must be
+  // different from next and from the previous next.
+  int current = randomIndex();
+  int next = randomIndex();
+  while (current == previous_ || current == next) {
+    current = randomIndex();
+  }
+  previous_ = next;
+  pending_ = next;
+  return current;
+}
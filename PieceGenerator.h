@@ -0,0 +1,41 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#pragma once
+#include <cstdint>
+
+// Seeded source of tetromino indices for headless games.
+//
+// It follows the same rules as AbstractTetrisGame::generateCurrentAndNext:
+// tetrominos are generated in pairs (current, next), where current differs
+// from next and from the "next" of the previous pair. Unlike the game it
+// uses a small explicit state, so the same seed always gives the same
+// sequence, and the state can be saved and restored cheaply.
+class PieceGenerator {
+public:
+  explicit PieceGenerator(uint64_t seed = 0) { reset(seed); }
+
+  void reset(uint64_t seed);
+
+  // Next tetromino index in [0, 6].
+  int nextPiece();
+
+  // Whole state of the generator (for snapshots and undo).
+  struct State {
+    uint64_t rngState;
+    int previous;
+    int pending;
+  };
+  State getState() const { return State{rngState_, previous_, pending_}; }
+  void setState(const State &state);
+
+private:
+  // Uniform random number in [0, 6].
+  int randomIndex();
+
+  uint64_t rngState_;
+  // "next" of the previous pair (-1 at the beginning).
+  int previous_;
+  // Second tetromino of the current pair, if it wasn't handed out yet.
+  int pending_;
+};
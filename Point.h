@@ -18,7 +18,8 @@ enum class NamedColors {
   TETROMINO_S,
   TETROMINO_Z,
   TETROMINO_T,
-  WHITE
+  WHITE,
+  GHOST
 };
 
 // Simple class to represent a point on a screen
@@ -0,0 +1,273 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./SimdBoards.h"
+#include <algorithm>
+#include <cstring>
+
+// AVX2 code is compiled with a target attribute, so the rest of the
+// program doesn't need -mavx2 and still runs on older CPUs.
+#if defined(__x86_64__) && defined(__GNUC__)
+#define TETRIS_X86_SIMD
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows of every orientation moved to its highest row, without shift.
+struct PieceMasks {
+  PieceMasks();
+  uint16_t rows[7][4][4];
+};
+
+PieceMasks::PieceMasks() {
+  std::memset(rows, 0, sizeof(rows));
+  for (int piece = 0; piece < 7; piece++) {
+    for (int o = 0; o < BitBoard::numberOfOrientations(piece); o++) {
+      const Orientation &orientation = BitBoard::getOrientation(piece, o);
+      int minRow = *std::min_element(orientation.rows, orientation.rows + 4);
+      for (int i = 0; i < 4; i++) {
+        int row = orientation.rows[i] - minRow;
+        rows[piece][o][row] |= 1 << orientation.cols[i];
+      }
+    }
+  }
+}
+
+const PieceMasks &pieceMasks() {
+  static const PieceMasks masks;
+  return masks;
+}
+
+} // namespace
+
+SimdBoards::SimdBoards() : useAvx2_(hasAvx2()) { clear(); }
+
+bool SimdBoards::hasAvx2() {
+#ifdef TETRIS_X86_SIMD
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+void SimdBoards::clear() {
+  for (int lane = 0; lane < lanes; lane++) {
+    clear(lane);
+  }
+}
+
+void SimdBoards::clear(int lane) {
+  for (int row = 0; row < BitBoard::rows; row++) {
+    rows_[row][lane] = 0;
+  }
+  for (int row = BitBoard::rows; row < paddedRows; row++) {
+    rows_[row][lane] = 0xffff;
+  }
+}
+
+void SimdBoards::setBoard(int lane, const BitBoard &board) {
+  for (int row = 0; row < BitBoard::rows; row++) {
+    rows_[row][lane] = board.getRow(row);
+  }
+}
+
+BitBoard SimdBoards::getBoard(int lane) const {
+  BitBoard board;
+  for (int row = 0; row < BitBoard::rows; row++) {
+    for (int col = 0; col < BitBoard::cols; col++) {
+      if ((rows_[row][lane] >> col) & 1) {
+        board.setCell(row, col);
+      }
+    }
+  }
+  return board;
+}
+
+void SimdBoards::buildPieceRows(const int8_t *pieces,
+                                const int8_t *orientations,
+                                const int8_t *shifts, PieceRows *piece) const {
+  const PieceMasks &masks = pieceMasks();
+  for (int lane = 0; lane < lanes; lane++) {
+    const uint16_t *rows = masks.rows[pieces[lane]][orientations[lane]];
+    int shift = shifts[lane];
+    for (int r = 0; r < 4; r++) {
+      piece->rows[r][lane] =
+          shift >= 0 ? rows[r] << shift : rows[r] >> -shift;
+    }
+  }
+}
+
+void SimdBoards::drop(const int8_t *pieces, const int8_t *orientations,
+                      const int8_t *shifts, int8_t *removedRows) {
+  PieceRows piece;
+  buildPieceRows(pieces, orientations, shifts, &piece);
+
+  uint32_t gameOver = 0;
+  uint32_t hasFullRows =
+      useAvx2_ ? dropAvx2(piece, &gameOver) : dropScalar(piece, &gameOver);
+
+  for (int lane = 0; lane < lanes; lane++) {
+    if ((gameOver >> lane) & 1) {
+      removedRows[lane] = -1;
+    } else if ((hasFullRows >> lane) & 1) {
+      removedRows[lane] = clearFullRows(lane);
+    } else {
+      removedRows[lane] = 0;
+    }
+  }
+}
+
+uint32_t SimdBoards::dropScalar(const PieceRows &piece, uint32_t *gameOver) {
+  uint32_t hasFullRows = 0;
+
+  for (int lane = 0; lane < lanes; lane++) {
+    auto collides = [&](int y) {
+      uint16_t hit = 0;
+      for (int r = 0; r < 4; r++) {
+        hit |= rows_[y + r][lane] & piece.rows[r][lane];
+      }
+      return hit != 0;
+    };
+
+    if (collides(0)) {
+      *gameOver |= 1u << lane;
+      continue;
+    }
+    // Nothing to hit above the highest occupied row.
+    int top = 0;
+    while (rows_[top][lane] == 0) {
+      top += 1;
+    }
+    int y = std::max(0, top - 4);
+    while (!collides(y + 1)) {
+      y += 1;
+    }
+
+    for (int r = 0; r < 4; r++) {
+      rows_[y + r][lane] |= piece.rows[r][lane];
+    }
+    // Same rule as BitBoard::apply: touching row 0 is game over.
+    if (y == 0) {
+      *gameOver |= 1u << lane;
+    }
+    for (int r = 0; r < 4 && y + r < BitBoard::rows; r++) {
+      if (rows_[y + r][lane] == BitBoard::fullRow) {
+        hasFullRows |= 1u << lane;
+      }
+    }
+  }
+  return hasFullRows;
+}
+
+#ifdef TETRIS_X86_SIMD
+
+namespace {
+
+// One bit per 16 bit lane of a comparison result.
+__attribute__((target("avx2"))) uint32_t laneMask(__m256i compared) {
+  uint32_t bytes = _mm256_movemask_epi8(compared);
+  uint32_t mask = 0;
+  for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+    mask |= ((bytes >> (2 * lane)) & 1) << lane;
+  }
+  return mask;
+}
+
+// All ones in the lanes where the tetromino rows `p` hit something when
+// their highest row is at row y.
+__attribute__((target("avx2"))) __m256i
+collidesAt(const uint16_t (*rows)[SimdBoards::lanes], const __m256i *p,
+           int y) {
+  __m256i hit = _mm256_setzero_si256();
+  for (int r = 0; r < 4; r++) {
+    __m256i row =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(rows[y + r]));
+    hit = _mm256_or_si256(hit, _mm256_and_si256(row, p[r]));
+  }
+  return _mm256_xor_si256(_mm256_cmpeq_epi16(hit, _mm256_setzero_si256()),
+                          _mm256_set1_epi16(-1));
+}
+
+} // namespace
+
+__attribute__((target("avx2"))) uint32_t
+SimdBoards::dropAvx2(const PieceRows &piece, uint32_t *gameOver) {
+  const __m256i zero = _mm256_setzero_si256();
+  __m256i p[4];
+  for (int r = 0; r < 4; r++) {
+    p[r] =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(piece.rows[r]));
+  }
+
+  // Lanes that can't spawn don't fall.
+  __m256i blocked = collidesAt(rows_, p, 0);
+  *gameOver = laneMask(blocked);
+  __m256i falling = _mm256_andnot_si256(blocked, _mm256_set1_epi16(-1));
+
+  // Nothing to hit above the highest occupied row of all lanes.
+  int top = 0;
+  while (true) {
+    __m256i row =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(rows_[top]));
+    if (!_mm256_testz_si256(row, row)) {
+      break;
+    }
+    top += 1;
+  }
+
+  // Every step moves all falling tetrominos one row down. The ones that
+  // would hit something are placed at the current row.
+  for (int y = std::max(0, top - 4); y < BitBoard::rows; y++) {
+    __m256i landing = _mm256_and_si256(falling, collidesAt(rows_, p, y + 1));
+    if (!_mm256_testz_si256(landing, landing)) {
+      for (int r = 0; r < 4; r++) {
+        __m256i *target = reinterpret_cast<__m256i *>(rows_[y + r]);
+        _mm256_store_si256(
+            target, _mm256_or_si256(_mm256_load_si256(target),
+                                    _mm256_and_si256(p[r], landing)));
+      }
+      if (y == 0) {
+        *gameOver |= laneMask(landing);
+      }
+      falling = _mm256_andnot_si256(landing, falling);
+    }
+    if (_mm256_testz_si256(falling, falling)) {
+      break;
+    }
+  }
+
+  __m256i full = zero;
+  const __m256i fullRow = _mm256_set1_epi16(BitBoard::fullRow);
+  for (int y = 0; y < BitBoard::rows; y++) {
+    __m256i row =
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(rows_[y]));
+    full = _mm256_or_si256(full, _mm256_cmpeq_epi16(row, fullRow));
+  }
+  return laneMask(full);
+}
+
+#else
+
+uint32_t SimdBoards::dropAvx2(const PieceRows &piece, uint32_t *gameOver) {
+  return dropScalar(piece, gameOver);
+}
+
+#endif
+
+int SimdBoards::clearFullRows(int lane) {
+  int removedRows = 0;
+  int target = BitBoard::rows - 1;
+  for (int row = BitBoard::rows - 1; row >= 0; row--) {
+    if (rows_[row][lane] == BitBoard::fullRow) {
+      removedRows += 1;
+      continue;
+    }
+    rows_[target][lane] = rows_[row][lane];
+    target -= 1;
+  }
+  for (int row = target; row >= 0; row--) {
+    rows_[row][lane] = 0;
+  }
+  return removedRows;
+}
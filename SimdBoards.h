@@ -0,0 +1,72 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Intel intrinsics guide (AVX2 functions used here):
+// https://www.intel.com/content/www/us/en/docs/intrinsics-guide/index.html
+//
+
+#pragma once
+#include "./BitBoard.h"
+#include <cstdint>
+
+// Many boards stored "structure of arrays": row r of all boards lies next
+// to each other in memory (one 16 bit lane per board), so one AVX2
+// instruction works on row r of all 16 boards at once. Used for bulk
+// simulation (random rollouts), separate from the game and HeadlessGame.
+//
+// A tetromino is dropped straight down in its column, starting with its
+// highest cell in row 0. The sideways movement at the top of the field is
+// not checked, which only matters for very high stacks.
+//
+// Dropping, collision tests and finding full rows run on all boards at
+// once. Removing full rows is done board by board, but only for the boards
+// that have full rows. Without AVX2 the same steps run in plain loops.
+class SimdBoards {
+public:
+  static constexpr int lanes = 16;
+
+  SimdBoards();
+
+  // Empty all boards or one board.
+  void clear();
+  void clear(int lane);
+
+  void setBoard(int lane, const BitBoard &board);
+  BitBoard getBoard(int lane) const;
+
+  // Drop one tetromino on every board: lane i gets `pieces[i]` in
+  // orientation `orientations[i]`, moved by `shifts[i]` columns (see
+  // Placement). The placement must be inside the walls. Writes the removed
+  // rows of each board into `removedRows`, or -1 if the game on that board
+  // is over (it can't spawn or it was placed on row 0).
+  void drop(const int8_t *pieces, const int8_t *orientations,
+            const int8_t *shifts, int8_t *removedRows);
+
+  // True if the CPU has AVX2, then drop() uses it.
+  static bool hasAvx2();
+  bool isUsingAvx2() const { return useAvx2_; }
+  // Use plain loops even if AVX2 is there (for tests and benchmarks).
+  void setUseAvx2(bool useAvx2) { useAvx2_ = useAvx2 && hasAvx2(); }
+
+private:
+  // Four rows of floor below the field, so a tetromino needs no
+  // bounds check while falling.
+  static constexpr int paddedRows = BitBoard::rows + 4;
+
+  // Tetromino rows of every lane, row 0 is its highest row.
+  struct PieceRows {
+    alignas(32) uint16_t rows[4][lanes];
+  };
+  void buildPieceRows(const int8_t *pieces, const int8_t *orientations,
+                      const int8_t *shifts, PieceRows *piece) const;
+
+  // Returns a bit for every lane that has a full row.
+  uint32_t dropScalar(const PieceRows &piece, uint32_t *gameOver);
+  uint32_t dropAvx2(const PieceRows &piece, uint32_t *gameOver);
+
+  // Remove full rows of one lane, returns their number.
+  int clearFullRows(int lane);
+
+  alignas(32) uint16_t rows_[paddedRows][lanes];
+  bool useAvx2_;
+};
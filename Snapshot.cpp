@@ -0,0 +1,120 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Snapshot.h"
+#include "./Point.h"
+#include <cstddef>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+void GameSnapshot::seal() {
+  snapshotMagic = magic;
+  snapshotVersion = version;
+  size = sizeof(GameSnapshot);
+  checksum = computeChecksum();
+}
+
+bool GameSnapshot::isValid() const {
+  return snapshotMagic == magic && snapshotVersion == version &&
+         size == sizeof(GameSnapshot) && checksum == computeChecksum();
+}
+
+bool GameSnapshot::isPlayable() const {
+  auto isPiece = [](int8_t piece) { return piece >= -1 && piece < 7; };
+  if (!isPiece(currentPiece) || !isPiece(nextPiece) ||
+      !isPiece(pendingPiece) || !isPiece(previousPiece)) {
+    return false;
+  }
+  if (level < 0 || previousQuotient < 0 || lines < 0) {
+    return false;
+  }
+  for (int i = 0; i < rows; i++) {
+    if (boardRows[i] >> cols != 0) {
+      return false;
+    }
+    for (int j = 0; j < cols; j++) {
+      if ((boardRows[i] >> j & 1) &&
+          colors[i][j] > static_cast<uint8_t>(NamedColors::GHOST)) {
+        return false;
+      }
+    }
+  }
+  if (currentPiece != -1) {
+    if (currentAngle < 0 || currentAngle > 3) {
+      return false;
+    }
+    for (int i = 0; i < 4; i++) {
+      if (currentRows[i] < -maxRowsAbove || currentRows[i] >= rows ||
+          currentCols[i] < 0 || currentCols[i] >= cols) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+uint32_t GameSnapshot::computeChecksum() const {
+  // Everything after the header.
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(this);
+  uint32_t hash = 2166136261u;
+  for (size_t i = offsetof(GameSnapshot, rngState); i < sizeof(GameSnapshot);
+       i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+bool GameSnapshot::save(const std::string &path) const {
+  std::string temporaryPath = path + ".tmp";
+  FILE *file = fopen(temporaryPath.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  bool isWritten = fwrite(this, sizeof(GameSnapshot), 1, file) == 1;
+  isWritten = fclose(file) == 0 && isWritten;
+  if (!isWritten || rename(temporaryPath.c_str(), path.c_str()) != 0) {
+    remove(temporaryPath.c_str());
+    return false;
+  }
+  return true;
+}
+
+// ____________________________________________________________________________
+MappedSnapshot::~MappedSnapshot() {
+  if (snapshot_ != nullptr) {
+    munmap(const_cast<GameSnapshot *>(snapshot_), sizeof(GameSnapshot));
+  }
+}
+
+bool MappedSnapshot::open(const std::string &path) {
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  // A shorter file would fault when the mapping is read.
+  struct stat status;
+  if (fstat(fd, &status) == -1 || status.st_size != sizeof(GameSnapshot)) {
+    close(fd);
+    return false;
+  }
+  void *memory =
+      mmap(nullptr, sizeof(GameSnapshot), PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+
+  const GameSnapshot *snapshot = static_cast<const GameSnapshot *>(memory);
+  if (!snapshot->isValid() || !snapshot->isPlayable()) {
+    munmap(memory, sizeof(GameSnapshot));
+    return false;
+  }
+  if (snapshot_ != nullptr) {
+    munmap(const_cast<GameSnapshot *>(snapshot_), sizeof(GameSnapshot));
+  }
+  snapshot_ = snapshot;
+  return true;
+}
@@ -0,0 +1,100 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// FNV-1a hash (used as checksum):
+// http://www.isthe.com/chongo/tech/comp/fnv/index.html
+//
+
+#pragma once
+#include "./BitBoard.h"
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+// Complete state of a game in a fixed binary layout: the file is the
+// struct, so loading it is one mmap and a checksum, without parsing.
+// Used to restart a game quickly, to reproduce bugs and to start
+// benchmarks from a position in the middle of a game.
+//
+// Cells are addressed like in Zobrist.h: row 0 is the spawn row, column 0
+// the first column right of the left wall. Fields are ordered by size, so
+// the struct has no padding and the checksum covers every byte.
+struct GameSnapshot {
+  static constexpr uint32_t magic = 0x50534e54;
+  // Increase on every change of the layout.
+  static constexpr uint32_t version = 2;
+  static constexpr int rows = BitBoard::rows;
+  static constexpr int cols = BitBoard::cols;
+  static constexpr int maxRowsAbove = 4;
+
+  // Header, filled by seal().
+  uint32_t snapshotMagic;
+  uint32_t snapshotVersion;
+  uint32_t size;
+  uint32_t checksum;
+
+  // State of the tetromino generator (same as PieceGenerator::State).
+  uint64_t rngState;
+
+  int32_t level;
+  int32_t previousQuotient;
+  int32_t lines;
+  int32_t score;
+  int32_t statistics[7];
+
+  // Bit j of boardRows[i] is the cell in row i and column j.
+  uint16_t boardRows[rows];
+  // NamedColors of the occupied cells.
+  uint8_t colors[rows][cols];
+
+  // Tetromino indices, -1 if there is none. `pending` is the second
+  // tetromino of a generated pair that isn't in the preview yet and
+  // `previous` is the "next" of the last generated pair.
+  int8_t currentPiece;
+  int8_t nextPiece;
+  int8_t pendingPiece;
+  int8_t previousPiece;
+  // Rotation in quarter turns (0 - 3) and cells of the current tetromino
+  // (can be above row 0, down to row `-maxRowsAbove`).
+  int8_t currentAngle;
+  int8_t currentRows[4];
+  int8_t currentCols[4];
+  uint8_t reserved[7];
+
+  // Fill the header (call after all other fields are set).
+  void seal();
+  // Right magic, version, size and checksum.
+  bool isValid() const;
+  // All fields in range, so a game can continue it: tetromino indices,
+  // colors, rotation, the cells of the current tetromino on the board and
+  // no negative level or lines. The checksum only detects corruption,
+  // snapshots that are passed around can still be made up.
+  bool isPlayable() const;
+  uint32_t computeChecksum() const;
+
+  // Write the snapshot to `path` (replaced at once, so a process that has
+  // the old file mapped keeps a consistent copy).
+  bool save(const std::string &path) const;
+};
+
+static_assert(std::is_trivially_copyable<GameSnapshot>::value,
+              "A snapshot is written and mapped as raw bytes");
+static_assert(sizeof(GameSnapshot) == 328, "A snapshot has no padding");
+
+// A snapshot file mapped read only.
+class MappedSnapshot {
+public:
+  MappedSnapshot() = default;
+  ~MappedSnapshot();
+  MappedSnapshot(const MappedSnapshot &) = delete;
+  MappedSnapshot &operator=(const MappedSnapshot &) = delete;
+
+  // Returns false if the file can't be mapped or isn't a valid and
+  // playable snapshot.
+  bool open(const std::string &path);
+  // nullptr until open() succeeded.
+  const GameSnapshot *get() const { return snapshot_; }
+
+private:
+  const GameSnapshot *snapshot_ = nullptr;
+};
@@ -0,0 +1,425 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Spectator.h"
+#include "./Point.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+SpectatorBoard::SpectatorBoard() {
+  // Zero everything, so equal boards are equal bytes.
+  std::memset(this, 0, sizeof(*this));
+}
+
+SpectatorBoard SpectatorBoard::fromSnapshot(const GameSnapshot &snapshot) {
+  SpectatorBoard board;
+  std::memcpy(board.cells, snapshot.boardRows, sizeof(board.cells));
+  std::memcpy(board.colors, snapshot.colors, sizeof(board.colors));
+  // The falling tetromino, in the color of its kind (same order as
+  // TetrominoFactory).
+  if (snapshot.currentPiece >= 0) {
+    uint8_t color = static_cast<uint8_t>(NamedColors::TETROMINO_I) +
+                    snapshot.currentPiece;
+    for (int i = 0; i < 4; i++) {
+      int row = snapshot.currentRows[i];
+      int col = snapshot.currentCols[i];
+      if (row >= 0 && row < rows && col >= 0 && col < cols) {
+        board.cells[row] |= 1 << col;
+        board.colors[row][col] = color;
+      }
+    }
+  }
+  board.score = snapshot.score;
+  board.lines = snapshot.lines;
+  board.level = snapshot.level;
+  board.nextPiece = snapshot.nextPiece;
+  return board;
+}
+
+bool SpectatorBoard::operator==(const SpectatorBoard &other) const {
+  return std::memcmp(this, &other, sizeof(*this)) == 0;
+}
+
+// ____________________________________________________________________________
+bool SpectatorEncoder::encode(const SpectatorBoard &board,
+                              std::vector<uint8_t> *frame) {
+  bool isKeyframe = framesSinceKeyframe_ >= keyframeInterval;
+  SpectatorFrameHeader header;
+  std::memset(&header, 0, sizeof(header));
+  frame->resize(maxFrameBytes);
+  size_t size = sizeof(header);
+  for (int i = 0; i < SpectatorBoard::rows; i++) {
+    if (isKeyframe || board.cells[i] != last_.cells[i] ||
+        std::memcmp(board.colors[i], last_.colors[i], SpectatorBoard::cols)) {
+      SpectatorRow row;
+      row.cells = board.cells[i];
+      std::memcpy(row.colors, board.colors[i], SpectatorBoard::cols);
+      std::memcpy(frame->data() + size, &row, sizeof(row));
+      size += sizeof(row);
+      header.changedRows |= 1u << i;
+    }
+  }
+  bool isChanged = header.changedRows != 0 || board.score != last_.score ||
+                   board.lines != last_.lines || board.level != last_.level ||
+                   board.nextPiece != last_.nextPiece ||
+                   board.isGameOver != last_.isGameOver;
+  if (!isKeyframe && !isChanged) {
+    framesSinceKeyframe_ += 1;
+    frame->clear();
+    return false;
+  }
+
+  header.size = size - sizeof(header);
+  header.type = static_cast<uint8_t>(isKeyframe ? SpectatorFrameType::Keyframe
+                                                : SpectatorFrameType::Delta);
+  header.isGameOver = board.isGameOver;
+  header.frame = frame_;
+  header.score = board.score;
+  header.lines = board.lines;
+  header.level = board.level;
+  header.nextPiece = board.nextPiece;
+  std::memcpy(frame->data(), &header, sizeof(header));
+  frame->resize(size);
+
+  last_ = board;
+  frame_ += 1;
+  framesSinceKeyframe_ = isKeyframe ? 1 : framesSinceKeyframe_ + 1;
+  return true;
+}
+
+// ____________________________________________________________________________
+bool SpectatorDecoder::apply(const uint8_t *data, size_t size) {
+  SpectatorFrameHeader header;
+  if (size < sizeof(header)) {
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  size_t rows = __builtin_popcount(header.changedRows);
+  auto type = static_cast<SpectatorFrameType>(header.type);
+  if (size != sizeof(header) + header.size ||
+      header.size != rows * sizeof(SpectatorRow) ||
+      header.changedRows >> SpectatorBoard::rows != 0 ||
+      (type != SpectatorFrameType::Keyframe &&
+       type != SpectatorFrameType::Delta) ||
+      (type == SpectatorFrameType::Keyframe &&
+       rows != SpectatorBoard::rows)) {
+    return false;
+  }
+
+  if (hasFrame_ && header.frame != frame_ + 1) {
+    // Frames were skipped, deltas don't fit any more.
+    if (header.frame > frame_) {
+      missedFrames_ += header.frame - frame_ - 1;
+    }
+    hasBoard_ = false;
+  }
+  hasFrame_ = true;
+  frame_ = header.frame;
+  if (type == SpectatorFrameType::Keyframe) {
+    keyframes_ += 1;
+    hasBoard_ = true;
+  } else if (!hasBoard_) {
+    return true;
+  }
+
+  const uint8_t *rowData = data + sizeof(header);
+  for (int i = 0; i < SpectatorBoard::rows; i++) {
+    if ((header.changedRows >> i) & 1) {
+      SpectatorRow row;
+      std::memcpy(&row, rowData, sizeof(row));
+      rowData += sizeof(row);
+      board_.cells[i] = row.cells;
+      std::memcpy(board_.colors[i], row.colors, SpectatorBoard::cols);
+    }
+  }
+  board_.score = header.score;
+  board_.lines = header.lines;
+  board_.level = header.level;
+  board_.nextPiece = header.nextPiece;
+  board_.isGameOver = header.isGameOver;
+  return true;
+}
+
+bool popSpectatorFrame(MessageConnection *connection,
+                       std::vector<uint8_t> *frame) {
+  SpectatorFrameHeader header;
+  if (!connection->peek(&header, sizeof(header)) ||
+      connection->available() < sizeof(header) + header.size) {
+    return false;
+  }
+  frame->resize(sizeof(header) + header.size);
+  return connection->pop(frame->data(), frame->size());
+}
+
+// ____________________________________________________________________________
+SpectatorHub::~SpectatorHub() { stop(); }
+
+bool SpectatorHub::start(const std::string &path) {
+  listenFd_ = LocalSocket::listen(path);
+  epollFd_ = epoll_create1(0);
+  if (listenFd_ == -1 || epollFd_ == -1) {
+    stop();
+    return false;
+  }
+  path_ = path;
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listenFd_;
+  if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, listenFd_, &event) == -1) {
+    stop();
+    return false;
+  }
+  return true;
+}
+
+void SpectatorHub::stop() {
+  for (size_t fd = 0; fd < connections_.size(); fd++) {
+    if (connections_[fd] != nullptr) {
+      closeConnection(fd);
+    }
+  }
+  recentFrames_.clear();
+  if (listenFd_ != -1) {
+    close(listenFd_);
+    unlink(path_.c_str());
+    listenFd_ = -1;
+  }
+  if (epollFd_ != -1) {
+    close(epollFd_);
+    epollFd_ = -1;
+  }
+}
+
+void SpectatorHub::poll(int timeoutMs) {
+  epoll_event events[256];
+  int count = epoll_wait(epollFd_, events, 256, timeoutMs);
+  for (int i = 0; i < count; i++) {
+    int fd = events[i].data.fd;
+    if (fd == listenFd_) {
+      acceptConnections();
+      continue;
+    }
+    Connection *connection = connections_[fd].get();
+    if (connection == nullptr) {
+      continue;
+    }
+    bool isOpen = true;
+    if (events[i].events & EPOLLOUT) {
+      isOpen = write(connection);
+    }
+    if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+      isOpen = handleInput(connection) && isOpen;
+    }
+    if (!isOpen) {
+      closeConnection(fd);
+    } else {
+      updateEvents(connection);
+    }
+  }
+}
+
+void SpectatorHub::acceptConnections() {
+  while (true) {
+    int fd = LocalSocket::accept(listenFd_);
+    if (fd == -1) {
+      return;
+    }
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &event) == -1) {
+      close(fd);
+      continue;
+    }
+    if ((size_t)fd >= connections_.size()) {
+      connections_.resize(fd + 1);
+    }
+    connections_[fd] = std::make_unique<Connection>(fd);
+  }
+}
+
+bool SpectatorHub::handleInput(Connection *connection) {
+  bool isOpen = connection->connection.receive();
+  if (!connection->hasRole) {
+    SpectatorRole role;
+    if (!connection->connection.pop(&role, sizeof(role))) {
+      return isOpen;
+    }
+    if (role == SpectatorRole::Publisher && publisher_ == nullptr) {
+      connection->isPublisher = true;
+      publisher_ = connection;
+    } else if (role == SpectatorRole::Spectator) {
+      numberOfSpectators_ += 1;
+      // At most one keyframe interval, more than the limit of enqueue().
+      connection->queue.assign(recentFrames_.begin(), recentFrames_.end());
+    } else {
+      // A second publisher or not this protocol.
+      return false;
+    }
+    connection->hasRole = true;
+  }
+
+  if (!connection->isPublisher) {
+    // Spectators send nothing, only the hang up matters.
+    std::vector<uint8_t> ignored(connection->connection.available());
+    connection->connection.pop(ignored.data(), ignored.size());
+    return isOpen;
+  }
+
+  // One buffer per frame, shared by all spectators.
+  std::vector<uint8_t> data;
+  while (popSpectatorFrame(&connection->connection, &data)) {
+    SpectatorFrameHeader header;
+    std::memcpy(&header, data.data(), sizeof(header));
+    bool isKeyframe =
+        header.type == static_cast<uint8_t>(SpectatorFrameType::Keyframe);
+    publish(std::make_shared<const std::vector<uint8_t>>(std::move(data)),
+            isKeyframe);
+    data = std::vector<uint8_t>();
+  }
+  return isOpen;
+}
+
+void SpectatorHub::publish(const Frame &frame, bool isKeyframe) {
+  frames_ += 1;
+  if (isKeyframe) {
+    recentFrames_.clear();
+  }
+  if (isKeyframe || !recentFrames_.empty()) {
+    recentFrames_.push_back(frame);
+  }
+  for (const auto &connection : connections_) {
+    if (connection != nullptr && connection->hasRole &&
+        !connection->isPublisher) {
+      enqueue(connection.get(), frame, isKeyframe);
+      // Written at once, most spectators have room in their socket.
+      if (!connection->isWaitingForOutput) {
+        if (write(connection.get())) {
+          updateEvents(connection.get());
+        } else {
+          closeConnection(connection->connection.getFd());
+        }
+      }
+    }
+  }
+}
+
+void SpectatorHub::enqueue(Connection *spectator, const Frame &frame,
+                           bool isKeyframe) {
+  if (spectator->queue.size() >= maxQueuedFrames) {
+    // Too slow: drop what wasn't started and wait for a keyframe.
+    size_t keep = spectator->offset > 0 ? 1 : 0;
+    skippedFrames_ += spectator->queue.size() - keep;
+    spectator->queue.resize(keep);
+    spectator->isSkipping = true;
+  }
+  if (isKeyframe) {
+    spectator->isSkipping = false;
+  }
+  if (spectator->isSkipping) {
+    skippedFrames_ += 1;
+    return;
+  }
+  spectator->queue.push_back(frame);
+}
+
+bool SpectatorHub::write(Connection *spectator) {
+  const int maxBuffers = 16;
+  while (!spectator->queue.empty()) {
+    // Several frames in one call, straight from the shared buffers.
+    iovec buffers[maxBuffers];
+    int count = 0;
+    for (const Frame &frame : spectator->queue) {
+      if (count == maxBuffers) {
+        break;
+      }
+      size_t offset = count == 0 ? spectator->offset : 0;
+      buffers[count].iov_base = const_cast<uint8_t *>(frame->data()) + offset;
+      buffers[count].iov_len = frame->size() - offset;
+      count += 1;
+    }
+    msghdr message{};
+    message.msg_iov = buffers;
+    message.msg_iovlen = count;
+    ssize_t written = sendmsg(spectator->connection.getFd(), &message,
+                              MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (written == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    bytesSent_ += written;
+    size_t left = written;
+    while (left > 0) {
+      size_t rest = spectator->queue.front()->size() - spectator->offset;
+      if (left < rest) {
+        spectator->offset += left;
+        break;
+      }
+      left -= rest;
+      spectator->queue.pop_front();
+      spectator->offset = 0;
+    }
+  }
+  return true;
+}
+
+void SpectatorHub::updateEvents(Connection *spectator) {
+  bool isWaiting = !spectator->queue.empty();
+  if (isWaiting == spectator->isWaitingForOutput) {
+    return;
+  }
+  epoll_event event{};
+  event.events = isWaiting ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  event.data.fd = spectator->connection.getFd();
+  epoll_ctl(epollFd_, EPOLL_CTL_MOD, event.data.fd, &event);
+  spectator->isWaitingForOutput = isWaiting;
+}
+
+void SpectatorHub::closeConnection(int fd) {
+  Connection *connection = connections_[fd].get();
+  if (connection == publisher_) {
+    publisher_ = nullptr;
+  } else if (connection->hasRole) {
+    numberOfSpectators_ -= 1;
+  }
+  // Closing the descriptor also removes it from the epoll set.
+  connections_[fd].reset();
+}
+
+// ____________________________________________________________________________
+bool SpectatorPublisher::connect(const std::string &path) {
+  connection_ =
+      std::make_unique<MessageConnection>(LocalSocket::connect(path, 1000));
+  SpectatorRole role = SpectatorRole::Publisher;
+  if (!connection_->isOpen() || !connection_->send(&role, sizeof(role))) {
+    connection_.reset();
+    return false;
+  }
+  return true;
+}
+
+void SpectatorPublisher::publish(const SpectatorBoard &board) {
+  if (!isOpen()) {
+    return;
+  }
+  if (!connection_->flush()) {
+    connection_->close();
+    return;
+  }
+  if (connection_->pending() > maxPendingBytes) {
+    // The hub is behind: drop this frame. It isn't encoded, so the next
+    // delta has all changes since the last frame that was sent.
+    droppedFrames_ += 1;
+    return;
+  }
+  if (encoder_.encode(board, &frame_) &&
+      !connection_->queue(frame_.data(), frame_.size())) {
+    connection_->close();
+  }
+}
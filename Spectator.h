@@ -0,0 +1,215 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Keyframes and deltas as in video streams, sendmsg with several buffers:
+// https://man7.org/linux/man-pages/man2/sendmsg.2.html
+//
+
+#pragma once
+#include "./LocalSocket.h"
+#include "./Snapshot.h"
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+// What spectators see of a game: the board with colors, the falling
+// tetromino drawn into it, and the counters.
+struct SpectatorBoard {
+  static constexpr int rows = GameSnapshot::rows;
+  static constexpr int cols = GameSnapshot::cols;
+
+  // Bit j of a row is column j, colors are NamedColors.
+  uint16_t cells[rows];
+  uint8_t colors[rows][cols];
+  int32_t score;
+  int32_t lines;
+  int32_t level;
+  int8_t nextPiece;
+  uint8_t isGameOver;
+  // No padding, boards are compared as bytes.
+  uint8_t reserved[2];
+
+  SpectatorBoard();
+  static SpectatorBoard fromSnapshot(const GameSnapshot &snapshot);
+  bool operator==(const SpectatorBoard &other) const;
+};
+
+// Stream of a game for spectators. A frame is a SpectatorFrameHeader and one
+// SpectatorRow per set bit of changedRows, from the top down. A keyframe
+// has all rows, a delta only the rows that changed since the frame before.
+enum class SpectatorFrameType : uint8_t { Keyframe = 1, Delta = 2 };
+
+struct SpectatorFrameHeader {
+  // Bytes after the header.
+  uint16_t size;
+  uint8_t type;
+  uint8_t isGameOver;
+  // Counts all encoded frames, so a spectator sees which ones it missed.
+  uint32_t frame;
+  uint32_t changedRows;
+  int32_t score;
+  int32_t lines;
+  int32_t level;
+  int8_t nextPiece;
+  uint8_t reserved[3];
+};
+
+struct SpectatorRow {
+  uint16_t cells;
+  uint8_t colors[SpectatorBoard::cols];
+};
+
+static_assert(sizeof(SpectatorFrameHeader) == 28,
+              "SpectatorFrameHeader has no padding");
+static_assert(sizeof(SpectatorRow) == 12, "SpectatorRow has no padding");
+static_assert(sizeof(SpectatorBoard) == 256, "SpectatorBoard has no padding");
+
+// First byte on a connection to the hub.
+enum class SpectatorRole : uint8_t { Publisher = 'P', Spectator = 'S' };
+
+// Game side: turns boards into frames.
+class SpectatorEncoder {
+public:
+  // Calls of encode() between two keyframes, one second at 60 frames per
+  // second. They count without changes as well, so a spectator that was
+  // skipped never waits longer.
+  static constexpr int keyframeInterval = 60;
+  static constexpr size_t maxFrameBytes =
+      sizeof(SpectatorFrameHeader) +
+      SpectatorBoard::rows * sizeof(SpectatorRow);
+
+  // Encode the changes since the last frame into `frame`. Returns false if
+  // nothing changed and no keyframe is due (no frame then).
+  bool encode(const SpectatorBoard &board, std::vector<uint8_t> *frame);
+
+private:
+  SpectatorBoard last_;
+  uint32_t frame_ = 0;
+  int framesSinceKeyframe_ = keyframeInterval;
+};
+
+// Spectator side: rebuilds the board from the frames.
+class SpectatorDecoder {
+public:
+  // Apply one whole frame. Deltas are ignored until the next keyframe
+  // when frames are missing before them. Returns false if the frame is
+  // broken.
+  bool apply(const uint8_t *data, size_t size);
+
+  // A keyframe arrived and no frame is missing since.
+  bool hasBoard() const { return hasBoard_; }
+  const SpectatorBoard &getBoard() const { return board_; }
+  uint32_t getFrame() const { return frame_; }
+  long long getKeyframes() const { return keyframes_; }
+  // Frames the hub skipped for this spectator.
+  long long getMissedFrames() const { return missedFrames_; }
+
+private:
+  SpectatorBoard board_;
+  bool hasFrame_ = false;
+  bool hasBoard_ = false;
+  uint32_t frame_ = 0;
+  long long keyframes_ = 0;
+  long long missedFrames_ = 0;
+};
+
+// Take the next whole frame from a connection, false if there is none yet.
+bool popSpectatorFrame(MessageConnection *connection,
+                       std::vector<uint8_t> *frame);
+
+// Fan-out of one game to many spectators. The game connects as publisher
+// and sends frames; every frame is kept in one buffer that all spectators
+// share, so the hub never encodes or copies a frame per spectator. New
+// spectators start with the last keyframe and the deltas since then.
+//
+// Neither side waits for the other: a spectator whose socket is full gets
+// no more frames until the next keyframe, and the game drops frames when
+// the hub is slow.
+class SpectatorHub {
+public:
+  // Frames a spectator may have queued before it is skipped to the next
+  // keyframe, about half a second.
+  static constexpr size_t maxQueuedFrames = 32;
+
+  SpectatorHub() = default;
+  ~SpectatorHub();
+  SpectatorHub(const SpectatorHub &) = delete;
+  SpectatorHub &operator=(const SpectatorHub &) = delete;
+
+  // Listen on the socket `path`, false if that fails.
+  bool start(const std::string &path);
+  // Wait up to `timeoutMs` for the publisher and the spectators.
+  void poll(int timeoutMs);
+  void stop();
+
+  bool hasPublisher() const { return publisher_ != nullptr; }
+  int getSpectators() const { return numberOfSpectators_; }
+  long long getFrames() const { return frames_; }
+  long long getBytesSent() const { return bytesSent_; }
+  // Frames not sent to spectators that were too slow.
+  long long getSkippedFrames() const { return skippedFrames_; }
+
+private:
+  using Frame = std::shared_ptr<const std::vector<uint8_t>>;
+
+  struct Connection {
+    explicit Connection(int fd) : connection(fd) {}
+    // Only for reading, spectators are written with their queue.
+    MessageConnection connection;
+    bool hasRole = false;
+    bool isPublisher = false;
+    // Frames not written yet, the first one from `offset` on.
+    std::deque<Frame> queue;
+    size_t offset = 0;
+    bool isSkipping = false;
+    bool isWaitingForOutput = false;
+  };
+
+  void acceptConnections();
+  // Returns false if the connection has to be closed.
+  bool handleInput(Connection *connection);
+  void publish(const Frame &frame, bool isKeyframe);
+  void enqueue(Connection *spectator, const Frame &frame, bool isKeyframe);
+  // Write queued frames without waiting, false if the connection is closed.
+  bool write(Connection *spectator);
+  void updateEvents(Connection *spectator);
+  void closeConnection(int fd);
+
+  int epollFd_ = -1;
+  int listenFd_ = -1;
+  std::string path_;
+  // Indexed by file descriptor.
+  std::vector<std::unique_ptr<Connection>> connections_;
+  Connection *publisher_ = nullptr;
+  int numberOfSpectators_ = 0;
+  // The last keyframe and the deltas after it, for new spectators.
+  std::vector<Frame> recentFrames_;
+  long long frames_ = 0;
+  long long bytesSent_ = 0;
+  long long skippedFrames_ = 0;
+};
+
+// Game side of the hub: sends frames without ever waiting. Frames are
+// dropped before they are encoded, so the deltas stay right.
+class SpectatorPublisher {
+public:
+  // Bytes the game keeps for a slow hub before it drops frames.
+  static constexpr size_t maxPendingBytes = 16 * 1024;
+
+  // Connect to the hub at `path`, false if there is none.
+  bool connect(const std::string &path);
+  bool isOpen() const {
+    return connection_ != nullptr && connection_->isOpen();
+  }
+  // Encode and send the board if it changed.
+  void publish(const SpectatorBoard &board);
+  long long getDroppedFrames() const { return droppedFrames_; }
+
+private:
+  std::unique_ptr<MessageConnection> connection_;
+  SpectatorEncoder encoder_;
+  std::vector<uint8_t> frame_;
+  long long droppedFrames_ = 0;
+};
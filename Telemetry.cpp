@@ -0,0 +1,140 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Telemetry.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert(std::atomic<int64_t>::is_always_lock_free &&
+                  std::atomic<uint64_t>::is_always_lock_free,
+              "Atomics in shared memory must not need a lock");
+
+void FrameTimes::add(std::chrono::steady_clock::duration frameTime) {
+  frameTimesUs_[count_ % capacity] =
+      std::chrono::duration_cast<std::chrono::microseconds>(frameTime).count();
+  count_ += 1;
+}
+
+int64_t FrameTimes::percentileUs(int p) const {
+  int size = std::min<int64_t>(count_, capacity);
+  if (size == 0) {
+    return 0;
+  }
+  int64_t sorted[capacity];
+  std::copy(frameTimesUs_, frameTimesUs_ + size, sorted);
+  int index = std::min(size - 1, size * p / 100);
+  std::nth_element(sorted, sorted + index, sorted + size);
+  return sorted[index];
+}
+
+// ____________________________________________________________________________
+TelemetryWriter::~TelemetryWriter() { close(); }
+
+void TelemetryWriter::close() {
+  if (segment_ != nullptr) {
+    munmap(segment_, sizeof(TelemetrySegment));
+    shm_unlink(name_.c_str());
+    segment_ = nullptr;
+  }
+}
+
+bool TelemetryWriter::open(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+  if (fd == -1) {
+    return false;
+  }
+  if (ftruncate(fd, sizeof(TelemetrySegment)) == -1) {
+    ::close(fd);
+    shm_unlink(name.c_str());
+    return false;
+  }
+  void *memory = mmap(nullptr, sizeof(TelemetrySegment),
+                      PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  // The mapping stays valid without the descriptor.
+  ::close(fd);
+  if (memory == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    return false;
+  }
+
+  segment_ = static_cast<TelemetrySegment *>(memory);
+  name_ = name;
+  segment_->segmentVersion = TelemetrySegment::version;
+  segment_->sequence.store(0);
+  publish(TelemetrySnapshot());
+  segment_->segmentMagic = TelemetrySegment::magic;
+  return true;
+}
+
+void TelemetryWriter::publish(const TelemetrySnapshot &snapshot) {
+  if (segment_ == nullptr) {
+    return;
+  }
+  int64_t values[TelemetrySegment::numberOfCounters];
+  std::memcpy(values, &snapshot, sizeof(values));
+
+  uint64_t sequence = segment_->sequence.load(std::memory_order_relaxed);
+  segment_->sequence.store(sequence + 1, std::memory_order_relaxed);
+  // The odd sequence is visible before any counter changes.
+  std::atomic_thread_fence(std::memory_order_release);
+  for (int i = 0; i < TelemetrySegment::numberOfCounters; i++) {
+    segment_->counters[i].store(values[i], std::memory_order_relaxed);
+  }
+  segment_->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+// ____________________________________________________________________________
+TelemetryReader::~TelemetryReader() {
+  if (segment_ != nullptr) {
+    munmap(const_cast<TelemetrySegment *>(segment_),
+           sizeof(TelemetrySegment));
+  }
+}
+
+bool TelemetryReader::open(const std::string &name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd == -1) {
+    return false;
+  }
+  void *memory =
+      mmap(nullptr, sizeof(TelemetrySegment), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    return false;
+  }
+
+  segment_ = static_cast<const TelemetrySegment *>(memory);
+  if (segment_->segmentMagic != TelemetrySegment::magic ||
+      segment_->segmentVersion != TelemetrySegment::version) {
+    munmap(memory, sizeof(TelemetrySegment));
+    segment_ = nullptr;
+    return false;
+  }
+  return true;
+}
+
+bool TelemetryReader::read(TelemetrySnapshot *snapshot) const {
+  if (segment_ == nullptr) {
+    return false;
+  }
+  int64_t values[TelemetrySegment::numberOfCounters];
+  for (int attempt = 0; attempt < 1000; attempt++) {
+    uint64_t before = segment_->sequence.load(std::memory_order_acquire);
+    if (before % 2 == 1) {
+      continue;
+    }
+    for (int i = 0; i < TelemetrySegment::numberOfCounters; i++) {
+      values[i] = segment_->counters[i].load(std::memory_order_relaxed);
+    }
+    // All counters are read before the sequence is read again.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (segment_->sequence.load(std::memory_order_relaxed) == before) {
+      std::memcpy(snapshot, values, sizeof(values));
+      return true;
+    }
+  }
+  return false;
+}
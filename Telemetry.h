@@ -0,0 +1,106 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// POSIX shared memory:
+// https://man7.org/linux/man-pages/man7/shm_overview.7.html
+//
+// Sequence lock (consistent reads without a lock for the writer):
+// https://en.wikipedia.org/wiki/Seqlock
+//
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters of a running game that another process (TetrisMonitorMain) can
+// read. They live in a POSIX shared memory segment, so publishing is a
+// few stores into memory and never a system call.
+struct TelemetrySnapshot {
+  int64_t pid = 0;
+  int64_t piecesPlaced = 0;
+  int64_t lines = 0;
+  int64_t level = 0;
+  int64_t speedMs = 0;
+  int64_t score = 0;
+  // Time between two ticks of the game loop, in microseconds.
+  int64_t frameTimeP50Us = 0;
+  int64_t frameTimeP90Us = 0;
+  int64_t frameTimeP99Us = 0;
+  // Most keys waiting in the input queue since the last publish.
+  int64_t inputQueueDepth = 0;
+  int64_t droppedInputs = 0;
+  int64_t droppedFrames = 0;
+  // Search nodes of the last move of the bot (0 without --ai): created
+  // for it and taken over from the search of the move before.
+  int64_t botCreatedNodes = 0;
+  int64_t botReusedNodes = 0;
+  int64_t isGameOver = 0;
+};
+
+// Last `capacity` frame times, for the percentiles.
+class FrameTimes {
+public:
+  static constexpr int capacity = 256;
+
+  void add(std::chrono::steady_clock::duration frameTime);
+  // p in [0, 100], 0 if there are no frame times yet.
+  int64_t percentileUs(int p) const;
+
+private:
+  int64_t frameTimesUs_[capacity] = {};
+  int64_t count_ = 0;
+};
+
+// Layout of the shared memory segment.
+struct TelemetrySegment {
+  static constexpr uint64_t magic = 0x54455452495354ull;
+  static constexpr int version = 2;
+  static constexpr int numberOfCounters =
+      sizeof(TelemetrySnapshot) / sizeof(int64_t);
+
+  uint64_t segmentMagic;
+  int64_t segmentVersion;
+  // Odd while the writer changes the counters.
+  std::atomic<uint64_t> sequence;
+  std::atomic<int64_t> counters[numberOfCounters];
+};
+
+// Game side: creates the segment and publishes snapshots.
+class TelemetryWriter {
+public:
+  TelemetryWriter() = default;
+  ~TelemetryWriter();
+  TelemetryWriter(const TelemetryWriter &) = delete;
+  TelemetryWriter &operator=(const TelemetryWriter &) = delete;
+
+  // Create the segment `name` (like "/tetris"), returns false if it can't.
+  bool open(const std::string &name);
+  bool isOpen() const { return segment_ != nullptr; }
+  // Remove the segment. Monitors that have it open can still read it.
+  void close();
+  // Lock free and without system calls.
+  void publish(const TelemetrySnapshot &snapshot);
+
+private:
+  TelemetrySegment *segment_ = nullptr;
+  std::string name_;
+};
+
+// Monitor side: maps an existing segment read only.
+class TelemetryReader {
+public:
+  TelemetryReader() = default;
+  ~TelemetryReader();
+  TelemetryReader(const TelemetryReader &) = delete;
+  TelemetryReader &operator=(const TelemetryReader &) = delete;
+
+  // Returns false if there is no segment `name` or it has another version.
+  bool open(const std::string &name);
+  // Returns false if the writer was busy all the time (try again).
+  bool read(TelemetrySnapshot *snapshot) const;
+
+private:
+  const TelemetrySegment *segment_ = nullptr;
+};
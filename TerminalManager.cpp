@@ -2,7 +2,14 @@
 // Code snippets from the lectures where used
 
 #include "./TerminalManager.h"
+#include "./InputQueue.h"
+#include "./Trace.h"
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
 #include <ncurses.h>
+#include <string>
+#include <unistd.h>
 
 static constexpr size_t systemColors = 16;
 
@@ -20,6 +27,9 @@ bool UserInput::isMouseclick() const { return mouseRow_ != -1; }
 // Additional letters
 bool UserInput::isKeyA() const { return keycode_ == 'a'; }
 bool UserInput::isKeyS() const { return keycode_ == 's'; }
+bool UserInput::isKeySpace() const { return keycode_ == ' '; }
+bool UserInput::isKeyP() const { return keycode_ == 'p'; }
+bool UserInput::isKeyK() const { return keycode_ == 'k'; }
 
 bool UserInput::isRightRotationKey(char rightRotationKey) const {
   return keycode_ == rightRotationKey;
@@ -70,29 +80,162 @@ TerminalManager::TerminalManager(
   // Set the logical dimensions of the screen.
   numRows_ = LINES;
   numCols_ = COLS / 2;
+
+  terminalRows_ = LINES;
+  terminalCols_ = COLS;
+  drawing_.cells.resize(terminalRows_ * terminalCols_);
+  renderThread_ = std::thread(&TerminalManager::renderLoop, this);
 }
 
 // ____________________________________________________________________________
-TerminalManager::~TerminalManager() { endwin(); }
+TerminalManager::~TerminalManager() {
+  stopInputThread();
+  stopRenderThread();
+  endwin();
+}
 
 // ____________________________________________________________________________
-void TerminalManager::refresh() { ::refresh(); }
+long long TerminalManager::getBytesWritten() const {
+  // ncurses writes straight to the file descriptor of the terminal, so the
+  // bytes are counted by the kernel: "wchar" in /proc/self/io.
+  int fd = open("/proc/self/io", O_RDONLY);
+  if (fd == -1) {
+    return -1;
+  }
+  char buffer[512];
+  ssize_t size = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (size <= 0) {
+    return -1;
+  }
+  buffer[size] = '\0';
+  const char *wchar = strstr(buffer, "wchar: ");
+  return wchar == nullptr ? -1 : atoll(wchar + strlen("wchar: "));
+}
+
+// ____________________________________________________________________________
+void TerminalManager::markInput(std::chrono::steady_clock::time_point time) {
+  if (drawing_.inputTime == std::chrono::steady_clock::time_point() ||
+      time < drawing_.inputTime) {
+    drawing_.inputTime = time;
+  }
+}
+
+// ____________________________________________________________________________
+void TerminalManager::takeInputToDraw(long long *count, long long *totalUs,
+                                      long long *maxUs) {
+  *count = inputToDrawCount_.exchange(0);
+  *totalUs = inputToDrawTotalUs_.exchange(0);
+  *maxUs = inputToDrawMaxUs_.exchange(0);
+}
+
+// ____________________________________________________________________________
+void TerminalManager::refresh() {
+  TRACE_SCOPE("publishFrame");
+  // After the first three frames every slot has the right size, then this
+  // is a plain copy without allocation.
+  frames_.back() = drawing_;
+  if (!frames_.publish()) {
+    droppedFrames_ += 1;
+  }
+  publishedFrames_ += 1;
+  drawing_.inputTime = std::chrono::steady_clock::time_point();
+}
 
 // ____________________________________________________________________________
 void TerminalManager::drawPixel(int row, int col, int color) {
   if (color >= numColors_) {
     throw std::runtime_error("Invalid color given to drawPixel");
   }
-  attron(COLOR_PAIR(color + systemColors));
-  attron(A_REVERSE);
-  mvprintw(row, 2 * col, "  ");
-  attroff(A_REVERSE);
+  // Like ncurses, ignore what is outside of the terminal.
+  if (row < 0 || row >= terminalRows_ || col < 0 ||
+      2 * col + 1 >= terminalCols_) {
+    return;
+  }
+  Cell *cell = &drawing_.cells[row * terminalCols_ + 2 * col];
+  cell[0] = Cell{' ', (int8_t)color, true};
+  cell[1] = Cell{' ', (int8_t)color, true};
+}
+
+// ____________________________________________________________________________
+void TerminalManager::renderLoop() {
+  Trace::setThreadName("render");
+  Frame rendered;
+  rendered.cells.resize(terminalRows_ * terminalCols_);
+  while (true) {
+    // Read the flag first, so the last frame before stopping is written.
+    bool isStopping = stopRender_;
+    if (frames_.update()) {
+      const Frame &frame = frames_.front();
+      renderFrame(frame, &rendered);
+      renderedFrames_ += 1;
+      if (frame.inputTime != std::chrono::steady_clock::time_point()) {
+        long long us = std::chrono::duration_cast<std::chrono::microseconds>(
+                           std::chrono::steady_clock::now() - frame.inputTime)
+                           .count();
+        inputToDrawCount_ += 1;
+        inputToDrawTotalUs_ += us;
+        long long maxUs = inputToDrawMaxUs_;
+        while (us > maxUs &&
+               !inputToDrawMaxUs_.compare_exchange_weak(maxUs, us)) {
+        }
+      }
+    } else if (isStopping) {
+      return;
+    } else {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+
+// ____________________________________________________________________________
+void TerminalManager::renderFrame(const Frame &frame, Frame *previous) {
+  TRACE_SCOPE("renderFrame");
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::string run;
+  for (int row = 0; row < terminalRows_; row++) {
+    const Cell *cells = &frame.cells[row * terminalCols_];
+    Cell *previousCells = &previous->cells[row * terminalCols_];
+    int col = 0;
+    while (col < terminalCols_) {
+      if (cells[col] == previousCells[col] || cells[col].color < 0) {
+        col += 1;
+        continue;
+      }
+      // Changed cells next to each other with the same look are written
+      // with one call.
+      int start = col;
+      run.clear();
+      while (col < terminalCols_ && !(cells[col] == previousCells[col]) &&
+             cells[col].color == cells[start].color &&
+             cells[col].isReverse == cells[start].isReverse) {
+        run.push_back(cells[col].character);
+        previousCells[col] = cells[col];
+        col += 1;
+      }
+      attrset(COLOR_PAIR(cells[start].color + systemColors) |
+              (cells[start].isReverse ? A_REVERSE : A_NORMAL));
+      mvaddnstr(row, start, run.c_str(), run.size());
+    }
+  }
+  attrset(A_NORMAL);
+  ::refresh();
+}
+
+// ____________________________________________________________________________
+void TerminalManager::stopRenderThread() {
+  if (renderThread_.joinable()) {
+    stopRender_ = true;
+    renderThread_.join();
+  }
 }
 
 // ____________________________________________________________________________
 UserInput TerminalManager::getUserInput() {
+  std::lock_guard<std::mutex> lock(mutex_);
   UserInput userInput;
   userInput.keycode_ = getch();
+  userInput.timestamp_ = std::chrono::steady_clock::now();
   MEVENT event;
   if ((userInput.keycode_ == KEY_MOUSE) && (getmouse(&event) == OK)) {
     if (event.bstate & BUTTON1_PRESSED) {
@@ -108,6 +251,39 @@ void TerminalManager::drawString(int row, int col, int color, const char *str) {
   if (color >= numColors_) {
     throw std::runtime_error("Invalid color given to drawString");
   }
-  attron(COLOR_PAIR(color + systemColors));
-  mvprintw(row, 2 * col, "%s", str);
+  for (int i = 0; str[i] != '\0'; i++) {
+    int terminalCol = 2 * col + i;
+    if (row < 0 || row >= terminalRows_ || terminalCol < 0 ||
+        terminalCol >= terminalCols_) {
+      continue;
+    }
+    drawing_.cells[row * terminalCols_ + terminalCol] =
+        Cell{str[i], (int8_t)color, false};
+  }
+}
+
+// ____________________________________________________________________________
+void TerminalManager::startInputThread(InputQueue *queue) {
+  stopInputThread();
+  stopInput_ = false;
+  inputThread_ = std::thread([this, queue]() {
+    Trace::setThreadName("input");
+    while (!stopInput_) {
+      UserInput userInput = getUserInput();
+      if (userInput.keycode_ == ERR) {
+        // getch() doesn't block (nodelay), don't spin.
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        continue;
+      }
+      queue->push(userInput);
+    }
+  });
+}
+
+// ____________________________________________________________________________
+void TerminalManager::stopInputThread() {
+  if (inputThread_.joinable()) {
+    stopInput_ = true;
+    inputThread_.join();
+  }
 }
\ No newline at end of file
@@ -3,11 +3,19 @@
 
 #pragma once
 #include "./AbstractTerminalManager.h"
+#include "./TripleBuffer.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 #include <vector>
 
+class InputQueue;
+
 // Class to represent an RGB color.
 class Color {
 private:
@@ -44,6 +52,12 @@ public:
   bool isMouseclick() const;
   bool isKeyA() const;
   bool isKeyS() const;
+  // Space, hard drop.
+  bool isKeySpace() const;
+  // Shows / hides the performance overlay.
+  bool isKeyP() const;
+  // Saves a snapshot of the game.
+  bool isKeyK() const;
   bool isRightRotationKey(char rightRotationKey) const;
   bool isLeftRotationKey(char ritghtRotationKey) const;
 
@@ -51,9 +65,17 @@ public:
   int keycode_;
   int mouseRow_ = -1;
   int mouseCol_ = -1;
+  // When the key was read (set by the input thread).
+  std::chrono::steady_clock::time_point timestamp_;
 };
 
 // A class to draw pixels on or read input from the terminal, using ncurses.
+//
+// Drawing doesn't touch the terminal: pixels and strings go into a frame in
+// memory and refresh() publishes a copy of it to the render thread through
+// a triple buffer. The render thread writes only the cells that changed
+// since the frame it wrote last. So a slow terminal never blocks the game,
+// at worst frames are dropped (the render thread always takes the newest).
 class TerminalManager : public AbstractTerminalManager {
 public:
   // Constructor: Set up the terminal for use with ncurses commands.
@@ -72,9 +94,9 @@ public:
   void drawPixel(int row, int col, int color) override;
 
   // Draw a string at the given logical position and color.
-  void drawString(int row, int col, int color, const char *str);
+  void drawString(int row, int col, int color, const char *str) override;
 
-  // Show the contents of the screen.
+  // Show the contents of the screen (publish the frame).
   void refresh() override;
 
   // Return the logical dimensions of the screen.
@@ -84,9 +106,80 @@ public:
   // Get user input.
   UserInput getUserInput();
 
+  // Read keys on an own thread and push them (with a timestamp) into
+  // `queue`, until stopInputThread() is called. Then getUserInput() must
+  // not be called from other threads.
+  void startInputThread(InputQueue *queue);
+  void stopInputThread();
+
+  // Frames published by refresh() and frames the render thread wrote.
+  // Frames that were replaced by a newer one before the render thread took
+  // them are dropped.
+  long long getPublishedFrames() const { return publishedFrames_; }
+  long long getRenderedFrames() const override { return renderedFrames_; }
+  long long getDroppedFrames() const override { return droppedFrames_; }
+
+  // Bytes the program has written so far (during the game that is the
+  // output to the terminal, with escape sequences), -1 if unknown. Costs a
+  // few system calls.
+  long long getBytesWritten() const override;
+
+  // Input to draw latency: the next published frame shows a key read at
+  // `time`. The latency ends when the render thread has written the frame.
+  // Keys of dropped frames are not measured.
+  void markInput(std::chrono::steady_clock::time_point time);
+  // Keys measured, total and maximum latency in microseconds since the
+  // last call (the counters start again at 0).
+  void takeInputToDraw(long long *count, long long *totalUs,
+                       long long *maxUs) override;
+
 private:
+  // One character of the terminal. A pixel is two reversed spaces.
+  struct Cell {
+    char character = ' ';
+    // -1: never drawn.
+    int8_t color = -1;
+    bool isReverse = false;
+
+    bool operator==(const Cell &other) const {
+      return character == other.character && color == other.color &&
+             isReverse == other.isReverse;
+    }
+  };
+  struct Frame {
+    std::vector<Cell> cells;
+    // Oldest key shown for the first time in this frame (or 0).
+    std::chrono::steady_clock::time_point inputTime;
+  };
+
+  // Write a frame to the terminal, only cells that differ from `previous`.
+  void renderFrame(const Frame &frame, Frame *previous);
+  void renderLoop();
+  void stopRenderThread();
+
   // The logical dimensions of the screen.
   int numRows_;
   int numCols_;
   int numColors_;
+
+  // ncurses is not thread safe, every call holds this mutex.
+  std::mutex mutex_;
+  std::thread inputThread_;
+  std::atomic<bool> stopInput_{false};
+
+  // Size of the terminal in characters.
+  int terminalRows_;
+  int terminalCols_;
+  // Frame that the game draws into (only used by the game thread).
+  Frame drawing_;
+  TripleBuffer<Frame> frames_;
+  std::thread renderThread_;
+  std::atomic<bool> stopRender_{false};
+  long long publishedFrames_ = 0;
+  std::atomic<long long> renderedFrames_{0};
+  long long droppedFrames_ = 0;
+
+  std::atomic<long long> inputToDrawCount_{0};
+  std::atomic<long long> inputToDrawTotalUs_{0};
+  std::atomic<long long> inputToDrawMaxUs_{0};
 };
@@ -0,0 +1,231 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./TetrisBot.h"
+#include "./BatchEvaluator.h"
+#include "./Zobrist.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+EvaluationWeights EvaluationWeights::defaults() {
+  EvaluationWeights weights;
+  for (int i = 0; i < numberOfFeatures; i++) {
+    weights.values[i] = 0;
+  }
+
+  // Values from the "near perfect player" article, other features are off.
+  weights[Feature::AggregateHeight] = -0.510066;
+  weights[Feature::Holes] = -0.35663;
+  weights[Feature::Bumpiness] = -0.184483;
+  weights[Feature::RemovedRows] = 0.760666;
+  return weights;
+}
+
+const char *EvaluationWeights::featureName(int feature) {
+  static const char *names[numberOfFeatures] = {
+      "aggregateHeight", "holes",          "bumpiness",         "removedRows",
+      "wells",           "rowTransitions", "columnTransitions", "maxHeight"};
+  return names[feature];
+}
+
+bool EvaluationWeights::load(const std::string &path) {
+  std::ifstream file(path);
+  if (!file) {
+    return false;
+  }
+
+  std::string name;
+  double value;
+  while (file >> name >> value) {
+    for (int i = 0; i < numberOfFeatures; i++) {
+      if (name == featureName(i)) {
+        values[i] = value;
+      }
+    }
+  }
+  return true;
+}
+
+bool EvaluationWeights::save(const std::string &path) const {
+  std::ofstream file(path);
+  if (!file) {
+    return false;
+  }
+
+  file.precision(10);
+  for (int i = 0; i < numberOfFeatures; i++) {
+    file << featureName(i) << " " << values[i] << "\n";
+  }
+  return static_cast<bool>(file);
+}
+
+TetrisBot::TetrisBot(const EvaluationWeights &weights,
+                     TranspositionTable *table)
+    : weights_(weights), table_(table) {}
+
+void TetrisBot::computeFeatures(const BitBoard &board, int removedRows,
+                                double *features) {
+  const int rows = BitBoard::rows;
+  const int cols = BitBoard::cols;
+
+  int heights[cols];
+  for (int j = 0; j < cols; j++) {
+    heights[j] = board.columnHeight(j);
+  }
+
+  double aggregateHeight = 0;
+  double holes = 0;
+  double bumpiness = 0;
+  double wells = 0;
+  double maxHeight = 0;
+  double columnTransitions = 0;
+
+  for (int j = 0; j < cols; j++) {
+    aggregateHeight += heights[j];
+    if (heights[j] > maxHeight) {
+      maxHeight = heights[j];
+    }
+    if (j + 1 < cols) {
+      bumpiness += std::abs(heights[j] - heights[j + 1]);
+    }
+
+    // Walls count as full columns.
+    int left = j == 0 ? rows : heights[j - 1];
+    int right = j == cols - 1 ? rows : heights[j + 1];
+    int depth = std::min(left, right) - heights[j];
+    if (depth > 0) {
+      wells += depth * (depth + 1) / 2;
+    }
+
+    // Every empty cell below the top is a hole. Going down the column,
+    // the cell above the top is empty and the floor (bit `rows`) is full.
+    uint32_t column = board.getColumn(j);
+    if (column != 0) {
+      holes += heights[j] - __builtin_popcount(column);
+      uint32_t withFloor = column | (1u << rows);
+      columnTransitions += __builtin_popcount((withFloor ^ (withFloor << 1)) &
+                                             ((2u << rows) - 1));
+    }
+  }
+
+  // Changes between full and empty cells in each row, walls are full.
+  double rowTransitions = 0;
+  for (int i = rows - (int)maxHeight; i < rows; i++) {
+    unsigned row = (board.getRow(i) << 1) | 1 | (1 << (cols + 1));
+    rowTransitions += __builtin_popcount((row ^ (row >> 1)) &
+                                         ((1 << (cols + 1)) - 1));
+  }
+
+  features[(int)Feature::AggregateHeight] = aggregateHeight;
+  features[(int)Feature::Holes] = holes;
+  features[(int)Feature::Bumpiness] = bumpiness;
+  features[(int)Feature::RemovedRows] = removedRows;
+  features[(int)Feature::Wells] = wells;
+  features[(int)Feature::RowTransitions] = rowTransitions;
+  features[(int)Feature::ColumnTransitions] = columnTransitions;
+  features[(int)Feature::MaxHeight] = maxHeight;
+}
+
+double TetrisBot::evaluateBoard(const BitBoard &board) const {
+  double features[EvaluationWeights::numberOfFeatures];
+  computeFeatures(board, 0, features);
+
+  double score = 0;
+  for (int i = 0; i < EvaluationWeights::numberOfFeatures; i++) {
+    score += weights_.values[i] * features[i];
+  }
+  return score;
+}
+
+double TetrisBot::searchValue(const BitBoard &board, int piece, int nextPiece,
+                              int *bestMove) {
+  int depth = nextPiece == -1 ? 1 : 2;
+  uint64_t hash = board.getHash() ^ Zobrist::pieceKey(piece) ^
+                  Zobrist::previewKey(nextPiece);
+
+  // The same board is often reached through different placements.
+  TranspositionEntry entry;
+  if (table_ != nullptr && table_->probe(hash, &entry) &&
+      entry.depth >= depth && (bestMove == nullptr || entry.bestMove >= 0)) {
+    if (bestMove != nullptr) {
+      *bestMove = entry.bestMove;
+    }
+    return entry.score;
+  }
+
+  Placement placements[BitBoard::maxPlacements];
+  int count = board.generatePlacements(piece, placements);
+
+  BitBoard children[BitBoard::maxPlacements];
+  int removedRows[BitBoard::maxPlacements];
+  for (int i = 0; i < count; i++) {
+    children[i] = board;
+    removedRows[i] = children[i].apply(placements[i]);
+  }
+
+  // Last tetromino: evaluate all boards in one pass.
+  double boardValues[BitBoard::maxPlacements];
+  if (nextPiece == -1) {
+    BatchEvaluator batch;
+    int batchIndex[BitBoard::maxPlacements];
+    for (int i = 0; i < count; i++) {
+      if (removedRows[i] != -1) {
+        batchIndex[i] = batch.add(children[i]);
+      }
+    }
+    double values[BatchEvaluator::maxBoards];
+    batch.evaluate(weights_, values);
+    for (int i = 0; i < count; i++) {
+      if (removedRows[i] != -1) {
+        boardValues[i] = values[batchIndex[i]];
+      }
+    }
+    evaluatedBoards_ += batch.size();
+  }
+
+  double bestValue = gameOverScore;
+  int bestIndex = -1;
+
+  for (int i = 0; i < count; i++) {
+    double value;
+    if (removedRows[i] == -1) {
+      value = gameOverScore;
+    } else {
+      double rowsValue = weights_[Feature::RemovedRows] * removedRows[i];
+      if (nextPiece == -1) {
+        value = rowsValue + boardValues[i];
+      } else {
+        value = rowsValue + searchValue(children[i], nextPiece, -1, nullptr);
+      }
+    }
+
+    if (bestIndex == -1 || value > bestValue) {
+      bestValue = value;
+      bestIndex = i;
+    }
+  }
+
+  if (table_ != nullptr) {
+    table_->store(hash, bestValue, depth, bestIndex);
+  }
+  if (bestMove != nullptr) {
+    *bestMove = bestIndex;
+  }
+  return bestValue;
+}
+
+bool TetrisBot::choosePlacement(const BitBoard &board, int current, int next,
+                                Placement *best) {
+  int bestIndex = -1;
+  searchValue(board, current, next, &bestIndex);
+  if (bestIndex == -1) {
+    return false;
+  }
+
+  Placement placements[BitBoard::maxPlacements];
+  board.generatePlacements(current, placements);
+  *best = placements[bestIndex];
+  return true;
+}
@@ -0,0 +1,87 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// The features and the idea of tuning their weights come from here:
+// https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/
+// https://imake.ninja/el-tetris-an-improvement-on-pierre-dellacheries-algorithm/
+//
+
+#pragma once
+#include "./BitBoard.h"
+#include "./TranspositionTable.h"
+#include <string>
+
+// Features of a board that the bot uses to decide how good it is.
+// Order is important, it's the order of the weights.
+enum class Feature {
+  AggregateHeight,
+  Holes,
+  Bumpiness,
+  RemovedRows,
+  Wells,
+  RowTransitions,
+  ColumnTransitions,
+  MaxHeight
+};
+
+// Weights of the features. A board is evaluated as the sum of
+// weight * feature, so "bad" features should get negative weights.
+struct EvaluationWeights {
+  static constexpr int numberOfFeatures = 8;
+  double values[numberOfFeatures];
+
+  double &operator[](Feature feature) { return values[(int)feature]; }
+  double operator[](Feature feature) const { return values[(int)feature]; }
+
+  // Hand-picked weights that already play reasonably well.
+  static EvaluationWeights defaults();
+
+  // Text format: one "name value" pair per line. Returns false if the file
+  // can't be read or written.
+  bool load(const std::string &path);
+  bool save(const std::string &path) const;
+
+  static const char *featureName(int feature);
+};
+
+// Simple Tetris bot: tries all placements of the current tetromino (and of
+// the next one, if it is known) and takes the one that leads to the best
+// evaluated board.
+class TetrisBot {
+public:
+  // Table is optional and can be shared with other bots (threads).
+  explicit TetrisBot(const EvaluationWeights &weights,
+                     TranspositionTable *table = nullptr);
+
+  // Fill `features` (numberOfFeatures values) for the given board.
+  static void computeFeatures(const BitBoard &board, int removedRows,
+                              double *features);
+
+  // Evaluation of a board without the removed rows (they depend on the
+  // move, not on the board).
+  double evaluateBoard(const BitBoard &board) const;
+
+  // Choose placement for `current`. If `next` is not -1, the bot also
+  // looks at the placements of the next tetromino.
+  // Returns false if there is no possible placement.
+  bool choosePlacement(const BitBoard &board, int current, int next,
+                       Placement *best);
+
+  const EvaluationWeights &getWeights() const { return weights_; }
+
+  // Number of boards that were evaluated (for statistics).
+  long long getEvaluatedBoards() const { return evaluatedBoards_; }
+
+  // Value that means "this move loses the game".
+  static constexpr double gameOverScore = -1e9;
+
+private:
+  // Best value reachable from `board` if `piece` has to be placed next and
+  // (optionally) `nextPiece` after it.
+  double searchValue(const BitBoard &board, int piece, int nextPiece,
+                     int *bestMove);
+
+  EvaluationWeights weights_;
+  TranspositionTable *table_;
+  long long evaluatedBoards_ = 0;
+};
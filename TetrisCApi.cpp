@@ -0,0 +1,122 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./TetrisCApi.h"
+#include "./HeadlessGame.h"
+#include <algorithm>
+#include <new>
+
+// The handle is just the headless game.
+struct TetrisGameHandle {
+  HeadlessGame game;
+};
+
+static_assert(TETRIS_ROWS == BitBoard::rows, "TETRIS_ROWS");
+static_assert(TETRIS_COLS == BitBoard::cols, "TETRIS_COLS");
+static_assert(TETRIS_MAX_PLACEMENTS == BitBoard::maxPlacements,
+              "TETRIS_MAX_PLACEMENTS");
+
+int tetris_api_version(void) { return TETRIS_API_VERSION; }
+
+TetrisGameHandle *tetris_create(uint64_t seed, int level) {
+  TetrisGameHandle *handle = new (std::nothrow) TetrisGameHandle;
+  if (handle != nullptr) {
+    handle->game.reset(seed, level);
+  }
+  return handle;
+}
+
+void tetris_destroy(TetrisGameHandle *game) { delete game; }
+
+void tetris_reset(TetrisGameHandle *game, uint64_t seed, int level) {
+  if (game != nullptr) {
+    game->game.reset(seed, level);
+  }
+}
+
+int tetris_placements(const TetrisGameHandle *game,
+                      TetrisPlacement *placements, int capacity) {
+  if (game == nullptr || (placements == nullptr && capacity > 0)) {
+    return TETRIS_ERROR_ARGUMENT;
+  }
+  if (game->game.isGameOver()) {
+    return 0;
+  }
+
+  Placement all[BitBoard::maxPlacements];
+  int count = game->game.generatePlacements(all);
+  for (int i = 0; i < std::min(count, capacity); i++) {
+    placements[i] = TetrisPlacement{all[i].piece, all[i].orientation,
+                                    all[i].shift, all[i].dropRows};
+  }
+  return count;
+}
+
+int tetris_step(TetrisGameHandle *game, const TetrisPlacement *placement) {
+  if (game == nullptr || placement == nullptr) {
+    return TETRIS_ERROR_ARGUMENT;
+  }
+  if (game->game.isGameOver()) {
+    return -1;
+  }
+
+  // BitBoard::apply trusts its input, so only known placements
+  // get through.
+  Placement all[BitBoard::maxPlacements];
+  int count = game->game.generatePlacements(all);
+  for (int i = 0; i < count; i++) {
+    if (all[i].piece == placement->piece &&
+        all[i].orientation == placement->orientation &&
+        all[i].shift == placement->shift &&
+        all[i].dropRows == placement->dropRows) {
+      return game->game.play(all[i]);
+    }
+  }
+  return TETRIS_ERROR_PLACEMENT;
+}
+
+int tetris_board(const TetrisGameHandle *game, uint16_t *rows, int capacity) {
+  if (game == nullptr || (rows == nullptr && capacity > 0)) {
+    return TETRIS_ERROR_ARGUMENT;
+  }
+  int count = std::max(0, std::min(capacity, TETRIS_ROWS));
+  for (int i = 0; i < count; i++) {
+    rows[i] = game->game.getBoard().getRow(i);
+  }
+  return count;
+}
+
+int tetris_current_piece(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT
+                         : game->game.getCurrentPiece();
+}
+
+int tetris_next_piece(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT : game->game.getNextPiece();
+}
+
+int tetris_level(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT : game->game.getLevel();
+}
+
+int tetris_score(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT : game->game.getScore();
+}
+
+int tetris_destroyed_lines(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT
+                         : game->game.getDestroyedLines();
+}
+
+int tetris_pieces_placed(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT
+                         : game->game.getPiecesPlaced();
+}
+
+int tetris_is_game_over(const TetrisGameHandle *game) {
+  return game == nullptr ? TETRIS_ERROR_ARGUMENT : game->game.isGameOver();
+}
+
+uint64_t tetris_position_hash(const TetrisGameHandle *game) {
+  return game == nullptr ? 0 : game->game.getPositionHash();
+}
@@ -0,0 +1,87 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// C interface of the headless engine (libtetris.so, see "make library").
+// It can be used from C (C99) and from every language with a C FFI.
+//
+// A game is an opaque handle. One step is a whole placement, like in
+// HeadlessGame. The library does no I/O and doesn't use ncurses.
+//
+// Functions never throw. Functions that can fail return a negative number
+// (or NULL) instead.
+//
+
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TETRIS_API __attribute__((visibility("default")))
+#else
+#define TETRIS_API
+#endif
+
+// Increased whenever a function or a struct changes incompatibly.
+#define TETRIS_API_VERSION 1
+
+#define TETRIS_ROWS 20
+#define TETRIS_COLS 10
+#define TETRIS_MAX_PLACEMENTS 48
+
+// Errors
+#define TETRIS_ERROR_ARGUMENT -2
+#define TETRIS_ERROR_PLACEMENT -3
+
+typedef struct TetrisGameHandle TetrisGameHandle;
+
+// Same as Placement in BitBoard.h. Pieces are I, J, L, O, S, Z, T (0..6).
+typedef struct TetrisPlacement {
+  int32_t piece;
+  int32_t orientation;
+  int32_t shift;
+  int32_t dropRows;
+} TetrisPlacement;
+
+TETRIS_API int tetris_api_version(void);
+
+// Create a game, returns NULL if there is not enough memory.
+TETRIS_API TetrisGameHandle *tetris_create(uint64_t seed, int level);
+TETRIS_API void tetris_destroy(TetrisGameHandle *game);
+TETRIS_API void tetris_reset(TetrisGameHandle *game, uint64_t seed,
+                             int level);
+
+// Write the placements of the current tetromino into `placements`
+// (at most `capacity`, TETRIS_MAX_PLACEMENTS is always enough).
+// Returns their total number.
+TETRIS_API int tetris_placements(const TetrisGameHandle *game,
+                                 TetrisPlacement *placements, int capacity);
+
+// Place the current tetromino. The placement must be one of
+// tetris_placements(). Returns the number of removed rows, -1 if the game
+// is over afterwards or TETRIS_ERROR_PLACEMENT for an invalid placement
+// (the game doesn't change then).
+TETRIS_API int tetris_step(TetrisGameHandle *game,
+                           const TetrisPlacement *placement);
+
+// Board as bitmask: one word per row, from the top (spawn row) to the
+// bottom, bit j is column j. Writes min(capacity, TETRIS_ROWS) words and
+// returns the number of written words.
+TETRIS_API int tetris_board(const TetrisGameHandle *game, uint16_t *rows,
+                            int capacity);
+
+TETRIS_API int tetris_current_piece(const TetrisGameHandle *game);
+TETRIS_API int tetris_next_piece(const TetrisGameHandle *game);
+TETRIS_API int tetris_level(const TetrisGameHandle *game);
+TETRIS_API int tetris_score(const TetrisGameHandle *game);
+TETRIS_API int tetris_destroyed_lines(const TetrisGameHandle *game);
+TETRIS_API int tetris_pieces_placed(const TetrisGameHandle *game);
+TETRIS_API int tetris_is_game_over(const TetrisGameHandle *game);
+// Zobrist hash of board, current and next tetromino.
+TETRIS_API uint64_t tetris_position_hash(const TetrisGameHandle *game);
+
+#ifdef __cplusplus
+}
+#endif
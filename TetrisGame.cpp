@@ -3,8 +3,11 @@
 
 #include "./TetrisGame.h"
 #include "./TerminalManager.h"
+#include "./Finesse.h"
+#include "./Trace.h"
 #include <algorithm>
 #include <chrono>
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <stdio.h>
@@ -14,12 +17,24 @@
 #include <unistd.h>
 #include <vector>
 
-TetrisGame::TetrisGame(TerminalManager *tm, int level, char rrk, char lrk) {
+TetrisGame::TetrisGame(TerminalManager *tm, int level, char rrk, char lrk)
+    : overlay_(tm, overlayRow, overlayCol) {
 
   tm_ = tm;
   currentLevel += level;
   rightRotationKey = rrk;
   leftRotationKey = lrk;
+  // A new sequence of tetrominos every game.
+  rngState = std::chrono::system_clock::now().time_since_epoch().count();
+
+  // Numbers on the HUD, they start with all zeroes on the screen.
+  initHudNumber(&scoreHud_, scoreRow, scoreCol + 4, 6);
+  initHudNumber(&linesHud_, linesRow, linesCol + 4, 3);
+  initHudNumber(&levelHud_, levelRow, levelCol + 4, 3);
+  for (int i = 0; i < numberOfTetrominos; i++) {
+    initHudNumber(&statisticsHud_[i], statisticsRowEnd - i * 3,
+                  statisticsColStart + 6, 3);
+  }
 
   // draw the game field, current level, score, next tetromino, statistic
   // and destroyed lines texts.
@@ -60,11 +75,12 @@ TetrisGame::TetrisGame(TerminalManager *tm, int level, char rrk, char lrk) {
 
 void TetrisGame::play() {
 
-  // We will treat currentSpeed as a "time" variable.
+  // currentSpeed is the time between two gravity steps in ms.
   // For example: if we start the game with level 0 we will wait 48/60 <=> 0.8
   // sec <=> 800 ms. for user input and if we won't get any then we will move
-  // tetromino down.
-  int timer = currentSpeed;
+  // tetromino down. Gravity is scheduled on the clock, like the moves of
+  // AutoShift, so the work of a tick doesn't stretch the interval.
+  std::chrono::steady_clock::time_point nextGravity;
 
   // Main game loop
 
@@ -76,27 +92,47 @@ void TetrisGame::play() {
   // screen) we need to generate two rundom numbers (r1 != r2) and use deque to
   // code correct behaviour.
 
+  // Keys are read on their own thread, so none are lost while the game
+  // draws or sleeps.
+  if (botSearch_ == nullptr) {
+    tm_->startInputThread(&inputQueue_);
+  }
+
   // Generate initial random numbers and put them at the back of the deque.
-  generateCurrentAndNext();
-  deque.push_back(currentRandomNumber);
-  deque.push_back(nextRandomNumber);
+  // A restored game (see loadSnapshot) already has them.
+  if (deque.empty()) {
+    generateCurrentAndNext();
+    deque.push_back(currentRandomNumber);
+    deque.push_back(nextRandomNumber);
+  }
 
-  // Main game loop.
-  while (!deque.empty()) {
+  // Main game loop, until the last tetromino lands on the roof level.
+  while (!isGameOver_) {
 
     // Get first element of the deque and create current tetromino
     // Save current element for the statistics.
 
-    current = deque.front();
-    NewAbstractTetromino *tetr = chooseTetromino(current);
-
-    // Remove first element from the deque
-    deque.pop_front();
+#ifdef TETRIS_TRACK_ALLOCATIONS
+    pieceAllocations_.mark();
+#endif
+    NewAbstractTetromino *tetr = currentTetromino;
+    if (tetr != nullptr) {
+      // Restored from a snapshot, it keeps its place.
+      current = currentTetrominoIndex;
+    } else {
+      current = deque.front();
+      tetr = chooseTetromino(current);
+
+      // Remove first element from the deque
+      deque.pop_front();
+    }
+    currentTetrominoIndex = current;
 
     // Generate next random numbers and add them to the deque.
-    // We need to add them only if we have 1 element left, because
-    // otherwise our deque will be growing infinitely.
-    if (deque.size() == 1) {
+    // We need to add them only if the deque is empty, because
+    // otherwise our deque will be growing infinitely. Generating them
+    // as late as possible keeps the sequence the same as PieceGenerator.
+    if (deque.empty()) {
       generateCurrentAndNext();
       deque.push_back(currentRandomNumber);
       deque.push_back(nextRandomNumber);
@@ -107,63 +143,300 @@ void TetrisGame::play() {
     // is the following.
     drawNextTetromino(deque.front());
 
+    // Current and next tetromino are part of the position hash.
+    updatePieceHash(current, deque.front());
+
     // Assign current tetromino.
     currentTetromino = tetr;
     drawTetromino();
 
+    // Every new tetromino gets the whole time of one row before gravity
+    // moves it down.
+    auto start = std::chrono::steady_clock::now();
+    nextGravity = start + std::chrono::milliseconds(currentSpeed);
+    overlay_.startTetromino(start);
+
+    if (botSearch_ != nullptr) {
+      startBot(current, deque.front());
+    }
+
     // until it's alive (i.e not collided)
     while (currentTetromino != nullptr) {
-      UserInput userInput = tm_->getUserInput();
+      UserInput userInput;
+      if (botSearch_ != nullptr) {
+        userInput = nextBotInput();
+        if (userInput.keycode_ != -1) {
+          decideAction(userInput, false);
+        }
+      } else {
+        // All keys that arrived since the last tick, in order. Keys after
+        // the tetromino has landed are for the next one.
+        maxInputQueueDepth_ =
+            std::max(maxInputQueueDepth_, (int)inputQueue_.size());
+        while (currentTetromino != nullptr && inputQueue_.pop(&userInput)) {
+          inputLatency_.add(std::chrono::steady_clock::now() -
+                            userInput.timestamp_);
+          tm_->markInput(userInput.timestamp_);
+          if (userInput.isKeyP()) {
+            overlay_.toggle(std::chrono::steady_clock::now());
+          } else if (userInput.isKeyK()) {
+            saveSnapshot();
+          } else if (userInput.isKeyLeft() || userInput.isKeyRight()) {
+            int direction = userInput.isKeyLeft() ? -1 : 1;
+            moveSideways(direction,
+                         autoShift_.press(direction, userInput.timestamp_));
+          } else {
+            decideAction(userInput, false);
+          }
+        }
 
-      // Wait for input
-      if (userInput.keycode_ == -1) {
-        timer -= 1;
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        // Held left / right key, timed by the game.
+        if (currentTetromino != nullptr) {
+          int moves = autoShift_.update(std::chrono::steady_clock::now());
+          moveSideways(autoShift_.getDirection(), moves);
+        }
       }
-      // If we get input from user
-      else {
-        decideAction(userInput, false);
-        usleep(20'000);
+
+      {
+        TRACE_SCOPE("animations");
+        animations_.tick(std::chrono::steady_clock::now());
       }
-      // If we didn't get user input and the time is up
-      if (timer == 0) {
+#ifdef TETRIS_TRACK_ALLOCATIONS
+      frameAllocations_.mark();
+#endif
+      measureFrame();
+
+      // Wait for input
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+      // If the time is up
+      auto now = std::chrono::steady_clock::now();
+      if (now >= nextGravity && currentTetromino != nullptr) {
+        overlay_.measureGravity(now);
         // Set keycode to Down
         userInput.keycode_ = 258;
         decideAction(userInput, true);
-        usleep(20'000);
-        timer = currentSpeed;
+        nextGravity += std::chrono::milliseconds(currentSpeed);
+        // After a stall (e.g. saving a snapshot) go on from now instead of
+        // dropping several rows in a row.
+        if (nextGravity < now) {
+          nextGravity = now + std::chrono::milliseconds(currentSpeed);
+        }
       }
     }
 
     // Update stats
     updateStatistics(current);
     updateStatisticsText(current);
+    piecesPlaced_ += 1;
 
     // Avoid memory leaks
     delete currentTetromino;
     delete tetr;
   }
+
+  publishTelemetry();
+  publishSpectatorFrame();
+
+  // Let the game over animation finish.
+  while (animations_.isRunning()) {
+    animations_.tick(std::chrono::steady_clock::now());
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Call destructor to avoid ncurses terminal bug
+  tm_->~TerminalManager();
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+  printAllocationReport();
+#endif
+  if (botSearch_ != nullptr) {
+    printBotReport();
+  }
+  // Monitors see the last counters (game over) until they close it.
+  telemetry_.close();
+  // All other threads have stopped.
+  if (!Trace::finish()) {
+    std::cerr << "Can't write the trace file" << std::endl;
+  }
+  exit(0);
+}
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+void TetrisGame::printAllocationReport() {
+  auto print = [](const char *name, const AllocationTracker::Meter &meter) {
+    std::cerr << "Allocations per " << name << ": "
+              << meter.averageAllocations() << " (max "
+              << meter.getMaxAllocations() << ", " << meter.getPeriods()
+              << " " << name << "s)" << std::endl;
+  };
+  print("frame", frameAllocations_);
+  print("tetromino", pieceAllocations_);
+  print("line clear", lineClearAllocations_);
+  AllocationTracker::printFunctions(std::cerr);
+}
+#endif
+
+void TetrisGame::printBotReport() {
+  long long moves = std::max(botMoves_, 1ll);
+  long long nodes = totalBotCreatedNodes_ + totalBotReusedNodes_;
+  std::cerr << "Bot moves: " << botMoves_
+            << ", nodes per move: " << totalBotCreatedNodes_ / moves
+            << " created, " << totalBotReusedNodes_ / moves << " reused ("
+            << (nodes > 0 ? 100 * totalBotReusedNodes_ / nodes : 0)
+            << "% of the tree taken over from the previous move)"
+            << std::endl;
 }
 
 void TetrisGame::gameOver() {
-  for (int i = 0; i < tm_->numRows(); i++) {
-    for (int j = 0; j < tm_->numCols(); j++) {
-      tm_->drawPixel(i, j, (int)NamedColors::BLACK);
+  // placeTetromino() calls this for every cell on the roof level.
+  if (isGameOver_) {
+    return;
+  }
+  isGameOver_ = true;
+
+  // Black curtain from the top to the bottom, then "GAME OVER!" for
+  // gameOverTimeroutMs. play() ends after the animation.
+  animations_.clear();
+  curtainRow_ = 0;
+  animations_.add(
+      gameOverCurtainMs,
+      [this](double progress) {
+        int rows = progress * tm_->numRows();
+        for (; curtainRow_ < rows; curtainRow_++) {
+          for (int j = 0; j < tm_->numCols(); j++) {
+            tm_->drawPixel(curtainRow_, j, (int)NamedColors::BLACK);
+          }
+        }
+        tm_->refresh();
+      },
+      [this]() {
+        tm_->drawString(tm_->numRows() / 2, tm_->numCols() / 2,
+                        (int)NamedColors::WHITE, "GAME OVER!");
+        tm_->refresh();
+        animations_.add(gameOverTimeroutMs, nullptr);
+      });
+}
+
+void TetrisGame::setSnapshotFile(const std::string &path) {
+  snapshotFile_ = path;
+}
+
+bool TetrisGame::loadSnapshot(const std::string &path) {
+  MappedSnapshot mapped;
+  if (!mapped.open(path)) {
+    return false;
+  }
+  restoreSnapshot(*mapped.get());
+
+  piecesPlaced_ = 0;
+  for (int i = 0; i < numberOfTetrominos; i++) {
+    updateStatisticsText(i);
+    piecesPlaced_ += statistics[i];
+  }
+  updateLevelAndSpeedText();
+  updateDestroyedLinesText();
+  updateScoreText();
+  // play() draws the preview.
+  redrawGameField();
+  return true;
+}
+
+void TetrisGame::saveSnapshot() {
+  TRACE_SCOPE("saveSnapshot");
+  takeSnapshot().save(snapshotFile_);
+}
+
+void TetrisGame::redrawGameField() {
+  for (int i = offset_row + 1; i < offset_row + rows_; i++) {
+    for (int j = offset_col + 1; j < offset_col + cols_; j++) {
+      auto it = gameField.find(Point{i, j, NamedColors::BLACK});
+      bool isAlive = it != gameField.end() && it->second;
+      tm_->drawPixel(i, j,
+                     isAlive ? (int)it->first.color : (int)NamedColors::BLACK);
     }
   }
 
-  tm_->drawString(tm_->numRows() / 2, tm_->numCols() / 2,
-                  (int)NamedColors::WHITE, "GAME OVER!");
-  tm_->refresh();
+  if (currentTetromino != nullptr) {
+    drawTetromino();
+  } else {
+    tm_->refresh();
+  }
+}
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(gameOverTimeroutMs));
-  // Call destructor to avoid ncurses terminal bug
-  tm_->~TerminalManager();
+bool TetrisGame::enableTelemetry(const std::string &name) {
+  return telemetry_.open(name);
+}
 
-  exit(0);
+bool TetrisGame::enableSpectators(const std::string &path) {
+  return spectators_.connect(path);
+}
+
+void TetrisGame::publishSpectatorFrame() {
+  ticksSinceSpectatorFrame_ = 0;
+  if (!spectators_.isOpen()) {
+    return;
+  }
+  TRACE_SCOPE("publishSpectatorFrame");
+  SpectatorBoard board = SpectatorBoard::fromSnapshot(takeSnapshot());
+  board.isGameOver = isGameOver_;
+  spectators_.publish(board);
+}
+
+void TetrisGame::measureFrame() {
+  auto now = std::chrono::steady_clock::now();
+  if (lastTick_ != std::chrono::steady_clock::time_point()) {
+    frameTimes_.add(now - lastTick_);
+  }
+  lastTick_ = now;
+  overlay_.tick(now);
+
+  ticksSincePublish_ += 1;
+  if (ticksSincePublish_ >= telemetryTicks) {
+    publishTelemetry();
+  }
+  ticksSinceSpectatorFrame_ += 1;
+  if (ticksSinceSpectatorFrame_ >= spectatorTicks) {
+    publishSpectatorFrame();
+  }
+}
+
+void TetrisGame::publishTelemetry() {
+  ticksSincePublish_ = 0;
+  if (!telemetry_.isOpen()) {
+    return;
+  }
+  TelemetrySnapshot snapshot;
+  snapshot.pid = getpid();
+  snapshot.piecesPlaced = piecesPlaced_;
+  snapshot.lines = destroyedLines;
+  snapshot.level = currentLevel;
+  snapshot.speedMs = currentSpeed;
+  snapshot.score = currentPoints;
+  snapshot.frameTimeP50Us = frameTimes_.percentileUs(50);
+  snapshot.frameTimeP90Us = frameTimes_.percentileUs(90);
+  snapshot.frameTimeP99Us = frameTimes_.percentileUs(99);
+  snapshot.inputQueueDepth = maxInputQueueDepth_;
+  snapshot.droppedInputs = inputQueue_.getDroppedInputs();
+  snapshot.droppedFrames = tm_->getDroppedFrames();
+  snapshot.botCreatedNodes = botCreatedNodes_;
+  snapshot.botReusedNodes = botReusedNodes_;
+  snapshot.isGameOver = isGameOver_;
+  telemetry_.publish(snapshot);
+  maxInputQueueDepth_ = 0;
+}
+
+void TetrisGame::setAnimationsEnabled(bool isEnabled) {
+  animations_.setEnabled(isEnabled);
 }
 
 void TetrisGame::reshapeGameField() {
+  ALLOCATION_SCOPE("reshapeGameField");
+  TRACE_SCOPE("reshapeGameField");
+#ifdef TETRIS_TRACK_ALLOCATIONS
+  // Only periods with removed rows are counted (stop() at the end).
+  lineClearAllocations_.start();
+#endif
   // Variable to store number of alive points per line
   int acc = 0;
 
@@ -207,7 +480,7 @@ void TetrisGame::reshapeGameField() {
       }
 
       gameField[pointToRemove] = false;
-      removePointFromScreen(pointToRemove);
+      toggleCell(pointToRemove);
     }
   }
   bool flag = false;
@@ -226,12 +499,7 @@ void TetrisGame::reshapeGameField() {
 
           // Set it to false
           gameField[currentPoint] = false;
-
-          // Immitates "falling"
-          usleep(15'000);
-
-          // Remove current point from screen
-          removePointFromScreen(currentPoint);
+          toggleCell(currentPoint);
 
           // Remove current point from surface set. We need to do this
           // to avoid false collisions. We also need flag variable to know for
@@ -253,19 +521,48 @@ void TetrisGame::reshapeGameField() {
             surface.insert(currentPoint);
           }
 
-          // Put new on the screen and add it to the "logical screen".
-          gameField[currentPoint] = true;
-          tm_->drawPixel(currentPoint.row, currentPoint.col,
-                         (int)currentPoint.color);
+          // Add it to the "logical screen" (with its color, the screen is
+          // drawn from it after the animation).
+          gameField.erase(currentPoint);
+          gameField.insert(std::pair(currentPoint, true));
+          toggleCell(currentPoint);
         }
 
         flag = false;
       }
     }
   }
+
+  // The field is already final. On the screen the removed rows are wiped
+  // from the middle to the walls first, then the field is drawn again. The
+  // next tetromino can already move meanwhile.
+  if (isGameOver_) {
+    return;
+  }
+  animations_.add(
+      lineClearAnimationMs,
+      [this, rowsToRemove](double progress) {
+        int half = (cols_ - 1) / 2;
+        int wiped = std::ceil(progress * half);
+        for (int row : rowsToRemove) {
+          for (int k = 0; k < wiped; k++) {
+            tm_->drawPixel(row, offset_col + half - k,
+                           (int)NamedColors::BLACK);
+            tm_->drawPixel(row, offset_col + half + 1 + k,
+                           (int)NamedColors::BLACK);
+          }
+        }
+        tm_->refresh();
+      },
+      [this]() { redrawGameField(); });
+#ifdef TETRIS_TRACK_ALLOCATIONS
+  lineClearAllocations_.stop();
+#endif
 }
 
 void TetrisGame::placeTetromino() {
+  ALLOCATION_SCOPE("placeTetromino");
+  TRACE_SCOPE("placeTetromino");
   for (auto point : currentTetromino->getCurrentLocation()) {
     // If we are trying to place a tetromino
     // on the roof level it's game over.
@@ -273,6 +570,11 @@ void TetrisGame::placeTetromino() {
       gameOver();
     }
 
+    // Update board hash (only if the cell was empty before).
+    if (!gameField[point]) {
+      toggleCell(point);
+    }
+
     // We can't just write gameField[point] = true, because we out new point
     // can have new color.
     gameField.erase(point);
@@ -281,6 +583,8 @@ void TetrisGame::placeTetromino() {
 }
 
 void TetrisGame::decideAction(UserInput userInput, bool isArtificialMovement) {
+  ALLOCATION_SCOPE("decideAction");
+  TRACE_SCOPE("decideAction");
 
   // Save tetromino location before moving
   // in case of collision
@@ -312,6 +616,22 @@ void TetrisGame::decideAction(UserInput userInput, bool isArtificialMovement) {
     }
   }
 
+  // Hard drop: jump right above the landing row, then the last move down
+  // lands the tetromino like pressing down would. Same points as pressing
+  // down all the way.
+  else if (userInput.isKeySpace()) {
+    removeTetrominoFromScreen(previousLocation);
+    int distance = dropDistance();
+    for (int i = 0; i < distance; i++) {
+      currentTetromino->moveDown();
+    }
+    previousLocation = currentTetromino->getCurrentLocation();
+    currentTetromino->moveDown();
+    if (!isArtificialMovement) {
+      earnedPoints += distance + 1;
+    }
+  }
+
   // Return Tetromino to previous location if there is a collision
   //
   // To decide correct collision type we need additional information,
@@ -326,9 +646,11 @@ void TetrisGame::decideAction(UserInput userInput, bool isArtificialMovement) {
   // current "surface" (see .h for exact information about surface points)
   // point, which will result in wrong collision.
 
-  Collision collision = isColliding(
-      userInput.isKeyDown(), userInput.isLeftRotationKey(leftRotationKey),
-      userInput.isRightRotationKey(rightRotationKey), previousLocation);
+  Collision collision =
+      isColliding(userInput.isKeyDown() || userInput.isKeySpace(),
+                  userInput.isLeftRotationKey(leftRotationKey),
+                  userInput.isRightRotationKey(rightRotationKey),
+                  previousLocation);
 
   if (collision == Collision::Surface) {
 
@@ -341,12 +663,20 @@ void TetrisGame::decideAction(UserInput userInput, bool isArtificialMovement) {
     // Place the tetromino in "logical" screen
     placeTetromino();
 
+    // If we have a collision with floor tetromino dies, from here on it is
+    // part of the game field (also when the field is drawn again).
+    currentTetromino = nullptr;
+
     // Update surface to find prepare for new possible collisions
     updateSurface();
 
     // Remove full rows
     reshapeGameField();
 
+    // Cells that were covered by the removed rows can be on the surface now,
+    // without this the next tetromino would get stuck on them.
+    updateSurface();
+
     // Update number of destroyed lines and leve if needed
     div_t divresult = std::div(destroyedLines, 10);
     if (divresult.quot > previousQuotient) {
@@ -363,9 +693,6 @@ void TetrisGame::decideAction(UserInput userInput, bool isArtificialMovement) {
 
     // Reset earned points
     earnedPoints = 0;
-
-    // If we have a collision with floor tetromino dies
-    currentTetromino = nullptr;
     return;
   }
 
@@ -391,7 +718,26 @@ void TetrisGame::removePointFromScreen(Point point) {
   tm_->refresh();
 }
 
+void TetrisGame::drawGhost() {
+  // Remove the old ghost, except where tetrominos were placed.
+  for (auto point : ghostLocation_) {
+    if (!gameField[point]) {
+      tm_->drawPixel(point.row, point.col, (int)NamedColors::BLACK);
+    }
+  }
+
+  ghostLocation_ = currentTetromino->getCurrentLocation();
+  int distance = dropDistance();
+  for (auto &point : ghostLocation_) {
+    point.row += distance;
+    tm_->drawPixel(point.row, point.col, (int)NamedColors::GHOST);
+  }
+}
+
 void TetrisGame::drawTetromino() {
+  // Ghost first, the tetromino is drawn over it where they overlap.
+  drawGhost();
+
   for (auto point : currentTetromino->getCurrentLocation()) {
     tm_->drawPixel(point.row, point.col,
                    (int)currentTetromino->getTetrominoColor());
@@ -469,9 +815,7 @@ void TetrisGame::drawStatistics() {
 }
 
 void TetrisGame::updateStatisticsText(int tetrominoIndex) {
-  tm_->drawString(statisticsRowEnd - (tetrominoIndex)*3, statisticsColStart + 6,
-                  (int)NamedColors::WHITE,
-                  intToString(statistics[tetrominoIndex], 3).c_str());
+  updateHudNumber(&statisticsHud_[tetrominoIndex], statistics[tetrominoIndex]);
 }
 
 void TetrisGame::drawDestroyedLinesText() {
@@ -479,8 +823,7 @@ void TetrisGame::drawDestroyedLinesText() {
 }
 
 void TetrisGame::updateDestroyedLinesText() {
-  tm_->drawString(linesRow, linesCol + 4, (int)NamedColors::WHITE,
-                  intToString(destroyedLines, 3).c_str());
+  updateHudNumber(&linesHud_, destroyedLines);
 }
 
 void TetrisGame::drawLevelText() {
@@ -488,8 +831,7 @@ void TetrisGame::drawLevelText() {
 }
 
 void TetrisGame::updateLevelAndSpeedText() {
-  tm_->drawString(levelRow, levelCol + 4, (int)NamedColors::WHITE,
-                  intToString(currentLevel, 3).c_str());
+  updateHudNumber(&levelHud_, currentLevel);
 }
 
 void TetrisGame::drawScoreText() {
@@ -498,6 +840,152 @@ void TetrisGame::drawScoreText() {
 }
 
 void TetrisGame::updateScoreText() {
-  tm_->drawString(scoreRow, scoreCol + 4, (int)NamedColors::WHITE,
-                  intToString(currentPoints, 6).c_str());
+  updateHudNumber(&scoreHud_, currentPoints);
+}
+
+void TetrisGame::initHudNumber(HudNumber *hud, int row, int col, int width) {
+  hud->row = row;
+  hud->col = col;
+  hud->width = width;
+  formatNumber(0, width, hud->shown);
+}
+
+void TetrisGame::updateHudNumber(HudNumber *hud, int number) {
+  char text[sizeof(hud->shown)];
+  formatNumber(number, hud->width, text);
+
+  int first = 0;
+  while (first < hud->width && text[first] == hud->shown[first]) {
+    first += 1;
+  }
+  if (first == hud->width) {
+    return;
+  }
+  int last = hud->width - 1;
+  while (text[last] == hud->shown[last]) {
+    last -= 1;
+  }
+
+  // One screen column is two characters wide, so the first drawn digit
+  // has to be at an even position.
+  first -= first % 2;
+  char changed[sizeof(hud->shown)];
+  std::copy(text + first, text + last + 1, changed);
+  changed[last + 1 - first] = '\0';
+  tm_->drawString(hud->row, hud->col + first / 2, (int)NamedColors::WHITE,
+                  changed);
+  std::copy(text, text + hud->width + 1, hud->shown);
+}
+
+void TetrisGame::setAutoShift(int dasMs, int arrMs) {
+  autoShift_ = AutoShift(dasMs, arrMs);
+}
+
+void TetrisGame::moveSideways(int direction, int moves) {
+  UserInput userInput;
+  userInput.keycode_ = direction < 0 ? 260 : 261;
+  for (int i = 0; i < moves; i++) {
+    decideAction(userInput, false);
+  }
+}
+
+void TetrisGame::enableBot(const EvaluationWeights &weights) {
+  botTable_ = std::make_unique<TranspositionTable>();
+  botSearch_ = std::make_unique<BotSearch>(weights, botTable_.get());
+}
+
+void TetrisGame::startBot(int current, int next) {
+  botInputs_.clear();
+  isBotCommitted_ = false;
+
+  // The first gravity tick comes after currentSpeed ms (see play()).
+  botDeadline_ = std::chrono::steady_clock::now() +
+                 std::chrono::milliseconds(currentSpeed - botSafetyMarginMs);
+  botSearch_->start(toBitBoard(), current, next);
+}
+
+UserInput TetrisGame::nextBotInput() {
+  UserInput userInput;
+  userInput.keycode_ = -1;
+
+  // Keep thinking until the deadline (or until there is nothing
+  // left to think about).
+  if (!isBotCommitted_) {
+    if (std::chrono::steady_clock::now() < botDeadline_ &&
+        !botSearch_->isFinished()) {
+      return userInput;
+    }
+
+    Placement placement;
+    if (botSearch_->commit(&placement)) {
+      planBotInputs(placement);
+    }
+    isBotCommitted_ = true;
+    botCreatedNodes_ = botSearch_->getCreatedNodes();
+    botReusedNodes_ = botSearch_->getReusedNodes();
+    botMoves_ += 1;
+    totalBotCreatedNodes_ += botCreatedNodes_;
+    totalBotReusedNodes_ += botReusedNodes_;
+  }
+
+  // After all planned keys drop it.
+  if (botInputs_.empty()) {
+    userInput.keycode_ = ' ';
+    return userInput;
+  }
+
+  userInput = botInputs_.front();
+  botInputs_.pop_front();
+  return userInput;
+}
+
+void TetrisGame::planBotInputs(const Placement &placement) {
+  const Orientation &orientation =
+      BitBoard::getOrientation(placement.piece, placement.orientation);
+  UserInput userInput;
+
+  // Fewest keys, if nothing is in the way at the top of the field.
+  const FinesseEntry *finesse = Finesse::get(placement);
+  BitBoard board = toBitBoard();
+  bool isTopEmpty = true;
+  for (int row = 0; row <= Finesse::maxRow(); row++) {
+    isTopEmpty = isTopEmpty && board.getRow(row) == 0;
+  }
+  if (finesse != nullptr && isTopEmpty) {
+    for (int i = 0; i < finesse->length; i++) {
+      switch (finesse->keys[i]) {
+      case FinesseKey::Left:
+        userInput.keycode_ = 260;
+        break;
+      case FinesseKey::Right:
+        userInput.keycode_ = 261;
+        break;
+      case FinesseKey::RotateLeft:
+        userInput.keycode_ = leftRotationKey;
+        break;
+      case FinesseKey::RotateRight:
+        userInput.keycode_ = rightRotationKey;
+        break;
+      }
+      botInputs_.push_back(userInput);
+    }
+    return;
+  }
+
+  // Same order as in BitBoard::generatePlacements: rotate, move fully
+  // into the field, move sideways. Falling is done by nextBotInput().
+  userInput.keycode_ = rightRotationKey;
+  for (int i = 0; i < orientation.rotations; i++) {
+    botInputs_.push_back(userInput);
+  }
+
+  userInput.keycode_ = 258;
+  for (int i = 0; i < orientation.startRow; i++) {
+    botInputs_.push_back(userInput);
+  }
+
+  userInput.keycode_ = placement.shift < 0 ? 260 : 261;
+  for (int i = 0; i < std::abs(placement.shift); i++) {
+    botInputs_.push_back(userInput);
+  }
 }
@@ -2,12 +2,24 @@
 // Code snippets from the lectures where used
 
 #pragma once
+#include "./AllocationTracker.h"
+#include "./Animations.h"
+#include "./AutoShift.h"
+#include "./BotSearch.h"
+#include "./InputQueue.h"
+#include "./PerformanceOverlay.h"
+#include "./Spectator.h"
+#include "./Telemetry.h"
 #include "./TerminalManager.h"
 #include "./Tetromino.h"
+#include "./TranspositionTable.h"
 #include "AbstractTetrisGame.h"
+#include <chrono>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <set>
+#include <string>
 #include <unordered_map>
 
 class TetrisGame : public AbstractTetrisGame {
@@ -39,6 +51,9 @@ public:
 
   void drawTetromino();
 
+  // Draw the current tetromino where it would land (see dropDistance()).
+  void drawGhost();
+
   void drawGameField();
   // --------------------------------------------
 
@@ -69,12 +84,143 @@ public:
   // Remove lines
   void reshapeGameField() override;
 
+  // Let the bot play instead of the user.
+  void enableBot(const EvaluationWeights &weights);
+
+  // Time from reading a key to applying it.
+  const InputLatency &getInputLatency() const { return inputLatency_; }
+
+  // Timing of sideways auto repeat (see AutoShift.h).
+  void setAutoShift(int dasMs, int arrMs);
+
+  // Publish live counters in the shared memory segment `name` (see
+  // Telemetry.h). Returns false if the segment can't be created.
+  bool enableTelemetry(const std::string &name);
+
+  // Stream the board to the spectator hub at `path` (see Spectator.h).
+  // Returns false if no hub listens there.
+  bool enableSpectators(const std::string &path);
+
+  // Where 'k' saves the game (see Snapshot.h).
+  void setSnapshotFile(const std::string &path);
+  // Continue a saved game. Returns false if the file isn't a valid
+  // snapshot.
+  bool loadSnapshot(const std::string &path);
+
+  // Without animations removed rows and the game over screen are shown
+  // at once.
+  void setAnimationsEnabled(bool isEnabled);
+
 private:
   TerminalManager *tm_;
 
+  // Keys from the input thread of the terminal manager.
+  InputQueue inputQueue_;
+  InputLatency inputLatency_;
+  // Held left / right keys.
+  AutoShift autoShift_;
+  // Move the current tetromino `moves` times to the left (direction -1)
+  // or to the right (1).
+  void moveSideways(int direction, int moves);
+
+  // Bot.
+  // --------------------------------------------
+  // Start thinking about the new tetromino. The bot has time until
+  // the first gravity tick.
+  void startBot(int current, int next);
+  // Next key the bot "presses" (keycode -1 while it is still thinking).
+  UserInput nextBotInput();
+  // Keys that move the current tetromino to the given placement.
+  void planBotInputs(const Placement &placement);
+
+  std::unique_ptr<TranspositionTable> botTable_;
+  std::unique_ptr<BotSearch> botSearch_;
+  std::deque<UserInput> botInputs_;
+  bool isBotCommitted_ = false;
+  std::chrono::steady_clock::time_point botDeadline_;
+  // The bot commits a bit earlier than the gravity tick, so that
+  // stopping the search never delays the tetromino.
+  const int botSafetyMarginMs = 2;
+  // Search nodes created and reused (taken over from the previous move) in
+  // the last move, for the telemetry, and in the whole game, printed when
+  // the game ends.
+  long long botCreatedNodes_ = 0;
+  long long botReusedNodes_ = 0;
+  long long botMoves_ = 0;
+  long long totalBotCreatedNodes_ = 0;
+  long long totalBotReusedNodes_ = 0;
+  void printBotReport();
+  // --------------------------------------------
+
   // We will need some additional variable to be able to update
   // data on the screen.
 
+  // A number on the HUD and its digits as they are on the screen. Only the
+  // digits that changed are drawn again.
+  struct HudNumber {
+    int row;
+    int col;
+    int width;
+    char shown[8];
+  };
+  HudNumber scoreHud_;
+  HudNumber linesHud_;
+  HudNumber levelHud_;
+  // One per tetromino.
+  HudNumber statisticsHud_[7];
+  void initHudNumber(HudNumber *hud, int row, int col, int width);
+  void updateHudNumber(HudNumber *hud, int number);
+
+  // Where the ghost tetromino was drawn last time.
+  std::vector<Point> ghostLocation_;
+
+#ifdef TETRIS_TRACK_ALLOCATIONS
+  // Allocations per frame (tick of the game loop), per tetromino and per
+  // line clear, printed when the game ends.
+  AllocationTracker::Meter frameAllocations_;
+  AllocationTracker::Meter pieceAllocations_;
+  AllocationTracker::Meter lineClearAllocations_;
+  void printAllocationReport();
+#endif
+
+  // Telemetry.
+  // --------------------------------------------
+  TelemetryWriter telemetry_;
+  FrameTimes frameTimes_;
+  std::chrono::steady_clock::time_point lastTick_;
+  int maxInputQueueDepth_ = 0;
+  int ticksSincePublish_ = 0;
+  int piecesPlaced_ = 0;
+  // Publish about every 100 ms.
+  const int telemetryTicks = 100;
+  // Frame time of the tick and telemetry, called once per tick.
+  void measureFrame();
+  void publishTelemetry();
+  // --------------------------------------------
+
+  // Spectators, about 60 frames per second. Never waits for the hub.
+  SpectatorPublisher spectators_;
+  int ticksSinceSpectatorFrame_ = 0;
+  const int spectatorTicks = 16;
+  void publishSpectatorFrame();
+
+  // Performance overlay, 'p' shows / hides it. Left of the statistics.
+  const int overlayRow = 13;
+  const int overlayCol = 2;
+  PerformanceOverlay overlay_;
+
+  // Snapshots, saved with 'k'.
+  std::string snapshotFile_ = "tetris.snapshot";
+  void saveSnapshot();
+
+  // Line clear and game over animations, they run on the game loop ticks.
+  Animations animations_;
+  // Draw all cells of the game field and the current tetromino again.
+  void redrawGameField();
+  bool isGameOver_ = false;
+  // Rows already covered by the game over curtain.
+  int curtainRow_ = 0;
+
   // Coordinates of the "Box" for the next tetromino
   const int nextTetrominoRowStart = 20;
   const int nextTetrominoRowEnd = 25;
@@ -119,4 +265,7 @@ private:
 
   // Hold "Game over" for 1.5 sec.
   const int gameOverTimeroutMs = 1500;
+  const int gameOverCurtainMs = 500;
+  // Wiping the removed rows.
+  const int lineClearAnimationMs = 150;
 };
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include "./TerminalManager.h"
 #include "./TetrisGame.h"
 #include "./Tetromino.h"
+#include "./Trace.h"
 #include <iostream>
 
 std::vector<std::pair<Color, Color>> createColorVector() {
@@ -33,6 +34,7 @@ std::vector<std::pair<Color, Color>> createColorVector() {
       std::pair(Color(0, 0.859, 0.655), Color(0.0, 0.0, 0.0));
 
   std::pair WhileColorPair(Color(1, 1, 1), Color(0.0, 0.0, 0.0));
+  std::pair GhostColorPair(Color(0.3, 0.3, 0.3), Color(0.0, 0.0, 0.0));
 
   colorVector.push_back(MainColorPair);
   colorVector.push_back(BlackColorPair);
@@ -45,6 +47,7 @@ std::vector<std::pair<Color, Color>> createColorVector() {
   colorVector.push_back(TetrominoZColorPair);
   colorVector.push_back(TetrominoSColorPair);
   colorVector.push_back(WhileColorPair);
+  colorVector.push_back(GhostColorPair);
 
   return colorVector;
 }
@@ -62,8 +65,52 @@ int main(int argc, char **argv) {
   char rightRotationKey = parser.getRightRotationKey();
   char leftRotationKey = parser.getLeftRotationKey();
 
+  // Weights for the bot (only used with --ai).
+  EvaluationWeights weights = EvaluationWeights::defaults();
+  if (!parser.getWeightsFile().empty() &&
+      !weights.load(parser.getWeightsFile())) {
+    std::cerr << "Can't read weights from " << parser.getWeightsFile()
+              << std::endl;
+    return 1;
+  }
+
+  // Timeline of the game, written when it ends.
+  if (!parser.getTraceFile().empty()) {
+    Trace::enable(parser.getTraceFile());
+    Trace::setThreadName("game");
+  }
+
   // Create new terminal manager with colors and start the game.
   TerminalManager *tm = new TerminalManager(colorVector);
   TetrisGame game(tm, level, rightRotationKey, leftRotationKey);
+  game.setAutoShift(parser.getDasMs(), parser.getArrMs());
+  game.setAnimationsEnabled(parser.isAnimationsEnabled());
+  if (parser.isBotEnabled()) {
+    game.enableBot(weights);
+  }
+  // Counters for TetrisMonitorMain.
+  if (!parser.getTelemetryName().empty() &&
+      !game.enableTelemetry("/" + parser.getTelemetryName())) {
+    tm->~TerminalManager();
+    std::cerr << "Can't create shared memory /" << parser.getTelemetryName()
+              << std::endl;
+    return 1;
+  }
+  game.setSnapshotFile(parser.getSnapshotFile());
+  if (!parser.getLoadFile().empty() &&
+      !game.loadSnapshot(parser.getLoadFile())) {
+    tm->~TerminalManager();
+    std::cerr << "Can't load the snapshot " << parser.getLoadFile()
+              << std::endl;
+    return 1;
+  }
+  // Frames for TetrisSpectateMain --hub.
+  if (!parser.getSpectateSocket().empty() &&
+      !game.enableSpectators(parser.getSpectateSocket())) {
+    tm->~TerminalManager();
+    std::cerr << "No spectator hub on " << parser.getSpectateSocket()
+              << std::endl;
+    return 1;
+  }
   game.play();
 }
\ No newline at end of file
@@ -2,14 +2,43 @@
 // Code snippets from the lectures where used
 
 #include "./AbstractTetromino.h"
+#include "./AllocationTracker.h"
+#include "./Animations.h"
+#include "./AutoShift.h"
+#include "./BatchEvaluator.h"
+#include "./BitBoard.h"
+#include "./BotSearch.h"
+#include "./Finesse.h"
+#include "./GameServer.h"
+#include "./HeadlessGame.h"
+#include "./InputQueue.h"
 #include "./MockTerminalManager.h"
 #include "./MockTetrisGame.h"
 #include "./ParseArguments.h"
+#include "./PerformanceOverlay.h"
+#include "./PieceGenerator.h"
 #include "./Point.h"
+#include "./SimdBoards.h"
+#include "./Spectator.h"
+#include "./Snapshot.h"
+#include "./TetrisCApi.h"
+#include "./Telemetry.h"
+#include "./TetrisBot.h"
 #include "./Tetromino.h"
+#include "./TranspositionTable.h"
+#include "./Trace.h"
+#include "./Versus.h"
+#include "./TripleBuffer.h"
+#include "./VecEnv.h"
+#include "./Zobrist.h"
 #include <algorithm>
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <random>
 #include <thread>
+#include <unistd.h>
 
 #include <gtest/gtest.h>
 #include <vector>
@@ -67,6 +96,263 @@ TEST(CLAPLongFunctionality, Parser) {
   ASSERT_EQ('z', longArgsParser.getRightRotationKey());
 }
 
+TEST(CLAPAutoShift, Parser) {
+  char programmName[] = "./TetrisGameMain";
+  char das[] = "--das=10f";
+  char arr[] = "--arr=0";
+  char *argv[] = {programmName, das, arr};
+
+  // getopt keeps its position from the last test.
+  optind = 1;
+  Parser parser;
+  parser.parseArguments(3, argv);
+
+  ASSERT_EQ(167, parser.getDasMs());
+  ASSERT_EQ(0, parser.getArrMs());
+  ASSERT_EQ(50, Parser::parseMilliseconds("50"));
+  ASSERT_EQ(33, Parser::parseMilliseconds("2f"));
+}
+
+// "--weights <file>" as in the help, not only "--weights=<file>".
+TEST(CLAPWeightsFile, Parser) {
+  char programmName[] = "./TetrisGameMain";
+  char ai[] = "--ai";
+  char weights[] = "--weights";
+  char file[] = "w.txt";
+  char *argv[] = {programmName, ai, weights, file};
+
+  optind = 1;
+  Parser parser;
+  parser.parseArguments(4, argv);
+
+  ASSERT_TRUE(parser.isBotEnabled());
+  ASSERT_EQ("w.txt", parser.getWeightsFile());
+}
+
+TEST(MockTetrisGameFormatNumber, MockTetrisGame) {
+  char text[8];
+  MockTetrisGame::formatNumber(42, 6, text);
+  ASSERT_STREQ("000042", text);
+  MockTetrisGame::formatNumber(7, 3, text);
+  ASSERT_STREQ("007", text);
+  // Doesn't write past the given width.
+  MockTetrisGame::formatNumber(1234, 3, text);
+  ASSERT_STREQ("999", text);
+  MockTetrisGame::formatNumber(-5, 3, text);
+  ASSERT_STREQ("000", text);
+}
+
+// Allocations are only counted in the instrumentation build (make tracked,
+// and TetrisGameTrackedTest of make test).
+#ifdef TETRIS_TRACK_ALLOCATIONS
+TEST(AllocationTrackerCounts, AllocationTracker) {
+  int function = AllocationTracker::registerFunction("test");
+  AllocationTracker::Counts before = AllocationTracker::threadCounts();
+  // volatile, so the compiler can't remove new and delete.
+  int *volatile pointer;
+  {
+    AllocationTracker::Scope scope(function);
+    pointer = new int(1);
+    delete pointer;
+  }
+  pointer = new int(2);
+  delete pointer;
+  AllocationTracker::Counts after = AllocationTracker::threadCounts();
+
+  ASSERT_EQ(2, after.allocations - before.allocations);
+  ASSERT_EQ(2, after.frees - before.frees);
+  ASSERT_EQ(1, AllocationTracker::functionCounts(function).allocations);
+  ASSERT_STREQ("test", AllocationTracker::functionName(function));
+}
+
+TEST(HeadlessGameDoesNotAllocate, AllocationTracker) {
+  HeadlessGame game(7);
+  Placement placements[BitBoard::maxPlacements];
+  std::mt19937 random(3);
+  auto playPieces = [&](int pieces) {
+    for (int i = 0; i < pieces; i++) {
+      if (game.isGameOver()) {
+        game.reset(random());
+      }
+      int count = game.generatePlacements(placements);
+      if (count == 0) {
+        game.reset(random());
+        continue;
+      }
+      game.play(placements[random() % count]);
+    }
+  };
+
+  // Warm up, then no allocation at all.
+  playPieces(100);
+  AllocationTracker::Meter meter;
+  meter.start();
+  playPieces(10'000);
+  meter.stop();
+  ASSERT_EQ(0, meter.getAllocations());
+}
+#endif
+
+TEST(TraceWritesChromeJson, Trace) {
+  std::string path = "trace-test.json";
+  {
+    // Disabled, nothing is recorded.
+    TRACE_SCOPE("before");
+  }
+  Trace::enable(path);
+  Trace::setThreadName("test");
+  {
+    TRACE_SCOPE("outer");
+    TRACE_SCOPE("inner");
+  }
+  std::thread thread([]() {
+    Trace::setThreadName("worker");
+    TRACE_SCOPE("other thread");
+  });
+  thread.join();
+  ASSERT_TRUE(Trace::finish());
+  ASSERT_FALSE(Trace::isEnabled());
+
+  std::ifstream file(path);
+  std::string json((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  std::remove(path.c_str());
+  ASSERT_EQ(0u, json.find("{\"traceEvents\":["));
+  ASSERT_NE(std::string::npos,
+            json.find("\"name\":\"outer\",\"ph\":\"X\""));
+  ASSERT_NE(std::string::npos, json.find("\"name\":\"inner\""));
+  ASSERT_NE(std::string::npos, json.find("\"name\":\"other thread\""));
+  ASSERT_NE(std::string::npos, json.find("{\"name\":\"worker\"}"));
+  ASSERT_EQ(std::string::npos, json.find("before"));
+  // inner ends before outer, so it is written first.
+  ASSERT_LT(json.find("inner"), json.find("outer"));
+  ASSERT_EQ("]}\n", json.substr(json.size() - 3));
+}
+
+TEST(TelemetrySharedMemory, Telemetry) {
+  std::string name = "/tetris-test-" + std::to_string(getpid());
+  TelemetryReader reader;
+  ASSERT_FALSE(reader.open(name));
+
+  TelemetryWriter writer;
+  ASSERT_TRUE(writer.open(name));
+  ASSERT_TRUE(reader.open(name));
+
+  TelemetrySnapshot snapshot;
+  snapshot.piecesPlaced = 12;
+  snapshot.lines = 4;
+  snapshot.frameTimeP99Us = 2500;
+  snapshot.botReusedNodes = 900;
+  snapshot.isGameOver = 1;
+  writer.publish(snapshot);
+
+  TelemetrySnapshot read;
+  ASSERT_TRUE(reader.read(&read));
+  ASSERT_EQ(12, read.piecesPlaced);
+  ASSERT_EQ(4, read.lines);
+  ASSERT_EQ(2500, read.frameTimeP99Us);
+  ASSERT_EQ(900, read.botReusedNodes);
+  ASSERT_EQ(1, read.isGameOver);
+
+  // Gone for new monitors, the open one still reads.
+  writer.close();
+  TelemetryReader late;
+  ASSERT_FALSE(late.open(name));
+  ASSERT_TRUE(reader.read(&read));
+  ASSERT_EQ(12, read.piecesPlaced);
+}
+
+TEST(FrameTimesPercentiles, Telemetry) {
+  FrameTimes frameTimes;
+  ASSERT_EQ(0, frameTimes.percentileUs(50));
+  for (int i = 1; i <= 100; i++) {
+    frameTimes.add(std::chrono::microseconds(i));
+  }
+  ASSERT_EQ(51, frameTimes.percentileUs(50));
+  ASSERT_EQ(100, frameTimes.percentileUs(99));
+  ASSERT_EQ(100, frameTimes.percentileUs(100));
+  // Only the last 256 count.
+  for (int i = 0; i < FrameTimes::capacity; i++) {
+    frameTimes.add(std::chrono::microseconds(7));
+  }
+  ASSERT_EQ(7, frameTimes.percentileUs(99));
+}
+
+TEST(AnimationsProgress, Animations) {
+  using std::chrono::milliseconds;
+  auto start = Animations::Clock::now();
+  Animations animations;
+  animations.tick(start);
+
+  std::vector<double> progress;
+  int finished = 0;
+  animations.add(
+      100, [&](double p) { progress.push_back(p); },
+      [&]() {
+        finished += 1;
+        // The next part of a sequence starts with the next tick.
+        animations.add(50, nullptr, [&]() { finished += 1; });
+      });
+  ASSERT_TRUE(animations.isRunning());
+
+  animations.tick(start + milliseconds(50));
+  animations.tick(start + milliseconds(200));
+  ASSERT_EQ(std::vector<double>({0.5, 1.0}), progress);
+  ASSERT_EQ(1, finished);
+  ASSERT_TRUE(animations.isRunning());
+
+  animations.tick(start + milliseconds(240));
+  ASSERT_EQ(1, finished);
+  animations.tick(start + milliseconds(250));
+  ASSERT_EQ(2, finished);
+  ASSERT_FALSE(animations.isRunning());
+
+  // Disabled animations end right away.
+  animations.setEnabled(false);
+  animations.add(100, [&](double p) { progress.push_back(p); });
+  ASSERT_EQ(1.0, progress.back());
+  ASSERT_EQ(3u, progress.size());
+  ASSERT_FALSE(animations.isRunning());
+}
+
+TEST(AutoShiftTiming, AutoShift) {
+  using std::chrono::milliseconds;
+  auto start = AutoShift::Clock::now();
+  AutoShift autoShift(100, 20, 50);
+
+  // A tap moves once, nothing repeats without terminal repeats.
+  ASSERT_EQ(1, autoShift.press(-1, start));
+  ASSERT_EQ(0, autoShift.update(start + milliseconds(300)));
+
+  // A second tap before das is over is a new tap.
+  ASSERT_EQ(1, autoShift.press(1, start + milliseconds(400)));
+  ASSERT_EQ(1, autoShift.press(1, start + milliseconds(450)));
+
+  // Terminal repeats after das: held, the moves come from update() every
+  // 20 ms, no matter how fast the terminal repeats.
+  auto held = start + milliseconds(2000);
+  ASSERT_EQ(1, autoShift.press(1, held));
+  ASSERT_EQ(0, autoShift.update(held + milliseconds(50)));
+  ASSERT_EQ(1, autoShift.press(1, held + milliseconds(250)));
+  for (int ms = 280; ms <= 400; ms += 30) {
+    ASSERT_EQ(0, autoShift.press(1, held + milliseconds(ms)));
+  }
+  ASSERT_EQ(1, autoShift.getDirection());
+  ASSERT_EQ(0, autoShift.update(held + milliseconds(260)));
+  ASSERT_EQ(2, autoShift.update(held + milliseconds(290)));
+  ASSERT_EQ(5, autoShift.update(held + milliseconds(390)));
+
+  // Repeats stopped: released.
+  ASSERT_EQ(0, autoShift.update(held + milliseconds(460)));
+  ASSERT_EQ(0, autoShift.getDirection());
+
+  // arr = 0 moves to the wall at once.
+  AutoShift instant(100, 0, 50);
+  ASSERT_EQ(1, instant.press(-1, start));
+  ASSERT_EQ(1, instant.press(-1, start + milliseconds(200)));
+  ASSERT_EQ(AutoShift::maxMoves, instant.update(start + milliseconds(210)));
+}
+
 // Simple moving test.
 TEST(TetrominoMovement, Tetromino) {
   NewAbstractTetromino *tetr[7] = {
@@ -1119,6 +1405,1565 @@ TEST(MockTetrisGameLineRemoving, MockTetrisGame) {
 
   delete mtg.currentTetromino;
 }
+TEST(MockTetrisGameHashing, MockTetrisGame) {
+  MockTetrisGame mtg(0, 's', 'a');
+
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+
+  UserInput moveLeft;
+  moveLeft.keycode_ = 260;
+
+  // Empty board has hash 0.
+  ASSERT_EQ(0u, mtg.getBoardHash());
+  ASSERT_EQ(mtg.computeBoardHash(), mtg.getBoardHash());
+
+  // After every placement incremental hash should be the same
+  // as the recomputed one.
+  mtg.currentTetromino = new TetrominoI();
+  mtg.decideAction(moveLeft, false);
+  mtg.decideAction(moveLeft, false);
+  mtg.decideAction(moveLeft, false);
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+
+  uint64_t hashAfterFirstI = mtg.getBoardHash();
+  ASSERT_NE(0u, hashAfterFirstI);
+  ASSERT_EQ(mtg.computeBoardHash(), hashAfterFirstI);
+
+  mtg.currentTetromino = new TetrominoI();
+  mtg.decideAction(moveRight, false);
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+  ASSERT_EQ(mtg.computeBoardHash(), mtg.getBoardHash());
+
+  // This O completes the bottom line, the line is removed and
+  // the upper half of O falls down.
+  mtg.currentTetromino = new TetrominoO();
+  for (int i = 0; i < 4; i++) {
+    mtg.decideAction(moveRight, false);
+  }
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+
+  ASSERT_EQ(1, mtg.destroyedLines);
+  ASSERT_EQ(mtg.computeBoardHash(), mtg.getBoardHash());
+
+  // Current and next tetromino change position hash, but not board hash.
+  uint64_t boardHash = mtg.getBoardHash();
+  mtg.updatePieceHash(0, 1);
+  uint64_t positionHash = mtg.getPositionHash();
+  ASSERT_NE(boardHash, positionHash);
+  mtg.updatePieceHash(1, 0);
+  ASSERT_NE(positionHash, mtg.getPositionHash());
+  ASSERT_EQ(boardHash, mtg.getBoardHash());
+}
+
+TEST(TranspositionTableStoreAndProbe, TranspositionTable) {
+  TranspositionTable table(1000);
+
+  // Rounded down to a power of two.
+  ASSERT_EQ(512u, table.size());
+
+  TranspositionEntry entry;
+  uint64_t hash = Zobrist::cellKey(3, 4) ^ Zobrist::pieceKey(2);
+  ASSERT_FALSE(table.probe(hash, &entry));
+
+  table.store(hash, -12.5, 2, 17);
+  ASSERT_TRUE(table.probe(hash, &entry));
+  ASSERT_FLOAT_EQ(-12.5, entry.score);
+  ASSERT_EQ(2, entry.depth);
+  ASSERT_EQ(17, entry.bestMove);
+
+  // Same slot, different position: shallower result doesn't replace
+  // a deeper one from the same generation.
+  uint64_t otherHash = hash + table.size();
+  table.store(otherHash, 1.0, 1, 0);
+  ASSERT_FALSE(table.probe(otherHash, &entry));
+  ASSERT_TRUE(table.probe(hash, &entry));
+
+  // But it does in the next generation.
+  table.newGeneration();
+  table.store(otherHash, 1.0, 1, -1);
+  ASSERT_TRUE(table.probe(otherHash, &entry));
+  ASSERT_EQ(-1, entry.bestMove);
+  ASSERT_FALSE(table.probe(hash, &entry));
+
+  table.clear();
+  ASSERT_FALSE(table.probe(otherHash, &entry));
+}
 // --------------------------------------------------------------------------------------------------------------------
 // MockTetrisGame tests end
 // --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Headless engine and bot tests start
+// --------------------------------------------------------------------------------------------------------------------
+
+TEST(PieceGeneratorRules, PieceGenerator) {
+  PieceGenerator generator(42);
+  PieceGenerator sameSeed(42);
+
+  int previousNext = -1;
+  for (int i = 0; i < 1000; i++) {
+    int current = generator.nextPiece();
+    int next = generator.nextPiece();
+
+    // Same seed, same sequence.
+    ASSERT_EQ(current, sameSeed.nextPiece());
+    ASSERT_EQ(next, sameSeed.nextPiece());
+
+    // Same rules as generateCurrentAndNext.
+    ASSERT_TRUE(current >= 0 && current <= 6);
+    ASSERT_TRUE(next >= 0 && next <= 6);
+    ASSERT_NE(current, next);
+    ASSERT_NE(current, previousNext);
+    previousNext = next;
+  }
+
+  // Restoring a state repeats the sequence.
+  PieceGenerator::State state = generator.getState();
+  int a = generator.nextPiece();
+  int b = generator.nextPiece();
+  generator.setState(state);
+  ASSERT_EQ(a, generator.nextPiece());
+  ASSERT_EQ(b, generator.nextPiece());
+}
+
+TEST(BitBoardOrientations, BitBoard) {
+  // I, J, L, O, S, Z, T. I has a "cube" state in this game.
+  int expected[7] = {3, 4, 4, 1, 2, 2, 4};
+  for (int piece = 0; piece < 7; piece++) {
+    ASSERT_EQ(expected[piece], BitBoard::numberOfOrientations(piece));
+  }
+
+  // Spawn orientation is the tetromino itself.
+  const Orientation &spawnT = BitBoard::getOrientation(6, 0);
+  ASSERT_EQ(0, spawnT.rotations);
+  ASSERT_EQ(0, spawnT.rows[0]);
+  ASSERT_EQ(45 - BitBoard::firstCol, spawnT.cols[0]);
+
+  // On an empty board a flat O can go to 9 columns.
+  BitBoard board;
+  Placement placements[BitBoard::maxPlacements];
+  ASSERT_EQ(9, board.generatePlacements(3, placements));
+}
+
+// Every placement computed by BitBoard has to be reachable in the real
+// game with the same keys and has to end with the same cells.
+TEST(BitBoardPlacementsMatchGame, BitBoard) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+  UserInput moveLeft;
+  moveLeft.keycode_ = 260;
+  UserInput rotateRight;
+  rotateRight.keycode_ = 's';
+
+  BitBoard empty;
+  Placement placements[BitBoard::maxPlacements];
+
+  for (int piece = 0; piece < 7; piece++) {
+    int count = empty.generatePlacements(piece, placements);
+    for (int i = 0; i < count; i++) {
+      const Placement &placement = placements[i];
+      const Orientation &orientation =
+          BitBoard::getOrientation(piece, placement.orientation);
+
+      MockTetrisGame mtg(0, 's', 'a');
+      mtg.currentTetromino = mtg.chooseTetromino(piece);
+
+      // Rotate at the spawn row, then move fully into the field.
+      for (int r = 0; r < orientation.rotations; r++) {
+        mtg.decideAction(rotateRight, false);
+      }
+      for (int r = 0; r < orientation.startRow; r++) {
+        mtg.decideAction(moveDown, true);
+      }
+      for (int s = 0; s < std::abs(placement.shift); s++) {
+        mtg.decideAction(placement.shift < 0 ? moveLeft : moveRight, false);
+      }
+      while (!mtg.isCurrentTetrominoPlaced) {
+        mtg.decideAction(moveDown, true);
+      }
+
+      BitBoard expected = empty;
+      expected.apply(placement);
+      for (int row = 0; row < BitBoard::rows; row++) {
+        for (int col = 0; col < BitBoard::cols; col++) {
+          Point point{row + BitBoard::firstRow, col + BitBoard::firstCol,
+                      NamedColors::BLACK};
+          ASSERT_EQ(expected.isOccupied(row, col), mtg.gameField[point]);
+        }
+      }
+
+      // Both use the same Zobrist keys.
+      ASSERT_EQ(expected.getHash(), mtg.getBoardHash());
+      delete mtg.currentTetromino;
+    }
+  }
+}
+
+TEST(BitBoardLineRemoving, BitBoard) {
+  BitBoard board;
+  for (int col = 0; col < BitBoard::cols; col++) {
+    board.setCell(BitBoard::rows - 1, col);
+    board.setCell(BitBoard::rows - 3, col);
+  }
+  board.setCell(BitBoard::rows - 2, 0);
+  board.setCell(BitBoard::rows - 4, 5);
+
+  ASSERT_EQ(2, board.clearFullRows());
+  ASSERT_TRUE(board.isOccupied(BitBoard::rows - 1, 0));
+  ASSERT_TRUE(board.isOccupied(BitBoard::rows - 2, 5));
+  ASSERT_EQ(1, board.columnHeight(0));
+  ASSERT_EQ(2, board.columnHeight(5));
+
+  // Hash after removing rows equals hash of the same board built by hand.
+  BitBoard expected;
+  expected.setCell(BitBoard::rows - 1, 0);
+  expected.setCell(BitBoard::rows - 2, 5);
+  ASSERT_TRUE(board == expected);
+  ASSERT_EQ(expected.getHash(), board.getHash());
+}
+
+// Hard drop lands where pressing down would, after the number of rows
+// dropDistance() says, and gives the same points.
+TEST(MockTetrisGameHardDrop, MockTetrisGame) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+  UserInput moveLeft;
+  moveLeft.keycode_ = 260;
+  UserInput rotateRight;
+  rotateRight.keycode_ = 's';
+  UserInput hardDrop;
+  hardDrop.keycode_ = ' ';
+
+  MockTetrisGame soft(0, 's', 'a');
+  MockTetrisGame hard(0, 's', 'a');
+  PieceGenerator generator(6);
+  TetrisBot bot(EvaluationWeights::defaults());
+
+  for (int i = 0; i < 60; i++) {
+    int piece = generator.nextPiece();
+    Placement placement;
+    ASSERT_TRUE(bot.choosePlacement(soft.toBitBoard(), piece, -1, &placement));
+    const Orientation &orientation =
+        BitBoard::getOrientation(piece, placement.orientation);
+
+    for (MockTetrisGame *mtg : {&soft, &hard}) {
+      mtg->currentTetromino = mtg->chooseTetromino(piece);
+      for (int r = 0; r < orientation.rotations; r++) {
+        mtg->decideAction(rotateRight, false);
+      }
+      for (int r = 0; r < orientation.startRow; r++) {
+        mtg->decideAction(moveDown, false);
+      }
+      for (int s = 0; s < std::abs(placement.shift); s++) {
+        mtg->decideAction(placement.shift < 0 ? moveLeft : moveRight, false);
+      }
+    }
+
+    int distance = soft.dropDistance();
+    int moves = 0;
+    do {
+      soft.decideAction(moveDown, false);
+      moves += 1;
+    } while (!soft.isCurrentTetrominoPlaced);
+    ASSERT_EQ(distance + 1, moves);
+    hard.decideAction(hardDrop, false);
+    ASSERT_TRUE(hard.isCurrentTetrominoPlaced);
+
+    delete soft.currentTetromino;
+    delete hard.currentTetromino;
+    ASSERT_TRUE(soft.toBitBoard() == hard.toBitBoard());
+    ASSERT_EQ(soft.destroyedLines, hard.destroyedLines);
+    ASSERT_EQ(soft.currentPoints, hard.currentPoints);
+    ASSERT_FALSE(hard.isGameOver);
+  }
+  ASSERT_GT(hard.destroyedLines, 0);
+}
+
+// Column masks are kept next to the rows (BitBoard) and next to gameField
+// (game), both have to describe the same cells after line clears.
+TEST(ColumnMasksMatchCells, BitBoard) {
+  BitBoard board;
+  for (int row = 12; row < BitBoard::rows; row++) {
+    for (int col = 0; col < BitBoard::cols; col++) {
+      if (col != row % BitBoard::cols) {
+        board.setCell(row, col);
+      }
+    }
+  }
+  PieceGenerator generator(4);
+  TetrisBot bot(EvaluationWeights::defaults());
+  int removedRows = 0;
+  for (int step = 0; step < 200; step++) {
+    Placement placement;
+    int result = -1;
+    if (bot.choosePlacement(board, generator.nextPiece(), -1, &placement)) {
+      result = board.apply(placement);
+    }
+    if (result == -1) {
+      board = BitBoard();
+      continue;
+    }
+    removedRows += result;
+    for (int col = 0; col < BitBoard::cols; col++) {
+      uint32_t expected = 0;
+      for (int row = 0; row < BitBoard::rows; row++) {
+        expected |= (uint32_t)board.isOccupied(row, col) << row;
+      }
+      ASSERT_EQ(expected, board.getColumn(col));
+    }
+  }
+  ASSERT_GT(removedRows, 0);
+
+  MockTetrisGame mtg(0, 's', 'a');
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+  UserInput moveLeft;
+  moveLeft.keycode_ = 260;
+
+  // Same line as in MockTetrisGameHashing: I, I and an O on top of the
+  // gap, the bottom line is removed.
+  mtg.currentTetromino = new TetrominoI();
+  for (int i = 0; i < 3; i++) {
+    mtg.decideAction(moveLeft, false);
+  }
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+  mtg.currentTetromino = new TetrominoI();
+  mtg.decideAction(moveRight, false);
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+  mtg.currentTetromino = new TetrominoO();
+  for (int i = 0; i < 4; i++) {
+    mtg.decideAction(moveRight, false);
+  }
+  while (!mtg.isCurrentTetrominoPlaced) {
+    mtg.decideAction(moveDown, false);
+  }
+  delete mtg.currentTetromino;
+  ASSERT_EQ(1, mtg.destroyedLines);
+
+  for (int col = 0; col < BitBoard::cols; col++) {
+    uint32_t expected = 0;
+    for (int row = 0; row < BitBoard::rows; row++) {
+      Point point{BitBoard::firstRow + row, BitBoard::firstCol + col,
+                  NamedColors::BLACK};
+      expected |= (uint32_t)mtg.gameField[point] << row;
+    }
+    ASSERT_EQ(expected, mtg.getColumnMask(col));
+  }
+  // Only the upper half of O is left.
+  ASSERT_EQ(1u << (BitBoard::rows - 1),
+            mtg.getColumnMask(BitBoard::cols - 1));
+}
+
+TEST(HeadlessGameBot, HeadlessGame) {
+  HeadlessGame game(7);
+  HeadlessGame sameSeed(7);
+  TranspositionTable table(1 << 16);
+  TetrisBot bot(EvaluationWeights::defaults(), &table);
+
+  ASSERT_EQ(game.getCurrentPiece(), sameSeed.getCurrentPiece());
+  ASSERT_EQ(game.getNextPiece(), sameSeed.getNextPiece());
+
+  // The default weights should easily survive 200 tetrominos.
+  while (!game.isGameOver() && game.getPiecesPlaced() < 200) {
+    Placement placement;
+    ASSERT_TRUE(bot.choosePlacement(game.getBoard(), game.getCurrentPiece(),
+                                    game.getNextPiece(), &placement));
+    game.play(placement);
+  }
+
+  ASSERT_FALSE(game.isGameOver());
+  ASSERT_EQ(200, game.getPiecesPlaced());
+  ASSERT_GT(game.getDestroyedLines(), 50);
+  ASSERT_GT(game.getScore(), 0);
+
+  int placed = 0;
+  for (int i = 0; i < 7; i++) {
+    placed += game.getStatistics(i);
+  }
+  ASSERT_EQ(200, placed);
+}
+
+// Undoing placements in reverse order gives back every earlier game, with
+// removed rows, score, level and the tetromino sequence.
+TEST(HeadlessGameUndo, HeadlessGame) {
+  auto isSameGame = [](const HeadlessGame &a, const HeadlessGame &b) {
+    bool isSame = a.getBoard() == b.getBoard() &&
+                  a.getPositionHash() == b.getPositionHash() &&
+                  a.getCurrentPiece() == b.getCurrentPiece() &&
+                  a.getNextPiece() == b.getNextPiece() &&
+                  a.getLevel() == b.getLevel() &&
+                  a.getDestroyedLines() == b.getDestroyedLines() &&
+                  a.getScore() == b.getScore() &&
+                  a.getPiecesPlaced() == b.getPiecesPlaced() &&
+                  a.isGameOver() == b.isGameOver();
+    for (int j = 0; j < BitBoard::cols; j++) {
+      isSame = isSame && a.getBoard().getColumn(j) == b.getBoard().getColumn(j);
+    }
+    for (int i = 0; i < 7; i++) {
+      isSame = isSame && a.getStatistics(i) == b.getStatistics(i);
+    }
+    return isSame;
+  };
+
+  HeadlessGame game(11, 8);
+  TetrisBot bot(EvaluationWeights::defaults());
+  std::vector<HeadlessGame> before;
+  std::vector<HeadlessGame::Undo> undos;
+  std::vector<Placement> played;
+
+  // The bot removes rows (and the level changes), then bad placements
+  // end the game. One more placement after the game over does nothing.
+  while (before.empty() || !before.back().isGameOver()) {
+    Placement placements[BitBoard::maxPlacements];
+    int count = game.generatePlacements(placements);
+    ASSERT_GT(count, 0);
+    Placement placement = placements[played.size() * 7 % count];
+    if (played.size() < 100) {
+      ASSERT_TRUE(bot.choosePlacement(game.getBoard(), game.getCurrentPiece(),
+                                      game.getNextPiece(), &placement));
+    }
+
+    // Every placement can be taken back right away.
+    for (int i = 0; i < count; i++) {
+      HeadlessGame::Undo undo;
+      HeadlessGame copy = game;
+      game.play(placements[i], &undo);
+      game.undo(undo);
+      ASSERT_TRUE(isSameGame(copy, game));
+    }
+
+    before.push_back(game);
+    undos.emplace_back();
+    played.push_back(placement);
+    game.play(placement, &undos.back());
+  }
+  ASSERT_GT(game.getDestroyedLines(), 10);
+  ASSERT_GT(game.getLevel(), 8);
+
+  for (int i = undos.size() - 1; i >= 0; i--) {
+    game.undo(undos[i]);
+    ASSERT_TRUE(isSameGame(before[i], game));
+  }
+
+  // Same tetrominos as before the undo.
+  for (size_t i = 0; i < played.size(); i++) {
+    ASSERT_TRUE(isSameGame(before[i], game));
+    game.play(played[i]);
+  }
+}
+
+TEST(BotSearchAnytime, BotSearch) {
+  TranspositionTable table(1 << 16);
+  BotSearch search(EvaluationWeights::defaults(), &table);
+  BitBoard board;
+  Placement placement;
+
+  // Without time the first iteration still gives an answer.
+  auto now = std::chrono::steady_clock::now();
+  ASSERT_TRUE(search.search(board, 6, 0, now, 4, &placement));
+  ASSERT_EQ(1, search.getCompletedDepth());
+  ASSERT_EQ(6, placement.piece);
+
+  // With enough time it goes deeper.
+  auto later = now + std::chrono::seconds(60);
+  ASSERT_TRUE(search.search(board, 6, 0, later, 2, &placement));
+  ASSERT_EQ(2, search.getCompletedDepth());
+
+  // Pondering in the background, stopped by commit().
+  search.start(board, 0, 3);
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  ASSERT_TRUE(search.commit(&placement));
+  ASSERT_GE(search.getCompletedDepth(), 1);
+  ASSERT_EQ(0, placement.piece);
+}
+
+TEST(BotSearchReusesTree, BotSearch) {
+  TranspositionTable table(1 << 16);
+  BotSearch search(EvaluationWeights::defaults(), &table);
+  search.setBeamWidth(2);
+  BitBoard board;
+  Placement placement;
+
+  auto later = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+  ASSERT_TRUE(search.search(board, 2, 5, later, 3, &placement));
+  ASSERT_EQ(0, search.getReusedNodes());
+  long long firstCreated = search.getCreatedNodes();
+
+  // Next tetromino after the chosen placement: the subtree is reused.
+  board.apply(placement);
+  ASSERT_TRUE(search.search(board, 5, 1, later, 3, &placement));
+  ASSERT_GT(search.getReusedNodes(), 0);
+  ASSERT_LT(search.getCreatedNodes(), firstCreated);
+
+  // A board the search has never seen starts from scratch.
+  BitBoard other;
+  other.setCell(BitBoard::rows - 1, 0);
+  ASSERT_TRUE(search.search(other, 1, 3, later, 1, &placement));
+  ASSERT_EQ(0, search.getReusedNodes());
+}
+
+// The bot plays the real game rules (MockTetrisGame) with the same keys
+// TetrisGame would press and the board has to be what the bot expected.
+TEST(BotSearchPlaysMockGame, BotSearch) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+  UserInput moveLeft;
+  moveLeft.keycode_ = 260;
+  UserInput rotateRight;
+  rotateRight.keycode_ = 's';
+
+  MockTetrisGame mtg(0, 's', 'a');
+  PieceGenerator generator(3);
+  TranspositionTable table(1 << 16);
+  BotSearch search(EvaluationWeights::defaults(), &table);
+
+  int current = generator.nextPiece();
+  int next = generator.nextPiece();
+  for (int i = 0; i < 60; i++) {
+    BitBoard board = mtg.toBitBoard();
+    Placement placement;
+    ASSERT_TRUE(search.search(board, current, next,
+                              std::chrono::steady_clock::now(), 2,
+                              &placement));
+
+    const Orientation &orientation =
+        BitBoard::getOrientation(placement.piece, placement.orientation);
+    mtg.currentTetromino = mtg.chooseTetromino(current);
+    for (int r = 0; r < orientation.rotations; r++) {
+      mtg.decideAction(rotateRight, false);
+    }
+    for (int r = 0; r < orientation.startRow; r++) {
+      mtg.decideAction(moveDown, true);
+    }
+    for (int s = 0; s < std::abs(placement.shift); s++) {
+      mtg.decideAction(placement.shift < 0 ? moveLeft : moveRight, false);
+    }
+    while (!mtg.isCurrentTetrominoPlaced) {
+      mtg.decideAction(moveDown, true);
+    }
+    delete mtg.currentTetromino;
+
+    board.apply(placement);
+    ASSERT_TRUE(board == mtg.toBitBoard());
+    ASSERT_EQ(board.getHash(), mtg.getBoardHash());
+    ASSERT_FALSE(mtg.isGameOver);
+
+    current = next;
+    next = generator.nextPiece();
+  }
+  ASSERT_GT(mtg.destroyedLines, 10);
+}
+
+// Every placement on an empty field can be reached with the finesse keys,
+// never with more keys than rotating and shifting, and the game puts the
+// tetromino exactly there.
+TEST(FinesseMatchesGame, Finesse) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput keys[4];
+  keys[(int)FinesseKey::Left].keycode_ = 260;
+  keys[(int)FinesseKey::Right].keycode_ = 261;
+  keys[(int)FinesseKey::RotateLeft].keycode_ = 'a';
+  keys[(int)FinesseKey::RotateRight].keycode_ = 's';
+
+  BitBoard empty;
+  Placement placements[BitBoard::maxPlacements];
+
+  for (int piece = 0; piece < 7; piece++) {
+    int count = empty.generatePlacements(piece, placements);
+    for (int i = 0; i < count; i++) {
+      const Placement &placement = placements[i];
+      const Orientation &orientation =
+          BitBoard::getOrientation(piece, placement.orientation);
+      const FinesseEntry *entry = Finesse::get(placement);
+      ASSERT_NE(nullptr, entry);
+      ASSERT_LE(entry->length,
+                orientation.rotations + std::abs(placement.shift));
+
+      MockTetrisGame mtg(0, 's', 'a');
+      mtg.currentTetromino = mtg.chooseTetromino(piece);
+      for (int k = 0; k < entry->length; k++) {
+        mtg.decideAction(keys[(int)entry->keys[k]], false);
+      }
+      while (!mtg.isCurrentTetrominoPlaced) {
+        mtg.decideAction(moveDown, true);
+      }
+      delete mtg.currentTetromino;
+
+      BitBoard expected = empty;
+      expected.apply(placement);
+      ASSERT_TRUE(expected == mtg.toBitBoard());
+    }
+  }
+
+  // Three right rotations are one left rotation.
+  const FinesseEntry *entry = Finesse::get(6, 3, 0);
+  ASSERT_NE(nullptr, entry);
+  ASSERT_EQ(1, entry->length);
+  ASSERT_EQ(FinesseKey::RotateLeft, entry->keys[0]);
+  ASSERT_EQ(2, Finesse::wastedInputs(Placement{6, 3, 0, 18}, 3));
+  ASSERT_EQ(nullptr, Finesse::get(0, 0, BitBoard::cols));
+}
+
+// Stepping several games on several threads gives the same games as
+// playing each of them alone.
+TEST(VecEnvMatchesHeadlessGame, VecEnv) {
+  const int numberOfEnvs = 5;
+  VecEnv env(numberOfEnvs, 3);
+  ASSERT_EQ(3, env.getNumberOfThreads());
+
+  std::vector<uint64_t> seeds = {1, 2, 3, 4, 5};
+  std::vector<float> observations(numberOfEnvs * VecEnv::observationSize);
+  std::vector<uint8_t> masks(numberOfEnvs * VecEnv::numberOfActions);
+  std::vector<float> rewards(numberOfEnvs);
+  std::vector<uint8_t> dones(numberOfEnvs);
+  std::vector<int> actions(numberOfEnvs);
+  std::vector<float> expectedRewards(numberOfEnvs);
+  std::vector<uint8_t> expectedDones(numberOfEnvs);
+  env.reset(seeds.data(), observations.data(), masks.data());
+
+  std::vector<HeadlessGame> games;
+  for (uint64_t seed : seeds) {
+    games.emplace_back(seed);
+  }
+
+  int finishedGames = 0;
+  for (int step = 0; step < 300; step++) {
+    for (int i = 0; i < numberOfEnvs; i++) {
+      const float *observation = &observations[i * VecEnv::observationSize];
+      const uint8_t *mask = &masks[i * VecEnv::numberOfActions];
+      const BitBoard &board = games[i].getBoard();
+      for (int row = 0; row < BitBoard::rows; row++) {
+        for (int col = 0; col < BitBoard::cols; col++) {
+          ASSERT_EQ(board.isOccupied(row, col),
+                    observation[row * BitBoard::cols + col] == 1);
+        }
+      }
+      ASSERT_EQ(1, observation[200 + games[i].getCurrentPiece()]);
+      ASSERT_EQ(1, observation[207 + games[i].getNextPiece()]);
+
+      // Always take the last possible action, the reference game plays
+      // the same placement.
+      Placement placements[BitBoard::maxPlacements];
+      int count = games[i].generatePlacements(placements);
+      ASSERT_EQ(count, std::count(mask, mask + VecEnv::numberOfActions, 1));
+      actions[i] = VecEnv::numberOfActions - 1;
+      while (mask[actions[i]] == 0) {
+        actions[i] -= 1;
+      }
+      const Placement &last = placements[count - 1];
+      int column =
+          BitBoard::getOrientation(last.piece, last.orientation).minCol +
+          last.shift;
+      ASSERT_EQ(last.orientation * BitBoard::cols + column, actions[i]);
+
+      int score = games[i].getScore();
+      games[i].play(last);
+      expectedRewards[i] = games[i].getScore() - score;
+      expectedDones[i] = games[i].isGameOver();
+      if (games[i].isGameOver()) {
+        seeds[i] = seeds[i] * 6364136223846793005ull + 1442695040888963407ull;
+        games[i].reset(seeds[i]);
+        finishedGames += 1;
+      }
+    }
+
+    env.step(actions.data(), observations.data(), rewards.data(),
+             dones.data(), masks.data());
+    for (int i = 0; i < numberOfEnvs; i++) {
+      ASSERT_EQ(games[i].getPiecesPlaced(),
+                env.getGame(i).getPiecesPlaced());
+      ASSERT_TRUE(games[i].getBoard() == env.getGame(i).getBoard());
+      ASSERT_EQ(expectedRewards[i], rewards[i]);
+      ASSERT_EQ(expectedDones[i], dones[i]);
+    }
+  }
+  ASSERT_GT(finishedGames, 0);
+  ASSERT_EQ(300 * numberOfEnvs, env.getSteps());
+}
+
+// The C interface plays the same game as HeadlessGame.
+TEST(CApiMatchesHeadlessGame, TetrisCApi) {
+  ASSERT_EQ(TETRIS_API_VERSION, tetris_api_version());
+  TetrisGameHandle *game = tetris_create(11, 2);
+  ASSERT_NE(nullptr, game);
+  HeadlessGame expected(11, 2);
+
+  TetrisPlacement placements[TETRIS_MAX_PLACEMENTS];
+  Placement expectedPlacements[BitBoard::maxPlacements];
+  while (!tetris_is_game_over(game)) {
+    int count = tetris_placements(game, placements, TETRIS_MAX_PLACEMENTS);
+    ASSERT_EQ(expected.generatePlacements(expectedPlacements), count);
+    ASSERT_EQ(expected.getCurrentPiece(), tetris_current_piece(game));
+    ASSERT_EQ(expected.getNextPiece(), tetris_next_piece(game));
+
+    int i = tetris_pieces_placed(game) % count;
+    ASSERT_EQ(expected.play(expectedPlacements[i]),
+              tetris_step(game, &placements[i]));
+    ASSERT_EQ(expected.getPositionHash(), tetris_position_hash(game));
+  }
+  ASSERT_TRUE(expected.isGameOver());
+  ASSERT_EQ(expected.getScore(), tetris_score(game));
+  ASSERT_EQ(expected.getLevel(), tetris_level(game));
+
+  uint16_t rows[TETRIS_ROWS];
+  ASSERT_EQ(TETRIS_ROWS, tetris_board(game, rows, TETRIS_ROWS + 5));
+  for (int row = 0; row < TETRIS_ROWS; row++) {
+    ASSERT_EQ(expected.getBoard().getRow(row), rows[row]);
+  }
+
+  // Placements that are not possible don't change the game.
+  tetris_reset(game, 11, 0);
+  TetrisPlacement invalid{tetris_current_piece(game), 0, 0, 0};
+  ASSERT_EQ(TETRIS_ERROR_PLACEMENT, tetris_step(game, &invalid));
+  ASSERT_EQ(0, tetris_pieces_placed(game));
+  ASSERT_EQ(TETRIS_ERROR_ARGUMENT, tetris_step(nullptr, &invalid));
+  tetris_destroy(game);
+}
+
+// Straight drops on SimdBoards (with and without AVX2) give the same boards
+// as BitBoard.
+TEST(SimdBoardsMatchBitBoard, SimdBoards) {
+  for (bool useAvx2 : {false, true}) {
+    SimdBoards boards;
+    boards.setUseAvx2(useAvx2);
+    // Almost full rows with one gap, so that rows get removed.
+    BitBoard start[SimdBoards::lanes];
+    BitBoard expected[SimdBoards::lanes];
+    for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+      for (int row = 12; row < BitBoard::rows; row++) {
+        for (int col = 0; col < BitBoard::cols; col++) {
+          if (col != (lane + row / 4) % BitBoard::cols) {
+            start[lane].setCell(row, col);
+          }
+        }
+      }
+      boards.setBoard(lane, start[lane]);
+      expected[lane] = start[lane];
+    }
+    PieceGenerator generator(5);
+    int removedRows = 0;
+    int gameOvers = 0;
+
+    for (int step = 0; step < 400; step++) {
+      int8_t pieces[SimdBoards::lanes];
+      int8_t orientations[SimdBoards::lanes];
+      int8_t shifts[SimdBoards::lanes];
+      int8_t removed[SimdBoards::lanes];
+      int expectedRemoved[SimdBoards::lanes];
+
+      for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+        int piece = generator.nextPiece();
+        int o = generator.nextPiece() % BitBoard::numberOfOrientations(piece);
+        const Orientation &orientation = BitBoard::getOrientation(piece, o);
+        int columns =
+            BitBoard::cols - (orientation.maxCol - orientation.minCol);
+        int shift = generator.nextPiece() % columns - orientation.minCol;
+        pieces[lane] = piece;
+        orientations[lane] = o;
+        shifts[lane] = shift;
+
+        // Highest cell starts at row 0.
+        int minRow =
+            *std::min_element(orientation.rows, orientation.rows + 4);
+        int drop = -minRow;
+        if (expected[lane].collides(piece, o, drop, shift)) {
+          expectedRemoved[lane] = -1;
+          continue;
+        }
+        while (!expected[lane].collides(piece, o, drop + 1, shift)) {
+          drop += 1;
+        }
+        expectedRemoved[lane] =
+            expected[lane].apply(Placement{piece, o, shift, drop});
+      }
+
+      boards.drop(pieces, orientations, shifts, removed);
+      for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+        ASSERT_EQ(expectedRemoved[lane], removed[lane]);
+        if (removed[lane] == -1) {
+          boards.setBoard(lane, start[lane]);
+          expected[lane] = start[lane];
+          gameOvers += 1;
+        } else {
+          removedRows += removed[lane];
+        }
+        ASSERT_TRUE(expected[lane] == boards.getBoard(lane));
+      }
+    }
+    ASSERT_GT(gameOvers, 0);
+    ASSERT_GT(removedRows, 0);
+  }
+}
+
+TEST(BatchEvaluatorMatchesTetrisBot, BatchEvaluator) {
+  EvaluationWeights weights = EvaluationWeights::defaults();
+  TetrisBot bot(weights);
+  for (bool useAvx2 : {false, true}) {
+    BatchEvaluator batch;
+    batch.setUseAvx2(useAvx2);
+    PieceGenerator generator(9);
+    BitBoard board;
+    int evaluated = 0;
+
+    // Random placements, so the boards get holes, wells and high columns.
+    for (int step = 0; step < 300; step++) {
+      Placement placements[BitBoard::maxPlacements];
+      int count = board.generatePlacements(generator.nextPiece(), placements);
+      BitBoard children[BitBoard::maxPlacements];
+      batch.clear();
+      for (int i = 0; i < count; i++) {
+        children[i] = board;
+        children[i].apply(placements[i]);
+        ASSERT_EQ(i, batch.add(children[i]));
+      }
+      ASSERT_EQ(count, batch.size());
+
+      double features[BatchEvaluator::maxBoards *
+                      EvaluationWeights::numberOfFeatures];
+      double values[BatchEvaluator::maxBoards];
+      batch.computeFeatures(features);
+      batch.evaluate(weights, values);
+      for (int i = 0; i < count; i++) {
+        double expected[EvaluationWeights::numberOfFeatures];
+        TetrisBot::computeFeatures(children[i], 0, expected);
+        for (int f = 0; f < EvaluationWeights::numberOfFeatures; f++) {
+          ASSERT_EQ(expected[f],
+                    features[i * EvaluationWeights::numberOfFeatures + f]);
+        }
+        ASSERT_EQ(bot.evaluateBoard(children[i]), values[i]);
+        evaluated += 1;
+      }
+
+      int chosen = count == 0 ? -1 : generator.nextPiece() % count;
+      if (chosen == -1 || board.apply(placements[chosen]) == -1) {
+        board = BitBoard();
+      }
+    }
+    ASSERT_GT(evaluated, 1000);
+  }
+}
+
+TEST(InputQueueKeepsOrder, InputQueue) {
+  InputQueue queue;
+  UserInput userInput;
+  ASSERT_FALSE(queue.pop(&userInput));
+
+  // Full queue drops new keys and counts them.
+  for (uint32_t i = 0; i < InputQueue::capacity + 3; i++) {
+    userInput.keycode_ = i;
+    ASSERT_EQ(i < InputQueue::capacity, queue.push(userInput));
+  }
+  ASSERT_EQ(3, queue.getDroppedInputs());
+  for (uint32_t i = 0; i < InputQueue::capacity; i++) {
+    ASSERT_TRUE(queue.pop(&userInput));
+    ASSERT_EQ((int)i, userInput.keycode_);
+  }
+  ASSERT_FALSE(queue.pop(&userInput));
+
+  // One producer thread, the consumer gets every key in order.
+  const int numberOfKeys = 200'000;
+  std::thread producer([&queue]() {
+    UserInput key;
+    for (int i = 0; i < numberOfKeys; i++) {
+      key.keycode_ = i;
+      while (!queue.push(key)) {
+        std::this_thread::yield();
+      }
+    }
+  });
+  int expected = 0;
+  while (expected < numberOfKeys) {
+    if (queue.pop(&userInput)) {
+      EXPECT_EQ(expected, userInput.keycode_);
+      expected += 1;
+    }
+  }
+  producer.join();
+  ASSERT_FALSE(queue.pop(&userInput));
+}
+
+TEST(TripleBufferNewestFrame, TripleBuffer) {
+  TripleBuffer<std::vector<int>> buffer(std::vector<int>(64, 0));
+  ASSERT_FALSE(buffer.update());
+
+  buffer.back()[0] = 1;
+  ASSERT_TRUE(buffer.publish());
+  ASSERT_TRUE(buffer.update());
+  ASSERT_EQ(1, buffer.front()[0]);
+  ASSERT_FALSE(buffer.update());
+
+  // Two frames before the reader looks: the first one is dropped.
+  buffer.back()[0] = 2;
+  ASSERT_TRUE(buffer.publish());
+  buffer.back()[0] = 3;
+  ASSERT_FALSE(buffer.publish());
+  ASSERT_TRUE(buffer.update());
+  ASSERT_EQ(3, buffer.front()[0]);
+
+  // Writer and reader threads: the reader only sees whole frames, in
+  // order, and every frame is either read or dropped.
+  const int numberOfFrames = 100'000;
+  long long dropped = 0;
+  std::thread writer([&buffer, &dropped]() {
+    for (int frame = 4; frame < 4 + numberOfFrames; frame++) {
+      std::vector<int> &back = buffer.back();
+      std::fill(back.begin(), back.end(), frame);
+      if (!buffer.publish()) {
+        dropped += 1;
+      }
+    }
+  });
+  int last = 3;
+  long long read = 0;
+  while (last < 3 + numberOfFrames) {
+    if (!buffer.update()) {
+      continue;
+    }
+    const std::vector<int> &front = buffer.front();
+    EXPECT_GT(front[0], last);
+    EXPECT_TRUE(std::all_of(front.begin(), front.end(),
+                            [&front](int value) { return value == front[0]; }));
+    last = front[0];
+    read += 1;
+  }
+  writer.join();
+  ASSERT_EQ(numberOfFrames, read + dropped);
+}
+
+// Gravity intervals of 100, 110 and 80 ms: the jitter moves 1/16 of the
+// way to every difference of two intervals (RFC 3550). A new tetromino
+// starts without a previous interval.
+TEST(OverlayGravityJitter, PerformanceOverlay) {
+  MockTerminalManager mtm(30, 30);
+  PerformanceOverlay overlay(&mtm, 13, 2);
+  auto start = PerformanceOverlay::Clock::time_point() + std::chrono::hours(1);
+  auto at = [start](int ms) { return start + std::chrono::milliseconds(ms); };
+
+  overlay.startTetromino(at(0));
+  overlay.measureGravity(at(100));
+  ASSERT_DOUBLE_EQ(0, overlay.getGravityJitterMs());
+  overlay.measureGravity(at(210));
+  double expected = 10.0 / 16;
+  ASSERT_DOUBLE_EQ(expected, overlay.getGravityJitterMs());
+  overlay.measureGravity(at(290));
+  expected += (30 - expected) / 16;
+  ASSERT_DOUBLE_EQ(expected, overlay.getGravityJitterMs());
+
+  // 50 ms after the new tetromino is not compared with the 80 ms before.
+  overlay.startTetromino(at(1000));
+  overlay.measureGravity(at(1050));
+  ASSERT_DOUBLE_EQ(expected, overlay.getGravityJitterMs());
+  overlay.measureGravity(at(1110));
+  expected += (10 - expected) / 16;
+  ASSERT_DOUBLE_EQ(expected, overlay.getGravityJitterMs());
+
+  // Steady ticks let it decay.
+  for (int i = 2; i < 200; i++) {
+    overlay.measureGravity(at(1050 + 60 * i));
+  }
+  ASSERT_LT(overlay.getGravityJitterMs(), 0.01);
+}
+
+// Frames, bytes and input to draw latency of the terminal manager over the
+// time since the last update of the overlay.
+TEST(OverlayFramesAndLatency, PerformanceOverlay) {
+  MockTerminalManager mtm(30, 30);
+  PerformanceOverlay overlay(&mtm, 13, 2);
+  auto start = PerformanceOverlay::Clock::time_point() + std::chrono::hours(1);
+  auto at = [start](int ms) { return start + std::chrono::milliseconds(ms); };
+
+  // Counted before the overlay is shown, not part of the first period.
+  mtm.renderFrames(5, 500, 1);
+  mtm.drawInput(10'000);
+  overlay.toggle(at(0));
+  ASSERT_TRUE(overlay.isVisible());
+  ASSERT_EQ("PERFORMANCE         ", mtm.getDrawnString(13, 2));
+  ASSERT_EQ("FPS              0.0", mtm.getDrawnString(14, 2));
+  ASSERT_EQ("INPUT MS        0.00", mtm.getDrawnString(15, 2));
+  ASSERT_EQ("DROPPED            1", mtm.getDrawnString(20, 2));
+
+  mtm.renderFrames(30, 3000, 1);
+  mtm.drawInput(2000);
+  mtm.drawInput(4000);
+  // Not yet time for an update.
+  overlay.tick(at(499));
+  ASSERT_EQ("FPS              0.0", mtm.getDrawnString(14, 2));
+  overlay.tick(at(500));
+  ASSERT_EQ("FPS             60.0", mtm.getDrawnString(14, 2));
+  ASSERT_EQ("INPUT MS        3.00", mtm.getDrawnString(15, 2));
+  ASSERT_EQ("INPUT MAX       4.00", mtm.getDrawnString(16, 2));
+  ASSERT_EQ("JITTER MS       0.00", mtm.getDrawnString(17, 2));
+  ASSERT_EQ("BYTES/FR         100", mtm.getDrawnString(18, 2));
+  ASSERT_EQ("DROPPED            2", mtm.getDrawnString(20, 2));
+
+  // The next period starts at the update, without keys.
+  mtm.renderFrames(40, 2000, 0);
+  overlay.tick(at(1300));
+  ASSERT_EQ("FPS             50.0", mtm.getDrawnString(14, 2));
+  ASSERT_EQ("INPUT MS        0.00", mtm.getDrawnString(15, 2));
+  ASSERT_EQ("INPUT MAX       0.00", mtm.getDrawnString(16, 2));
+  ASSERT_EQ("BYTES/FR          50", mtm.getDrawnString(18, 2));
+
+  // Hidden, the overlay is cleared and not updated anymore.
+  overlay.toggle(at(1400));
+  ASSERT_FALSE(overlay.isVisible());
+  for (int i = 0; i < PerformanceOverlay::lines; i++) {
+    ASSERT_EQ("                    ", mtm.getDrawnString(13 + i, 2));
+  }
+  mtm.renderFrames(40, 2000, 0);
+  overlay.tick(at(2000));
+  ASSERT_EQ("                    ", mtm.getDrawnString(14, 2));
+}
+
+// Garbage pushes the board up and leaves one hole per row.
+TEST(BitBoardGarbage, BitBoard) {
+  BitBoard board;
+  board.setCell(BitBoard::rows - 1, 0);
+  ASSERT_TRUE(board.addGarbage(2, 3));
+  ASSERT_TRUE(board.isOccupied(BitBoard::rows - 3, 0));
+  ASSERT_FALSE(board.isOccupied(BitBoard::rows - 1, 3));
+  ASSERT_EQ(BitBoard::fullRow & ~(1 << 3), board.getRow(BitBoard::rows - 2));
+  for (int j = 0; j < BitBoard::cols; j++) {
+    for (int i = 0; i < BitBoard::rows; i++) {
+      ASSERT_EQ(board.isOccupied(i, j), (bool)((board.getColumn(j) >> i) & 1));
+    }
+  }
+  BitBoard same;
+  for (int i = 0; i < BitBoard::rows; i++) {
+    for (int j = 0; j < BitBoard::cols; j++) {
+      if (board.isOccupied(i, j)) {
+        same.setCell(i, j);
+      }
+    }
+  }
+  ASSERT_EQ(same.getHash(), board.getHash());
+
+  // Cells pushed out at the top.
+  ASSERT_FALSE(board.addGarbage(BitBoard::rows - 2, 0));
+}
+
+// Both sides of a versus game end with the game that the real inputs give,
+// however late the remote inputs arrive.
+TEST(RollbackMatchesLockstep, Versus) {
+  const int frames = 200;
+  VersusGame lockstep(5);
+  TetrisBot bot(EvaluationWeights::defaults());
+  std::vector<VersusInput> inputs[2];
+  for (int frame = 0; frame < frames; frame++) {
+    VersusInput frameInputs[2];
+    for (int player = 0; player < 2; player++) {
+      const HeadlessGame &game = lockstep.getPlayer(player);
+      Placement placement;
+      frameInputs[player] = VersusInput{3, 9};
+      // Now and then an input that no placement has.
+      if ((frame + player) % 7 != 0 &&
+          bot.choosePlacement(game.getBoard(), game.getCurrentPiece(),
+                              game.getNextPiece(), &placement)) {
+        frameInputs[player] = VersusInput::fromPlacement(placement);
+      }
+      inputs[player].push_back(frameInputs[player]);
+    }
+    lockstep.step(frameInputs);
+  }
+  ASSERT_GT(lockstep.getGarbageSent(0) + lockstep.getGarbageSent(1), 0);
+
+  // Player 1 gets the inputs of player 0 three frames late, player 0 gets
+  // them in bursts.
+  RollbackSession sides[2] = {RollbackSession(VersusGame(5), 0),
+                              RollbackSession(VersusGame(5), 1)};
+  int delivered[2] = {0, 0};
+  while (sides[0].getConfirmedFrame() < frames ||
+         sides[1].getConfirmedFrame() < frames) {
+    for (int player = 0; player < 2; player++) {
+      RollbackSession &side = sides[player];
+      if (side.canAdvance() && side.getFrame() < frames) {
+        side.advance(inputs[player][side.getFrame()]);
+      }
+    }
+    while (delivered[0] < sides[0].getFrame() - 3 ||
+           (sides[0].getFrame() == frames && delivered[0] < frames)) {
+      ASSERT_TRUE(
+          sides[1].addRemoteInput(delivered[0], inputs[0][delivered[0]]));
+      delivered[0] += 1;
+    }
+    if (sides[1].getFrame() % 5 == 0 || sides[1].getFrame() == frames) {
+      while (delivered[1] < sides[1].getFrame()) {
+        ASSERT_TRUE(
+            sides[0].addRemoteInput(delivered[1], inputs[1][delivered[1]]));
+        delivered[1] += 1;
+      }
+    }
+    for (RollbackSession &side : sides) {
+      side.synchronize();
+      ASSERT_LE(side.getFrame() - side.getConfirmedFrame(),
+                RollbackSession::maxRollbackFrames);
+    }
+  }
+  for (RollbackSession &side : sides) {
+    ASSERT_EQ(lockstep.getHash(), side.getConfirmedGame().getHash());
+    ASSERT_EQ(lockstep.getHash(), side.getGame().getHash());
+    ASSERT_GT(side.getRollbacks(), 0);
+  }
+  ASSERT_FALSE(sides[0].addRemoteInput(0, VersusInput()));
+}
+
+// A snapshot brings back the same game: board with colors, current
+// tetromino in its place, preview, counters and the tetromino sequence.
+// Broken files are rejected.
+TEST(SnapshotRoundTrip, Snapshot) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput moveRight;
+  moveRight.keycode_ = 261;
+
+  // Same steps as TetrisGame::play() for the first tetromino.
+  MockTetrisGame mtg(3, 's', 'a');
+  mtg.rngState = 42;
+  mtg.generateCurrentAndNext();
+  mtg.deque.push_back(mtg.currentRandomNumber);
+  mtg.deque.push_back(mtg.nextRandomNumber);
+  mtg.currentTetrominoIndex = mtg.deque.front();
+  mtg.deque.pop_front();
+  mtg.currentTetromino = mtg.chooseTetromino(mtg.currentTetrominoIndex);
+  mtg.updatePieceHash(mtg.currentTetrominoIndex, mtg.deque.front());
+  mtg.decideAction(moveDown, false);
+  mtg.decideAction(moveDown, false);
+  mtg.decideAction(moveRight, false);
+
+  // The game gives the same tetrominos as PieceGenerator.
+  PieceGenerator generator(42);
+  ASSERT_EQ(generator.nextPiece(), mtg.currentTetrominoIndex);
+  ASSERT_EQ(generator.nextPiece(), mtg.deque.front());
+
+  Point block{mtg.offset_row + 20, mtg.offset_col + 4,
+              NamedColors::TETROMINO_Z};
+  mtg.toggleCell(block);
+  mtg.gameField.erase(block);
+  mtg.gameField.insert(std::pair(block, true));
+  mtg.destroyedLines = 12;
+  mtg.previousQuotient = 1;
+  mtg.currentPoints = 1234;
+  mtg.statistics[5] = 7;
+
+  GameSnapshot snapshot = mtg.takeSnapshot();
+  ASSERT_TRUE(snapshot.isValid());
+  std::string path = "snapshot-test.bin";
+  ASSERT_TRUE(snapshot.save(path));
+
+  MappedSnapshot mapped;
+  ASSERT_TRUE(mapped.open(path));
+  ASSERT_EQ(0, std::memcmp(&snapshot, mapped.get(), sizeof(GameSnapshot)));
+
+  MockTetrisGame restored(0, 's', 'a');
+  restored.restoreSnapshot(*mapped.get());
+  ASSERT_EQ(mtg.getPositionHash(), restored.getPositionHash());
+  ASSERT_EQ(mtg.computeBoardHash(), restored.computeBoardHash());
+  for (int j = 0; j < BitBoard::cols; j++) {
+    ASSERT_EQ(mtg.getColumnMask(j), restored.getColumnMask(j));
+  }
+  ASSERT_EQ(NamedColors::TETROMINO_Z,
+            restored.gameField.find(block)->first.color);
+  ASSERT_EQ(mtg.currentTetromino->getCurrentLocation(),
+            restored.currentTetromino->getCurrentLocation());
+  ASSERT_EQ(mtg.currentLevel, restored.currentLevel);
+  ASSERT_EQ(mtg.currentSpeed, restored.currentSpeed);
+  ASSERT_EQ(1234, restored.currentPoints);
+  ASSERT_EQ(7, restored.statistics[5]);
+  ASSERT_EQ(mtg.deque, restored.deque);
+  GameSnapshot again = restored.takeSnapshot();
+  ASSERT_EQ(0, std::memcmp(&snapshot, &again, sizeof(GameSnapshot)));
+  mtg.generateCurrentAndNext();
+  restored.generateCurrentAndNext();
+  ASSERT_EQ(mtg.currentRandomNumber, restored.currentRandomNumber);
+  ASSERT_EQ(mtg.nextRandomNumber, restored.nextRandomNumber);
+
+  // A headless game continues with the same tetrominos.
+  HeadlessGame headless;
+  headless.restore(snapshot);
+  ASSERT_EQ(mtg.toBitBoard().getHash(), headless.getBoard().getHash());
+  ASSERT_EQ(mtg.currentTetrominoIndex, headless.getCurrentPiece());
+  ASSERT_EQ(mtg.deque.front(), headless.getNextPiece());
+  ASSERT_EQ(1234, headless.getScore());
+  Placement placements[BitBoard::maxPlacements];
+  ASSERT_GT(headless.generatePlacements(placements), 0);
+  headless.play(placements[0]);
+  ASSERT_EQ(generator.nextPiece(), headless.getNextPiece());
+
+  // Changed bytes and short files are not loaded.
+  std::string broken = "snapshot-broken-test.bin";
+  GameSnapshot changed = snapshot;
+  changed.score += 1;
+  ASSERT_TRUE(changed.save(broken));
+  MappedSnapshot rejected;
+  ASSERT_FALSE(rejected.open(broken));
+  FILE *file = fopen(broken.c_str(), "wb");
+  fwrite(&snapshot, sizeof(GameSnapshot) - 1, 1, file);
+  fclose(file);
+  ASSERT_FALSE(rejected.open(broken));
+  ASSERT_FALSE(rejected.open("no-such-snapshot.bin"));
+  ASSERT_EQ(nullptr, rejected.get());
+  std::remove(path.c_str());
+  std::remove(broken.c_str());
+
+  delete mtg.currentTetromino;
+  delete restored.currentTetromino;
+}
+
+// A snapshot with the right checksum can still be made up: fields out of
+// range are rejected before a game uses them.
+TEST(SnapshotRejectsBadFields, Snapshot) {
+  UserInput moveDown;
+  moveDown.keycode_ = 258;
+  UserInput rotateLeft;
+  rotateLeft.keycode_ = 'a';
+
+  // A J tetromino turned left once is at 270 degrees.
+  MockTetrisGame mtg(0, 's', 'a');
+  mtg.deque.push_back(2);
+  mtg.deque.push_back(3);
+  mtg.currentTetrominoIndex = 1;
+  mtg.currentTetromino = mtg.chooseTetromino(1);
+  mtg.decideAction(moveDown, false);
+  mtg.decideAction(moveDown, false);
+  mtg.decideAction(rotateLeft, false);
+  ASSERT_EQ(270, mtg.currentTetromino->getCurrentAngle());
+
+  GameSnapshot snapshot = mtg.takeSnapshot();
+  ASSERT_TRUE(snapshot.isValid());
+  ASSERT_TRUE(snapshot.isPlayable());
+  std::string path = "snapshot-fields-test.bin";
+  ASSERT_TRUE(snapshot.save(path));
+  MappedSnapshot mapped;
+  ASSERT_TRUE(mapped.open(path));
+  MockTetrisGame restored(0, 's', 'a');
+  restored.restoreSnapshot(*mapped.get());
+  ASSERT_EQ(270, restored.currentTetromino->getCurrentAngle());
+  ASSERT_EQ(mtg.currentTetromino->getCurrentLocation(),
+            restored.currentTetromino->getCurrentLocation());
+
+  auto isLoaded = [&path](GameSnapshot changed) {
+    changed.seal();
+    MappedSnapshot loaded;
+    return changed.save(path) && loaded.open(path);
+  };
+  GameSnapshot changed = snapshot;
+  changed.currentPiece = 7;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.currentPiece = -2;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.nextPiece = 100;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.pendingPiece = -7;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.boardRows[19] = 1;
+  changed.colors[19][0] = 200;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.boardRows[19] = 1 << GameSnapshot::cols;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.currentAngle = 4;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.currentCols[2] = GameSnapshot::cols;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.currentRows[0] = GameSnapshot::rows;
+  ASSERT_FALSE(isLoaded(changed));
+  changed = snapshot;
+  changed.level = -1;
+  ASSERT_FALSE(isLoaded(changed));
+
+  // Without a current tetromino its cells don't matter.
+  changed = snapshot;
+  changed.currentPiece = -1;
+  changed.currentAngle = 100;
+  ASSERT_TRUE(isLoaded(changed));
+  std::remove(path.c_str());
+
+  delete mtg.currentTetromino;
+  delete restored.currentTetromino;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Headless engine and bot tests end
+// --------------------------------------------------------------------------------------------------------------------
+
+// --------------------------------------------------------------------------------------------------------------------
+// Server and spectator tests start
+// --------------------------------------------------------------------------------------------------------------------
+
+TEST(GameServerMatchesHeadlessGame, GameServer) {
+  std::string path = "server-test.sock";
+  GameServer server;
+  ASSERT_TRUE(server.start(path));
+
+  const int numberOfClients = 3;
+  std::vector<std::unique_ptr<MessageConnection>> clients;
+  for (int i = 0; i < numberOfClients; i++) {
+    clients.push_back(
+        std::make_unique<MessageConnection>(LocalSocket::connect(path, 1000)));
+    ASSERT_TRUE(clients.back()->isOpen());
+  }
+  auto send = [&](int client, ServerMessageType type, const void *body,
+                  uint8_t size) {
+    ServerMessageHeader header{static_cast<uint8_t>(type), size};
+    ASSERT_TRUE(clients[client]->send(&header, sizeof(header)));
+    ASSERT_TRUE(clients[client]->send(body, size));
+  };
+  // Serve until the client has an update.
+  auto receive = [&](int client, RemoteGame *game) {
+    ServerMessageHeader header;
+    for (int i = 0; i < 1000; i++) {
+      server.poll(1);
+      clients[client]->receive();
+      if (clients[client]->peek(&header, sizeof(header)) &&
+          clients[client]->available() >= sizeof(header) + header.size) {
+        break;
+      }
+    }
+    uint8_t body[256];
+    ASSERT_TRUE(clients[client]->pop(&header, sizeof(header)));
+    ASSERT_EQ(static_cast<uint8_t>(ServerMessageType::Update), header.type);
+    ASSERT_TRUE(clients[client]->pop(body, header.size));
+    ASSERT_TRUE(game->apply(body, header.size));
+  };
+
+  // Every client plays the bot, the server has to end up with the same
+  // game as a local one.
+  TetrisBot bot(EvaluationWeights::defaults());
+  RemoteGame remotes[numberOfClients];
+  HeadlessGame locals[numberOfClients];
+  for (int client = 0; client < numberOfClients; client++) {
+    // Levels above what fits into a byte arrive unchanged.
+    StartMessage start{(uint64_t)client + 7, client * 150, 0};
+    send(client, ServerMessageType::Start, &start, sizeof(start));
+    locals[client].reset(start.seed, start.level);
+    receive(client, &remotes[client]);
+  }
+  ASSERT_EQ(numberOfClients, server.getSessions());
+
+  for (int step = 0; step < 60; step++) {
+    for (int client = 0; client < numberOfClients; client++) {
+      HeadlessGame &local = locals[client];
+      Placement placement;
+      if (local.isGameOver() ||
+          !bot.choosePlacement(local.getBoard(), local.getCurrentPiece(),
+                               local.getNextPiece(), &placement)) {
+        continue;
+      }
+      VersusInput input = VersusInput::fromPlacement(placement);
+      send(client, ServerMessageType::Input, &input, sizeof(input));
+      int removedRows = local.play(placement);
+      receive(client, &remotes[client]);
+
+      const UpdateMessage &update = remotes[client].getLastUpdate();
+      ASSERT_EQ(removedRows, update.removedRows);
+      ASSERT_EQ(local.getScore(), update.score);
+      ASSERT_EQ(local.getDestroyedLines(), update.lines);
+      ASSERT_EQ(local.getLevel(), update.level);
+      ASSERT_EQ(local.getCurrentPiece(), update.currentPiece);
+      ASSERT_EQ(local.getNextPiece(), update.nextPiece);
+      for (int i = 0; i < BitBoard::rows; i++) {
+        ASSERT_EQ(local.getBoard().getRow(i),
+                  remotes[client].getBoard().getRow(i));
+      }
+    }
+  }
+  ASSERT_GT(locals[0].getDestroyedLines(), 0);
+  ASSERT_GT(server.getSessionBytes(), numberOfClients * sizeof(HeadlessGame));
+
+  // Inputs before a start aren't this protocol, the session is closed.
+  MessageConnection stranger(LocalSocket::connect(path, 1000));
+  VersusInput input;
+  ServerMessageHeader header{static_cast<uint8_t>(ServerMessageType::Input),
+                             sizeof(input)};
+  ASSERT_TRUE(stranger.send(&header, sizeof(header)));
+  ASSERT_TRUE(stranger.send(&input, sizeof(input)));
+  bool isOpen = true;
+  for (int i = 0; i < 1000 && isOpen; i++) {
+    server.poll(1);
+    isOpen = stranger.receive();
+  }
+  ASSERT_FALSE(isOpen);
+  ASSERT_EQ(numberOfClients, server.getSessions());
+
+  clients.clear();
+  for (int i = 0; i < 100 && server.getSessions() > 0; i++) {
+    server.poll(1);
+  }
+  ASSERT_EQ(0, server.getSessions());
+}
+
+TEST(SpectatorDeltasRebuildBoard, Spectator) {
+  SpectatorEncoder encoder;
+  SpectatorDecoder decoder;
+  SpectatorBoard board;
+  std::vector<uint8_t> frame;
+  uint64_t random = 88172645463325252ull;
+  size_t keyframeBytes = 0;
+  size_t deltaBytes = 0;
+  for (int step = 0; step < 200; step++) {
+    // A few cells change, like a tetromino moving.
+    for (int i = 0; i < 4; i++) {
+      random ^= random << 13;
+      random ^= random >> 7;
+      random ^= random << 17;
+      int row = random % SpectatorBoard::rows;
+      int col = (random >> 8) % SpectatorBoard::cols;
+      board.cells[row] ^= 1 << col;
+      board.colors[row][col] = (random >> 16) % 11;
+    }
+    board.score = step * 10;
+    // Counters larger than a byte or a short arrive unchanged.
+    board.lines = 40'000 + step;
+    board.level = 130 + step / 10;
+    ASSERT_TRUE(encoder.encode(board, &frame));
+    SpectatorFrameHeader header;
+    std::memcpy(&header, frame.data(), sizeof(header));
+    if (header.type == static_cast<uint8_t>(SpectatorFrameType::Keyframe)) {
+      keyframeBytes = frame.size();
+    } else {
+      deltaBytes = std::max(deltaBytes, frame.size());
+    }
+    ASSERT_TRUE(decoder.apply(frame.data(), frame.size()));
+    ASSERT_TRUE(decoder.hasBoard());
+    ASSERT_TRUE(decoder.getBoard() == board);
+  }
+  ASSERT_EQ(200 / SpectatorEncoder::keyframeInterval + 1,
+            decoder.getKeyframes());
+  ASSERT_LT(deltaBytes, keyframeBytes / 2);
+  // Nothing changed, no frame.
+  ASSERT_FALSE(encoder.encode(board, &frame));
+
+  // A missing frame: the deltas are ignored until the next keyframe.
+  SpectatorDecoder late;
+  SpectatorEncoder restarted;
+  std::vector<std::vector<uint8_t>> frames;
+  for (int step = 0; step < 2 * SpectatorEncoder::keyframeInterval; step++) {
+    board.score += 1;
+    frames.emplace_back();
+    ASSERT_TRUE(restarted.encode(board, &frames.back()));
+  }
+  ASSERT_TRUE(late.apply(frames[0].data(), frames[0].size()));
+  ASSERT_TRUE(late.apply(frames[2].data(), frames[2].size()));
+  ASSERT_FALSE(late.hasBoard());
+  ASSERT_EQ(1, late.getMissedFrames());
+  for (size_t i = 3; i < frames.size(); i++) {
+    ASSERT_TRUE(late.apply(frames[i].data(), frames[i].size()));
+  }
+  ASSERT_TRUE(late.hasBoard());
+  ASSERT_TRUE(late.getBoard() == board);
+}
+
+TEST(SpectatorHubSkipsSlowSpectators, Spectator) {
+  std::string path = "spectator-test.sock";
+  SpectatorHub hub;
+  ASSERT_TRUE(hub.start(path));
+  SpectatorPublisher publisher;
+  ASSERT_TRUE(publisher.connect(path));
+
+  auto connectSpectator = [&]() {
+    auto connection =
+        std::make_unique<MessageConnection>(LocalSocket::connect(path, 1000));
+    SpectatorRole role = SpectatorRole::Spectator;
+    EXPECT_TRUE(connection->send(&role, sizeof(role)));
+    return connection;
+  };
+  auto fast = connectSpectator();
+  auto slow = connectSpectator();
+  for (int i = 0; i < 10; i++) {
+    hub.poll(1);
+  }
+  ASSERT_TRUE(hub.hasPublisher());
+  ASSERT_EQ(2, hub.getSpectators());
+
+  SpectatorDecoder fastDecoder;
+  SpectatorDecoder slowDecoder;
+  std::vector<uint8_t> frame;
+  auto read = [&](MessageConnection *connection, SpectatorDecoder *decoder) {
+    connection->receive();
+    while (popSpectatorFrame(connection, &frame)) {
+      ASSERT_TRUE(decoder->apply(frame.data(), frame.size()));
+    }
+  };
+
+  // Every row changes in every frame, the slow spectator never reads.
+  SpectatorBoard board;
+  const int floodFrames = 3000;
+  for (int step = 0; step < floodFrames; step++) {
+    for (int i = 0; i < SpectatorBoard::rows; i++) {
+      board.cells[i] = (step + i) & 0x3ff;
+    }
+    board.score = step;
+    publisher.publish(board);
+    hub.poll(0);
+    read(fast.get(), &fastDecoder);
+    ASSERT_TRUE(fastDecoder.getBoard() == board);
+  }
+  ASSERT_EQ(0, publisher.getDroppedFrames());
+  ASSERT_EQ(0, fastDecoder.getMissedFrames());
+  ASSERT_GT(hub.getSkippedFrames(), 0);
+
+  // Reading again, the slow spectator continues with the next keyframe.
+  for (int step = 0; step < 2 * SpectatorEncoder::keyframeInterval; step++) {
+    board.score += 1;
+    publisher.publish(board);
+    for (int i = 0; i < 20; i++) {
+      hub.poll(0);
+      read(slow.get(), &slowDecoder);
+    }
+    read(fast.get(), &fastDecoder);
+  }
+  ASSERT_GT(slowDecoder.getMissedFrames(), 0);
+  ASSERT_TRUE(slowDecoder.hasBoard());
+  ASSERT_TRUE(slowDecoder.getBoard() == board);
+  ASSERT_TRUE(fastDecoder.getBoard() == board);
+  ASSERT_EQ(0, fastDecoder.getMissedFrames());
+
+  // A new spectator starts with the last keyframe.
+  auto late = connectSpectator();
+  SpectatorDecoder lateDecoder;
+  for (int i = 0; i < 20; i++) {
+    hub.poll(1);
+    read(late.get(), &lateDecoder);
+  }
+  ASSERT_TRUE(lateDecoder.hasBoard());
+  ASSERT_TRUE(lateDecoder.getBoard() == board);
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// Server and spectator tests end
+// --------------------------------------------------------------------------------------------------------------------
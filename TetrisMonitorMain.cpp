@@ -0,0 +1,86 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Prints the live counters of a game started with --telemetry=<name>
+// (see Telemetry.h). The game doesn't notice the monitor.
+//
+// Usage:
+//
+// ./TetrisMonitorMain --name=<name> --interval=<ms> --once
+//
+
+#include "./Telemetry.h"
+#include <chrono>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+void print(const TelemetrySnapshot &snapshot) {
+  std::cout << "pid=" << snapshot.pid << " pieces=" << snapshot.piecesPlaced
+            << " lines=" << snapshot.lines << " level=" << snapshot.level
+            << " speed_ms=" << snapshot.speedMs << " score=" << snapshot.score
+            << " frame_us_p50=" << snapshot.frameTimeP50Us
+            << " frame_us_p90=" << snapshot.frameTimeP90Us
+            << " frame_us_p99=" << snapshot.frameTimeP99Us
+            << " input_queue=" << snapshot.inputQueueDepth
+            << " dropped_inputs=" << snapshot.droppedInputs
+            << " dropped_frames=" << snapshot.droppedFrames
+            << " bot_created_nodes=" << snapshot.botCreatedNodes
+            << " bot_reused_nodes=" << snapshot.botReusedNodes
+            << " game_over=" << snapshot.isGameOver << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string name = "tetris";
+  int intervalMs = 1000;
+  bool once = false;
+
+  const option longOptions[] = {{"name", required_argument, nullptr, 'n'},
+                                {"interval", required_argument, nullptr, 'i'},
+                                {"once", no_argument, nullptr, 'o'},
+                                {nullptr, 0, nullptr, 0}};
+  while (true) {
+    const auto option = getopt_long(argc, argv, "n:i:o", longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 'n':
+      name = optarg;
+      break;
+    case 'i':
+      intervalMs = std::stoi(optarg);
+      break;
+    case 'o':
+      once = true;
+      break;
+    default:
+      std::cout << "--name <name>:   Same as --telemetry of the game.\n"
+                   "--interval <ms>: Time between two lines.\n"
+                   "--once:          Print one line and stop.\n";
+      return 1;
+    }
+  }
+
+  TelemetryReader reader;
+  if (!reader.open("/" + name)) {
+    std::cerr << "No game with --telemetry=" << name << std::endl;
+    return 1;
+  }
+
+  TelemetrySnapshot snapshot;
+  while (true) {
+    if (reader.read(&snapshot)) {
+      print(snapshot);
+      if (once || snapshot.isGameOver) {
+        return 0;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+  }
+}
@@ -0,0 +1,120 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Random-policy rollouts on SimdBoards, mainly to measure how many
+// tetrominos per second one core can drop.
+//
+// Usage:
+//
+// ./TetrisRolloutMain --pieces=<n> --seed=<n>
+//
+
+#include "./SimdBoards.h"
+#include <chrono>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+
+namespace {
+
+// xorshift64*, one per lane.
+uint64_t nextRandom(uint64_t *state) {
+  *state ^= *state >> 12;
+  *state ^= *state << 25;
+  *state ^= *state >> 27;
+  return *state * 0x2545f4914f6cdd1d;
+}
+
+struct RolloutResult {
+  long long pieces = 0;
+  long long games = 0;
+  long long lines = 0;
+  double seconds = 0;
+};
+
+RolloutResult rollout(bool useAvx2, long long pieces, uint64_t seed) {
+  SimdBoards boards;
+  boards.setUseAvx2(useAvx2);
+
+  uint64_t random[SimdBoards::lanes];
+  for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+    random[lane] = seed + 0x9e3779b97f4a7c15 * (lane + 1);
+  }
+
+  int8_t piece[SimdBoards::lanes];
+  int8_t orientation[SimdBoards::lanes];
+  int8_t shift[SimdBoards::lanes];
+  int8_t removedRows[SimdBoards::lanes];
+
+  RolloutResult result;
+  auto start = std::chrono::steady_clock::now();
+  while (result.pieces < pieces) {
+    for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+      uint64_t r = nextRandom(&random[lane]);
+      piece[lane] = r % 7;
+      orientation[lane] =
+          (r >> 8) % BitBoard::numberOfOrientations(piece[lane]);
+      const Orientation &o =
+          BitBoard::getOrientation(piece[lane], orientation[lane]);
+      int shifts = BitBoard::cols - (o.maxCol - o.minCol);
+      shift[lane] = (r >> 16) % shifts - o.minCol;
+    }
+
+    boards.drop(piece, orientation, shift, removedRows);
+
+    for (int lane = 0; lane < SimdBoards::lanes; lane++) {
+      if (removedRows[lane] == -1) {
+        boards.clear(lane);
+        result.games += 1;
+      } else {
+        result.lines += removedRows[lane];
+      }
+    }
+    result.pieces += SimdBoards::lanes;
+  }
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  return result;
+}
+
+void print(const std::string &name, const RolloutResult &result) {
+  std::cout << name << ": " << result.pieces << " tetrominos, "
+            << result.games << " games, " << result.lines << " lines, "
+            << (long long)(result.pieces / result.seconds) << " tetrominos/s"
+            << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  long long pieces = 10'000'000;
+  uint64_t seed = 1;
+
+  const option longOptions[] = {{"pieces", required_argument, nullptr, 'p'},
+                                {"seed", required_argument, nullptr, 's'},
+                                {nullptr, 0, nullptr, 0}};
+  while (true) {
+    const auto option = getopt_long(argc, argv, "p:s:", longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 'p':
+      pieces = std::stoll(optarg);
+      break;
+    case 's':
+      seed = std::stoull(optarg);
+      break;
+    default:
+      std::cout << "--pieces <n>: Number of tetrominos to drop.\n"
+                   "--seed <n>:   Seed of the random policy.\n";
+      return 1;
+    }
+  }
+
+  print("scalar", rollout(false, pieces, seed));
+  if (SimdBoards::hasAvx2()) {
+    print("avx2", rollout(true, pieces, seed));
+  }
+}
@@ -0,0 +1,273 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Server for many headless games at once (see GameServer.h), and a client
+// that plays many of them to measure it.
+//
+// Usage:
+//
+// ./TetrisServerMain --socket=<path> --report=<seconds>
+// ./TetrisServerMain --socket=<path> --clients=<n> --seconds=<s> --rate=<r>
+//
+// The server prints its sessions, requests and memory every --report
+// seconds. The client opens --clients games, places --rate tetrominos per
+// second in each of them and prints the latency of the updates.
+//
+
+#include "./GameServer.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <string>
+#include <sys/epoll.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t isStopped = 0;
+
+void stopServer(int) { isStopped = 1; }
+
+// Resident memory of the process.
+int64_t residentBytes() {
+  std::ifstream statm("/proc/self/statm");
+  int64_t pages = 0;
+  int64_t residentPages = 0;
+  statm >> pages >> residentPages;
+  return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+int runServer(const std::string &path, int reportSeconds) {
+  GameServer server;
+  if (!server.start(path)) {
+    std::cerr << "Can't listen on " << path << std::endl;
+    return 1;
+  }
+  std::signal(SIGINT, stopServer);
+  std::signal(SIGTERM, stopServer);
+  std::cout << "Listening on " << path << std::endl;
+
+  // Memory before any session, to get the memory per session.
+  int64_t idleBytes = residentBytes();
+  auto lastReport = std::chrono::steady_clock::now();
+  int64_t lastCpuUs = ServerProcess::cpuTimeUs();
+  long long lastRequests = 0;
+  while (!isStopped) {
+    server.poll(100);
+    auto now = std::chrono::steady_clock::now();
+    auto elapsedUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - lastReport)
+            .count();
+    if (elapsedUs < reportSeconds * 1'000'000ll) {
+      continue;
+    }
+
+    // The loop is one thread, so it can use one core at most: sessions per
+    // core is the number of sessions if the load filled that core.
+    int sessions = server.getSessions();
+    int64_t cpuUs = ServerProcess::cpuTimeUs();
+    double cpuFraction = (double)(cpuUs - lastCpuUs) / elapsedUs;
+    long long requests = server.getRequests();
+    int64_t residentPerSession =
+        sessions > 0 ? (residentBytes() - idleBytes) / sessions : 0;
+    std::cout << "sessions=" << sessions << " requests_per_s="
+              << (requests - lastRequests) * 1'000'000 / elapsedUs
+              << " cpu_percent=" << (int)(cpuFraction * 100)
+              << " sessions_per_core="
+              << (cpuFraction > 0.01 ? (long long)(sessions / cpuFraction) : 0)
+              << " session_bytes="
+              << (sessions > 0 ? server.getSessionBytes() / sessions : 0)
+              << " resident_bytes_per_session=" << residentPerSession
+              << std::endl;
+    lastReport = now;
+    lastCpuUs = cpuUs;
+    lastRequests = requests;
+  }
+  return 0;
+}
+
+// One game of the measuring client.
+struct Client {
+  explicit Client(int fd) : connection(fd) {}
+  MessageConnection connection;
+  RemoteGame game;
+  bool isWaiting = false;
+  std::chrono::steady_clock::time_point sent;
+  std::chrono::steady_clock::time_point nextInput;
+};
+
+bool sendMessage(Client *client, ServerMessageType type, const void *body,
+                 uint8_t size) {
+  uint8_t message[sizeof(ServerMessageHeader) + 255];
+  ServerMessageHeader header{static_cast<uint8_t>(type), size};
+  std::memcpy(message, &header, sizeof(header));
+  std::memcpy(message + sizeof(header), body, size);
+  client->isWaiting = true;
+  client->sent = std::chrono::steady_clock::now();
+  return client->connection.send(message, sizeof(header) + size);
+}
+
+bool startGame(Client *client, uint64_t seed) {
+  StartMessage start{seed, 0, 0};
+  client->game.reset();
+  return sendMessage(client, ServerMessageType::Start, &start, sizeof(start));
+}
+
+int64_t percentile(std::vector<int64_t> *values, int p) {
+  if (values->empty()) {
+    return 0;
+  }
+  size_t index = std::min(values->size() - 1, values->size() * p / 100);
+  std::nth_element(values->begin(), values->begin() + index, values->end());
+  return (*values)[index];
+}
+
+int runClients(const std::string &path, int numberOfClients, int seconds,
+               double rate) {
+  int epollFd = epoll_create1(0);
+  std::vector<std::unique_ptr<Client>> clients;
+  auto now = std::chrono::steady_clock::now();
+  auto period = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+      std::chrono::duration<double>(1 / rate));
+  uint64_t random = 0x9e3779b97f4a7c15;
+  for (int i = 0; i < numberOfClients; i++) {
+    int fd = LocalSocket::connect(path, 10'000);
+    if (fd == -1) {
+      std::cerr << "Connected only " << i << " clients" << std::endl;
+      return 1;
+    }
+    auto client = std::make_unique<Client>(fd);
+    // Spread the inputs over the period.
+    client->nextInput = now + period * i / numberOfClients;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = i;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    startGame(client.get(), i + 1);
+    clients.push_back(std::move(client));
+  }
+
+  std::vector<int64_t> latenciesUs;
+  long long updates = 0;
+  long long updateBytes = 0;
+  long long mismatches = 0;
+  long long games = numberOfClients;
+  auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+  while (std::chrono::steady_clock::now() < end) {
+    epoll_event events[256];
+    int count = epoll_wait(epollFd, events, 256, 1);
+    now = std::chrono::steady_clock::now();
+    for (int i = 0; i < count; i++) {
+      Client *client = clients[events[i].data.u32].get();
+      if (!client->connection.receive()) {
+        std::cerr << "The server closed a connection" << std::endl;
+        return 1;
+      }
+      ServerMessageHeader header;
+      while (client->connection.peek(&header, sizeof(header)) &&
+             client->connection.available() >= sizeof(header) + header.size) {
+        uint8_t body[256];
+        client->connection.pop(&header, sizeof(header));
+        client->connection.pop(body, header.size);
+        mismatches += !client->game.apply(body, header.size);
+        updates += 1;
+        updateBytes += sizeof(header) + header.size;
+        latenciesUs.push_back(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                now - client->sent)
+                .count());
+        client->isWaiting = false;
+      }
+    }
+
+    for (auto &client : clients) {
+      if (client->isWaiting || now < client->nextInput) {
+        continue;
+      }
+      client->nextInput += period;
+      if (client->game.getLastUpdate().isGameOver) {
+        games += 1;
+        startGame(client.get(), games);
+        continue;
+      }
+      // xorshift64
+      random ^= random << 13;
+      random ^= random >> 7;
+      random ^= random << 17;
+      VersusInput input{static_cast<int8_t>(random % 4),
+                        static_cast<int8_t>((random >> 8) % 10 - 4)};
+      sendMessage(client.get(), ServerMessageType::Input, &input,
+                  sizeof(input));
+    }
+  }
+
+  std::cout << "clients=" << numberOfClients << " games=" << games
+            << " updates_per_s=" << updates / seconds
+            << " bytes_per_update=" << (updates > 0 ? updateBytes / updates : 0)
+            << " mismatches=" << mismatches
+            << " latency_us_p50=" << percentile(&latenciesUs, 50)
+            << " latency_us_p99=" << percentile(&latenciesUs, 99)
+            << " latency_us_max=" << percentile(&latenciesUs, 100)
+            << std::endl;
+  close(epollFd);
+  return mismatches == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string path = "tetris-server.sock";
+  int reportSeconds = 5;
+  int numberOfClients = 0;
+  int seconds = 10;
+  double rate = 2;
+
+  const option longOptions[] = {{"socket", required_argument, nullptr, 's'},
+                                {"report", required_argument, nullptr, 'r'},
+                                {"clients", required_argument, nullptr, 'c'},
+                                {"seconds", required_argument, nullptr, 't'},
+                                {"rate", required_argument, nullptr, 'p'},
+                                {nullptr, 0, nullptr, 0}};
+  while (true) {
+    const auto option =
+        getopt_long(argc, argv, "s:r:c:t:p:", longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 's':
+      path = optarg;
+      break;
+    case 'r':
+      reportSeconds = std::stoi(optarg);
+      break;
+    case 'c':
+      numberOfClients = std::stoi(optarg);
+      break;
+    case 't':
+      seconds = std::stoi(optarg);
+      break;
+    case 'p':
+      rate = std::stod(optarg);
+      break;
+    default:
+      std::cout << "--socket <path>:    Socket of the server.\n"
+                   "--report <seconds>: Statistics of the server.\n"
+                   "--clients <n>:      Play n games on a running server.\n"
+                   "--seconds <s>:      Duration of the client.\n"
+                   "--rate <r>:         Placements per second and game.\n";
+      return 1;
+    }
+  }
+
+  ServerProcess::raiseFileLimit();
+  if (numberOfClients > 0) {
+    return runClients(path, numberOfClients, std::max(1, seconds), rate);
+  }
+  return runServer(path, std::max(1, reportSeconds));
+}
@@ -0,0 +1,392 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Spectators of a running game (see Spectator.h).
+//
+// Usage:
+//
+// ./TetrisSpectateMain --hub --socket=<path>
+// ./TetrisGameMain --spectate=<path>
+// ./TetrisSpectateMain --watch --socket=<path>
+//
+// The hub passes the frames of the game to all spectators. --watch draws
+// the board in the terminal. Without a terminal game, --demo publishes a
+// bot game, and --spectators=<n> connects n spectators (--slow of them
+// never read) and prints what they received.
+//
+
+#include "./HeadlessGame.h"
+#include "./Point.h"
+#include "./Spectator.h"
+#include "./TetrisBot.h"
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <poll.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+volatile std::sig_atomic_t isStopped = 0;
+
+void stop(int) { isStopped = 1; }
+
+int runHub(const std::string &path, int reportSeconds) {
+  SpectatorHub hub;
+  if (!hub.start(path)) {
+    std::cerr << "Can't listen on " << path << std::endl;
+    return 1;
+  }
+  std::cout << "Listening on " << path << std::endl;
+
+  auto lastReport = std::chrono::steady_clock::now();
+  int64_t lastCpuUs = ServerProcess::cpuTimeUs();
+  long long lastFrames = 0;
+  long long lastBytes = 0;
+  while (!isStopped) {
+    hub.poll(100);
+    auto now = std::chrono::steady_clock::now();
+    auto elapsedUs =
+        std::chrono::duration_cast<std::chrono::microseconds>(now - lastReport)
+            .count();
+    if (elapsedUs < reportSeconds * 1'000'000ll) {
+      continue;
+    }
+    int64_t cpuUs = ServerProcess::cpuTimeUs();
+    std::cout << "publisher=" << hub.hasPublisher()
+              << " spectators=" << hub.getSpectators() << " frames_per_s="
+              << (hub.getFrames() - lastFrames) * 1'000'000 / elapsedUs
+              << " bytes_sent_per_s="
+              << (hub.getBytesSent() - lastBytes) * 1'000'000 / elapsedUs
+              << " skipped_frames=" << hub.getSkippedFrames()
+              << " cpu_percent=" << (cpuUs - lastCpuUs) * 100 / elapsedUs
+              << std::endl;
+    lastReport = now;
+    lastCpuUs = cpuUs;
+    lastFrames = hub.getFrames();
+    lastBytes = hub.getBytesSent();
+  }
+  return 0;
+}
+
+std::unique_ptr<MessageConnection> connectSpectator(const std::string &path) {
+  auto connection =
+      std::make_unique<MessageConnection>(LocalSocket::connect(path, 5000));
+  SpectatorRole role = SpectatorRole::Spectator;
+  if (!connection->isOpen() || !connection->send(&role, sizeof(role))) {
+    return nullptr;
+  }
+  return connection;
+}
+
+// The board with ANSI colors, from the top left corner of the terminal.
+void drawBoard(const SpectatorDecoder &decoder) {
+  static const int ansiColors[] = {31, 30, 94, 96, 34, 33, 93, 32, 91, 35, 97};
+  const SpectatorBoard &board = decoder.getBoard();
+  std::string text = "\x1b[H";
+  for (int i = 0; i < SpectatorBoard::rows; i++) {
+    text += "<!";
+    for (int j = 0; j < SpectatorBoard::cols; j++) {
+      int color = board.colors[i][j];
+      if (((board.cells[i] >> j) & 1) && color < 11) {
+        text += "\x1b[" + std::to_string(ansiColors[color]) + "m[]\x1b[0m";
+      } else {
+        text += " .";
+      }
+    }
+    text += "!>\n";
+  }
+  text += "<!====================!>\n";
+  text += "SCORE " + std::to_string(board.score) + "  LINES " +
+          std::to_string(board.lines) + "  LEVEL " +
+          std::to_string(board.level) + "  MISSED " +
+          std::to_string(decoder.getMissedFrames()) +
+          (board.isGameOver ? "  GAME OVER" : "") + "\x1b[K\n";
+  std::cout << text << std::flush;
+}
+
+int runWatch(const std::string &path) {
+  auto connection = connectSpectator(path);
+  if (connection == nullptr) {
+    std::cerr << "No hub on " << path << std::endl;
+    return 1;
+  }
+  std::cout << "\x1b[2J";
+  SpectatorDecoder decoder;
+  std::vector<uint8_t> frame;
+  while (!isStopped) {
+    bool isOpen = connection->receive();
+    bool isChanged = false;
+    while (popSpectatorFrame(connection.get(), &frame)) {
+      decoder.apply(frame.data(), frame.size());
+      isChanged = true;
+    }
+    if (isChanged && decoder.hasBoard()) {
+      drawBoard(decoder);
+    }
+    if (!isOpen) {
+      break;
+    }
+    pollfd waiting{connection->getFd(), POLLIN, 0};
+    ::poll(&waiting, 1, 100);
+  }
+  return 0;
+}
+
+// Bot game without a terminal. HeadlessGame has no colors, so they are
+// kept here, like the game field of TetrisGame.
+int runDemo(const std::string &path, int framesPerSecond) {
+  SpectatorPublisher publisher;
+  if (!publisher.connect(path)) {
+    std::cerr << "No hub on " << path << std::endl;
+    return 1;
+  }
+  TetrisBot bot(EvaluationWeights::defaults());
+  uint64_t seed = 1;
+  HeadlessGame game(seed);
+  SpectatorBoard board;
+  auto period = std::chrono::microseconds(1'000'000 / framesPerSecond);
+  auto next = std::chrono::steady_clock::now();
+  long long frames = 0;
+  while (!isStopped && publisher.isOpen()) {
+    Placement placement;
+    if (game.isGameOver() ||
+        !bot.choosePlacement(game.getBoard(), game.getCurrentPiece(),
+                             game.getNextPiece(), &placement)) {
+      seed += 1;
+      game.reset(seed);
+      board = SpectatorBoard();
+    } else {
+      uint8_t color = static_cast<uint8_t>(NamedColors::TETROMINO_I) +
+                      game.getCurrentPiece();
+      HeadlessGame::Undo undo;
+      game.play(placement, &undo);
+      uint32_t removedRows = undo.board.removedRows;
+
+      // Rows before the removal: full ones where rows were removed, the
+      // rows that stayed below and above them.
+      uint16_t placedRows[SpectatorBoard::rows] = {};
+      for (int i = SpectatorBoard::rows - 1, k = i; i >= 0; i--) {
+        placedRows[i] = ((removedRows >> i) & 1)
+                            ? (1 << SpectatorBoard::cols) - 1
+                            : (k >= 0 ? game.getBoard().getRow(k--) : 0);
+      }
+      for (int i = 0; i < SpectatorBoard::rows; i++) {
+        uint16_t placed = placedRows[i] & ~board.cells[i];
+        for (int j = 0; j < SpectatorBoard::cols; j++) {
+          if ((placed >> j) & 1) {
+            board.colors[i][j] = color;
+          }
+        }
+      }
+      // Remove the rows like the game did.
+      SpectatorBoard cleared = board;
+      std::memset(cleared.colors, 0, sizeof(cleared.colors));
+      for (int i = SpectatorBoard::rows - 1, k = i; i >= 0; i--) {
+        if (!((removedRows >> i) & 1)) {
+          std::memcpy(cleared.colors[k--], board.colors[i],
+                      SpectatorBoard::cols);
+        }
+      }
+      board = cleared;
+      for (int i = 0; i < SpectatorBoard::rows; i++) {
+        board.cells[i] = game.getBoard().getRow(i);
+      }
+    }
+    board.score = game.getScore();
+    board.lines = game.getDestroyedLines();
+    board.level = game.getLevel();
+    board.nextPiece = game.getNextPiece();
+    board.isGameOver = game.isGameOver();
+    publisher.publish(board);
+    frames += 1;
+
+    next += period;
+    std::this_thread::sleep_until(next);
+  }
+  std::cout << "frames=" << frames
+            << " dropped_frames=" << publisher.getDroppedFrames() << std::endl;
+  return 0;
+}
+
+int runSpectators(const std::string &path, int numberOfSpectators,
+                  int slowSpectators, int seconds) {
+  struct Spectator {
+    std::unique_ptr<MessageConnection> connection;
+    SpectatorDecoder decoder;
+    long long frames = 0;
+    long long bytes = 0;
+  };
+  std::vector<Spectator> spectators(numberOfSpectators);
+  std::vector<pollfd> waiting;
+  for (Spectator &spectator : spectators) {
+    spectator.connection = connectSpectator(path);
+    if (spectator.connection == nullptr) {
+      std::cerr << "No hub on " << path << std::endl;
+      return 1;
+    }
+  }
+  int fastSpectators = numberOfSpectators - slowSpectators;
+  for (int i = 0; i < fastSpectators; i++) {
+    waiting.push_back(pollfd{spectators[i].connection->getFd(), POLLIN, 0});
+  }
+
+  long long brokenFrames = 0;
+  std::vector<uint8_t> frame;
+  auto start = std::chrono::steady_clock::now();
+  auto end = start + std::chrono::seconds(seconds);
+  while (!isStopped && std::chrono::steady_clock::now() < end) {
+    ::poll(waiting.data(), waiting.size(), 10);
+    // The slow ones never read.
+    for (int i = 0; i < fastSpectators; i++) {
+      Spectator &spectator = spectators[i];
+      spectator.connection->receive();
+      while (popSpectatorFrame(spectator.connection.get(), &frame)) {
+        brokenFrames += !spectator.decoder.apply(frame.data(), frame.size());
+        spectator.frames += 1;
+        spectator.bytes += frame.size();
+      }
+    }
+  }
+  // Then they catch up: the hub skipped them to a keyframe.
+  std::this_thread::sleep_for(std::chrono::milliseconds(500));
+  long long slowMissed = 0;
+  long long slowKeyframes = 0;
+  for (int i = fastSpectators; i < numberOfSpectators; i++) {
+    Spectator &spectator = spectators[i];
+    while (spectator.connection->receive() &&
+           spectator.connection->available() > 0) {
+      while (popSpectatorFrame(spectator.connection.get(), &frame)) {
+        brokenFrames += !spectator.decoder.apply(frame.data(), frame.size());
+        spectator.frames += 1;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    slowMissed += spectator.decoder.getMissedFrames();
+    slowKeyframes += spectator.decoder.getKeyframes();
+  }
+
+  // All fast spectators saw the same frames.
+  long long frames = 0;
+  long long bytes = 0;
+  long long missed = 0;
+  int differentBoards = 0;
+  for (int i = 0; i < fastSpectators; i++) {
+    frames += spectators[i].frames;
+    bytes += spectators[i].bytes;
+    missed += spectators[i].decoder.getMissedFrames();
+    const SpectatorDecoder &decoder = spectators[i].decoder;
+    const SpectatorDecoder &first = spectators[0].decoder;
+    if (decoder.getFrame() == first.getFrame() &&
+        !(decoder.getBoard() == first.getBoard())) {
+      differentBoards += 1;
+    }
+  }
+  std::cout << "spectators=" << numberOfSpectators
+            << " frames_per_spectator="
+            << (fastSpectators > 0 ? frames / fastSpectators : 0)
+            << " bytes_per_frame=" << (frames > 0 ? bytes / frames : 0)
+            << " missed_frames=" << missed
+            << " broken_frames=" << brokenFrames
+            << " different_boards=" << differentBoards
+            << " slow_spectators=" << slowSpectators
+            << " slow_missed_frames=" << slowMissed
+            << " slow_keyframes=" << slowKeyframes << std::endl;
+  return brokenFrames == 0 && differentBoards == 0 ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string path = "tetris-spectate.sock";
+  bool isHub = false;
+  bool isWatching = false;
+  bool isDemo = false;
+  int numberOfSpectators = 0;
+  int slowSpectators = 0;
+  int seconds = 10;
+  int framesPerSecond = 60;
+  int reportSeconds = 5;
+
+  const option longOptions[] = {
+      {"socket", required_argument, nullptr, 's'},
+      {"hub", no_argument, nullptr, 'u'},
+      {"watch", no_argument, nullptr, 'w'},
+      {"demo", no_argument, nullptr, 'd'},
+      {"spectators", required_argument, nullptr, 'n'},
+      {"slow", required_argument, nullptr, 'l'},
+      {"seconds", required_argument, nullptr, 't'},
+      {"fps", required_argument, nullptr, 'f'},
+      {"report", required_argument, nullptr, 'r'},
+      {nullptr, 0, nullptr, 0}};
+  while (true) {
+    const auto option =
+        getopt_long(argc, argv, "s:uwdn:l:t:f:r:", longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 's':
+      path = optarg;
+      break;
+    case 'u':
+      isHub = true;
+      break;
+    case 'w':
+      isWatching = true;
+      break;
+    case 'd':
+      isDemo = true;
+      break;
+    case 'n':
+      numberOfSpectators = std::stoi(optarg);
+      break;
+    case 'l':
+      slowSpectators = std::stoi(optarg);
+      break;
+    case 't':
+      seconds = std::stoi(optarg);
+      break;
+    case 'f':
+      framesPerSecond = std::stoi(optarg);
+      break;
+    case 'r':
+      reportSeconds = std::stoi(optarg);
+      break;
+    default:
+      std::cout << "--socket <path>:    Socket of the hub.\n"
+                   "--hub:              Pass a game on to its spectators.\n"
+                   "--watch:            Show the game in the terminal.\n"
+                   "--demo:             Publish a bot game.\n"
+                   "--fps <n>:          Frames per second of the demo.\n"
+                   "--spectators <n>:   Connect n spectators and measure.\n"
+                   "--slow <n>:         Spectators that never read.\n"
+                   "--seconds <s>:      Duration of the measurement.\n"
+                   "--report <seconds>: Statistics of the hub.\n";
+      return 1;
+    }
+  }
+
+  std::signal(SIGINT, stop);
+  std::signal(SIGTERM, stop);
+  ServerProcess::raiseFileLimit();
+  if (isHub) {
+    return runHub(path, std::max(1, reportSeconds));
+  } else if (isDemo) {
+    return runDemo(path, std::max(1, framesPerSecond));
+  } else if (numberOfSpectators > 0) {
+    return runSpectators(path, numberOfSpectators,
+                         std::min(slowSpectators, numberOfSpectators),
+                         std::max(1, seconds));
+  } else if (isWatching) {
+    return runWatch(path);
+  }
+  std::cerr << "Use --hub, --watch, --demo or --spectators" << std::endl;
+  return 1;
+}
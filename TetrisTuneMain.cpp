@@ -0,0 +1,376 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Genetic algorithm for the evaluation weights of the bot, as described here:
+// https://codemyroad.wordpress.com/2013/04/14/tetris-ai-the-near-perfect-player/
+//
+// Usage:
+//
+// ./TetrisTuneMain --generations=<n> --population=<n> --games=<n>
+//                  --pieces=<n> --threads=<n> --checkpoint=<file> --seed=<n>
+//
+// After every generation the whole population is written to the checkpoint
+// file. If the file already exists the tuner continues from it, so it can be
+// stopped (Ctrl-C) and started again at any time. The best weights so far are
+// written to <checkpoint>.best and can be given to TetrisGameMain.
+//
+
+#include "./HeadlessGame.h"
+#include "./TetrisBot.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <getopt.h>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct TunerOptions {
+  int generations = 100;
+  int population = 32;
+  int games = 64;
+  int maxPieces = 1000;
+  int threads = std::max(1u, std::thread::hardware_concurrency());
+  bool lookahead = false;
+  uint64_t seed = 1;
+  std::string checkpoint = "TetrisTune.checkpoint";
+};
+
+struct Candidate {
+  EvaluationWeights weights;
+  double fitness = 0;
+};
+
+void printHelp() {
+  std::cout
+      << "--generations <n>:   Number of generations to run.\n"
+         "--population <n>:    Number of candidates per generation.\n"
+         "--games <n>:         Games per candidate (same seeds for all).\n"
+         "--pieces <n>:        Maximal number of tetrominos per game.\n"
+         "--threads <n>:       Number of worker threads.\n"
+         "--lookahead:         Let the bot also use the next tetromino.\n"
+         "--seed <n>:          Seed for games and evolution.\n"
+         "--checkpoint <file>: Checkpoint file (resumed if it exists).\n"
+         "--help:              Show help\n";
+  exit(1);
+}
+
+TunerOptions parseArguments(int argc, char **argv) {
+  TunerOptions options;
+  const char *const shortOptions = "g:p:n:m:t:as:c:h";
+  const option longOptions[] = {
+      {"generations", required_argument, nullptr, 'g'},
+      {"population", required_argument, nullptr, 'p'},
+      {"games", required_argument, nullptr, 'n'},
+      {"pieces", required_argument, nullptr, 'm'},
+      {"threads", required_argument, nullptr, 't'},
+      {"lookahead", no_argument, nullptr, 'a'},
+      {"seed", required_argument, nullptr, 's'},
+      {"checkpoint", required_argument, nullptr, 'c'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, 0, nullptr, 0}};
+
+  while (true) {
+    const auto option =
+        getopt_long(argc, argv, shortOptions, longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 'g':
+      options.generations = std::stoi(optarg);
+      break;
+    case 'p':
+      options.population = std::max(2, std::stoi(optarg));
+      break;
+    case 'n':
+      options.games = std::max(1, std::stoi(optarg));
+      break;
+    case 'm':
+      options.maxPieces = std::stoi(optarg);
+      break;
+    case 't':
+      options.threads = std::max(1, std::stoi(optarg));
+      break;
+    case 'a':
+      options.lookahead = true;
+      break;
+    case 's':
+      options.seed = std::stoull(optarg);
+      break;
+    case 'c':
+      options.checkpoint = optarg;
+      break;
+    default:
+      printHelp();
+    }
+  }
+  return options;
+}
+
+// Seed of the j-th game of a generation. All candidates of a generation
+// play the same games (common random numbers), so differences in fitness
+// come from the weights and not from lucky tetromino sequences.
+uint64_t gameSeed(uint64_t seed, int generation, int game) {
+  uint64_t z = seed + 0x9e3779b97f4a7c15 * (generation * 1000003ull + game + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  return z ^ (z >> 31);
+}
+
+struct GameResult {
+  int lines;
+  int pieces;
+};
+
+// Play one game with the given weights.
+GameResult playGame(const EvaluationWeights &weights, uint64_t seed,
+                    int maxPieces, bool lookahead) {
+  HeadlessGame game(seed);
+  TetrisBot bot(weights);
+
+  while (!game.isGameOver() && game.getPiecesPlaced() < maxPieces) {
+    Placement placement;
+    int next = lookahead ? game.getNextPiece() : -1;
+    if (!bot.choosePlacement(game.getBoard(), game.getCurrentPiece(), next,
+                             &placement)) {
+      break;
+    }
+    game.play(placement);
+  }
+  return GameResult{game.getDestroyedLines(), game.getPiecesPlaced()};
+}
+
+// Scale weights to length 1. Only the direction of the weight vector
+// matters for the bot, this keeps the search space bounded.
+void normalize(EvaluationWeights *weights) {
+  double length = 0;
+  for (double value : weights->values) {
+    length += value * value;
+  }
+  length = std::sqrt(length);
+  if (length == 0) {
+    return;
+  }
+  for (double &value : weights->values) {
+    value /= length;
+  }
+}
+
+// Evaluate all candidates on all cores.
+void evaluatePopulation(std::vector<Candidate> *population,
+                        const TunerOptions &options, int generation,
+                        long long *placedPieces) {
+  int numberOfCandidates = population->size();
+  int jobs = numberOfCandidates * options.games;
+  std::vector<GameResult> results(jobs);
+  std::atomic<int> nextJob{0};
+
+  auto worker = [&]() {
+    while (true) {
+      int job = nextJob.fetch_add(1);
+      if (job >= jobs) {
+        return;
+      }
+      int candidate = job / options.games;
+      int game = job % options.games;
+      results[job] = playGame((*population)[candidate].weights,
+                              gameSeed(options.seed, generation, game),
+                              options.maxPieces, options.lookahead);
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < options.threads; i++) {
+    threads.emplace_back(worker);
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  *placedPieces = 0;
+  for (int i = 0; i < numberOfCandidates; i++) {
+    double sum = 0;
+    for (int j = 0; j < options.games; j++) {
+      sum += results[i * options.games + j].lines;
+      *placedPieces += results[i * options.games + j].pieces;
+    }
+    (*population)[i].fitness = sum / options.games;
+  }
+}
+
+// Create the next generation: keep the best tenth, fill the rest with
+// children of good parents (chosen by tournament).
+std::vector<Candidate> breed(std::vector<Candidate> population,
+                             std::mt19937_64 *generator) {
+  std::sort(population.begin(), population.end(),
+            [](const Candidate &a, const Candidate &b) {
+              return a.fitness > b.fitness;
+            });
+
+  int size = population.size();
+  int elites = std::max(1, size / 10);
+  int tournamentSize = std::max(2, size / 10);
+
+  std::uniform_int_distribution<int> pick(0, size - 1);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+  // Indices are sorted by fitness, so the smallest index wins.
+  auto tournament = [&]() {
+    int best = size;
+    for (int i = 0; i < tournamentSize; i++) {
+      best = std::min(best, pick(*generator));
+    }
+    return best;
+  };
+
+  std::vector<Candidate> next(population.begin(),
+                              population.begin() + elites);
+  while ((int)next.size() < size) {
+    const Candidate &a = population[tournament()];
+    const Candidate &b = population[tournament()];
+
+    // Child is the average of parents, weighted by their fitness.
+    Candidate child;
+    double total = a.fitness + b.fitness;
+    double share = total > 0 ? a.fitness / total : 0.5;
+    for (int i = 0; i < EvaluationWeights::numberOfFeatures; i++) {
+      child.weights.values[i] = share * a.weights.values[i] +
+                                (1 - share) * b.weights.values[i];
+    }
+
+    // Mutation of one weight.
+    if (uniform(*generator) < 0.2) {
+      std::uniform_int_distribution<int> feature(
+          0, EvaluationWeights::numberOfFeatures - 1);
+      child.weights.values[feature(*generator)] +=
+          uniform(*generator) * 0.4 - 0.2;
+    }
+
+    normalize(&child.weights);
+    next.push_back(child);
+  }
+  return next;
+}
+
+// Write checkpoint to a temporary file first and rename it afterwards,
+// so an interruption never leaves a half written checkpoint behind.
+void saveCheckpoint(const TunerOptions &options, int generation,
+                    const std::vector<Candidate> &population) {
+  std::string temporary = options.checkpoint + ".tmp";
+  {
+    std::ofstream file(temporary);
+    file.precision(17);
+    file << "TetrisTune 1\n";
+    file << "generation " << generation << "\n";
+    file << "seed " << options.seed << "\n";
+    file << "population " << population.size() << "\n";
+    for (const Candidate &candidate : population) {
+      file << candidate.fitness;
+      for (double value : candidate.weights.values) {
+        file << " " << value;
+      }
+      file << "\n";
+    }
+  }
+  std::rename(temporary.c_str(), options.checkpoint.c_str());
+
+  const Candidate &best = *std::max_element(
+      population.begin(), population.end(),
+      [](const Candidate &a, const Candidate &b) {
+        return a.fitness < b.fitness;
+      });
+  best.weights.save(options.checkpoint + ".best");
+}
+
+// Returns the last finished generation or -1 if there is no checkpoint.
+int loadCheckpoint(TunerOptions *options, std::vector<Candidate> *population) {
+  std::ifstream file(options->checkpoint);
+  if (!file) {
+    return -1;
+  }
+
+  std::string word;
+  int version, generation, size;
+  file >> word >> version;
+  if (word != "TetrisTune" || version != 1) {
+    return -1;
+  }
+  file >> word >> generation >> word >> options->seed >> word >> size;
+
+  population->clear();
+  for (int i = 0; i < size; i++) {
+    Candidate candidate;
+    file >> candidate.fitness;
+    for (double &value : candidate.weights.values) {
+      file >> value;
+    }
+    population->push_back(candidate);
+  }
+  if (!file) {
+    return -1;
+  }
+  return generation;
+}
+
+int main(int argc, char **argv) {
+  TunerOptions options = parseArguments(argc, argv);
+
+  std::vector<Candidate> population;
+  int generation = loadCheckpoint(&options, &population);
+
+  if (generation == -1) {
+    // First candidate is the default, the rest is random.
+    std::mt19937_64 generator(options.seed);
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    for (int i = 0; i < options.population; i++) {
+      Candidate candidate;
+      candidate.weights = EvaluationWeights::defaults();
+      if (i > 0) {
+        for (double &value : candidate.weights.values) {
+          value = uniform(generator);
+        }
+      }
+      normalize(&candidate.weights);
+      population.push_back(candidate);
+    }
+  } else {
+    std::cout << "Resuming after generation " << generation << " from "
+              << options.checkpoint << std::endl;
+    // Evolution randomness depends only on seed and generation,
+    // so a resumed run continues exactly like an uninterrupted one.
+    std::mt19937_64 generator(options.seed + generation);
+    population = breed(population, &generator);
+  }
+
+  for (generation += 1; generation < options.generations; generation++) {
+    auto start = std::chrono::steady_clock::now();
+    long long placedPieces = 0;
+    evaluatePopulation(&population, options, generation, &placedPieces);
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+
+    saveCheckpoint(options, generation, population);
+
+    double best = 0;
+    double mean = 0;
+    for (const Candidate &candidate : population) {
+      best = std::max(best, candidate.fitness);
+      mean += candidate.fitness / population.size();
+    }
+    std::cout << "generation " << generation << ": best " << best << " mean "
+              << mean << " lines, "
+              << (long long)(population.size() * options.games / seconds)
+              << " games/s, " << (long long)(placedPieces / seconds)
+              << " tetrominos/s" << std::endl;
+
+    std::mt19937_64 generator(options.seed + generation);
+    population = breed(population, &generator);
+  }
+}
@@ -0,0 +1,272 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Versus game of two bots in two processes, connected by a Unix domain
+// socket (see Versus.h). Both sides simulate both players and exchange
+// only their inputs. The remote input is predicted and corrected by
+// rollback, so a slow or late remote side never stops the local one for
+// up to RollbackSession::maxRollbackFrames frames.
+//
+// Usage:
+//
+// ./TetrisVersusMain --listen=<socket> --seed=<n> --frames=<n>
+// ./TetrisVersusMain --connect=<socket> --delay=<frames>
+//
+// Both print the same final hash if they simulated the same game.
+//
+
+#include "./LocalSocket.h"
+#include "./Telemetry.h"
+#include "./TetrisBot.h"
+#include "./Versus.h"
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <getopt.h>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <unistd.h>
+
+namespace {
+
+// Sent by the listening side after the connection is made.
+struct VersusHello {
+  uint64_t seed;
+  int32_t frameMs;
+  int32_t frames;
+};
+
+// Local player: the bot, with a random placement now and then so that
+// the two sides don't play the same game.
+class Player {
+public:
+  Player(uint64_t seed, int noisePercent)
+      : bot_(EvaluationWeights::defaults()), random_(seed | 1),
+        noisePercent_(noisePercent) {}
+
+  VersusInput choose(const HeadlessGame &game) {
+    Placement placements[BitBoard::maxPlacements];
+    int count = game.generatePlacements(placements);
+    if (game.isGameOver() || count == 0) {
+      return VersusInput();
+    }
+    // xorshift64*
+    random_ ^= random_ >> 12;
+    random_ ^= random_ << 25;
+    random_ ^= random_ >> 27;
+    uint64_t r = random_ * 0x2545f4914f6cdd1d;
+    if ((int)((r >> 32) % 100) < noisePercent_) {
+      return VersusInput::fromPlacement(placements[r % count]);
+    }
+    Placement placement = placements[0];
+    bot_.choosePlacement(game.getBoard(), game.getCurrentPiece(),
+                         game.getNextPiece(), &placement);
+    return VersusInput::fromPlacement(placement);
+  }
+
+private:
+  TetrisBot bot_;
+  uint64_t random_;
+  int noisePercent_;
+};
+
+// Wait for `size` bytes on the connection.
+bool receiveExactly(MessageConnection *connection, void *data, size_t size,
+                    int timeoutMs) {
+  auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+  while (!connection->pop(data, size)) {
+    if (!connection->receive() ||
+        std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    pollfd waiting{connection->getFd(), POLLIN, 0};
+    poll(&waiting, 1, 10);
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string listenPath;
+  std::string connectPath;
+  uint64_t seed = 1;
+  int frameMs = 16;
+  int frames = 3000;
+  int delayFrames = 0;
+  int noisePercent = 10;
+
+  const option longOptions[] = {{"listen", required_argument, nullptr, 'l'},
+                                {"connect", required_argument, nullptr, 'c'},
+                                {"seed", required_argument, nullptr, 's'},
+                                {"frameMs", required_argument, nullptr, 'f'},
+                                {"frames", required_argument, nullptr, 'n'},
+                                {"delay", required_argument, nullptr, 'd'},
+                                {"noise", required_argument, nullptr, 'r'},
+                                {nullptr, 0, nullptr, 0}};
+  while (true) {
+    const auto option =
+        getopt_long(argc, argv, "l:c:s:f:n:d:r:", longOptions, nullptr);
+    if (option == -1) {
+      break;
+    }
+    switch (option) {
+    case 'l':
+      listenPath = optarg;
+      break;
+    case 'c':
+      connectPath = optarg;
+      break;
+    case 's':
+      seed = std::stoull(optarg);
+      break;
+    case 'f':
+      frameMs = std::stoi(optarg);
+      break;
+    case 'n':
+      frames = std::stoi(optarg);
+      break;
+    case 'd':
+      delayFrames = std::stoi(optarg);
+      break;
+    case 'r':
+      noisePercent = std::stoi(optarg);
+      break;
+    default:
+      std::cout << "--listen <socket>:  Wait for the other player (player 0).\n"
+                   "--connect <socket>: Join a waiting player (player 1).\n"
+                   "--seed <n>:         Tetrominos and garbage (listener).\n"
+                   "--frameMs <ms>:     Time of one frame (listener).\n"
+                   "--frames <n>:       Stop after n frames (listener).\n"
+                   "--delay <frames>:   Send own inputs this much later.\n"
+                   "--noise <percent>:  Random placements of the bot.\n";
+      return 1;
+    }
+  }
+  if (listenPath.empty() == connectPath.empty()) {
+    std::cerr << "Use either --listen or --connect" << std::endl;
+    return 1;
+  }
+
+  // Connect. The listener decides the settings of the game.
+  int localPlayer = listenPath.empty() ? 1 : 0;
+  int fd = -1;
+  if (localPlayer == 0) {
+    int listenFd = LocalSocket::listen(listenPath);
+    if (listenFd == -1) {
+      std::cerr << "Can't listen on " << listenPath << std::endl;
+      return 1;
+    }
+    pollfd waiting{listenFd, POLLIN, 0};
+    if (poll(&waiting, 1, 30'000) == 1) {
+      fd = LocalSocket::accept(listenFd);
+    }
+    close(listenFd);
+    unlink(listenPath.c_str());
+  } else {
+    fd = LocalSocket::connect(connectPath, 30'000);
+  }
+
+  MessageConnection connection(fd);
+  VersusHello hello{seed, frameMs, frames};
+  bool isConnected =
+      localPlayer == 0
+          ? connection.send(&hello, sizeof(hello))
+          : receiveExactly(&connection, &hello, sizeof(hello), 30'000);
+  if (!isConnected) {
+    std::cerr << "No connection to the other player" << std::endl;
+    return 1;
+  }
+
+  RollbackSession session(VersusGame(hello.seed), localPlayer);
+  Player player(hello.seed ^ (localPlayer + 1) * 0x9e3779b97f4a7c15,
+                noisePercent);
+  // Own inputs wait here for --delay frames (simulated latency).
+  std::deque<VersusMessage> outgoing;
+  // Rollback and simulation per frame, without the bot.
+  FrameTimes simulationTimes;
+  int64_t maxSimulationUs = 0;
+  bool isPeerOpen = true;
+
+  auto nextFrame = std::chrono::steady_clock::now();
+  while (true) {
+    if (isPeerOpen) {
+      isPeerOpen = connection.receive();
+    }
+    VersusMessage message;
+    while (connection.pop(&message, sizeof(message))) {
+      if (!session.addRemoteInput(message.frame, message.input)) {
+        std::cerr << "Unexpected input for frame " << message.frame
+                  << std::endl;
+        return 1;
+      }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    session.synchronize();
+    auto rollbackTime = std::chrono::steady_clock::now() - start;
+    const VersusGame &confirmed = session.getConfirmedGame();
+    if (confirmed.isOver() || confirmed.getFrame() >= hello.frames) {
+      break;
+    }
+
+    bool isFrameDue = std::chrono::steady_clock::now() >= nextFrame;
+    if (isFrameDue && session.canAdvance() &&
+        session.getFrame() < hello.frames) {
+      VersusInput input =
+          player.choose(session.getGame().getPlayer(localPlayer));
+      auto simulationStart = std::chrono::steady_clock::now();
+      session.advance(input);
+      auto simulation =
+          rollbackTime + (std::chrono::steady_clock::now() - simulationStart);
+      simulationTimes.add(simulation);
+      maxSimulationUs = std::max<int64_t>(
+          maxSimulationUs,
+          std::chrono::duration_cast<std::chrono::microseconds>(simulation)
+              .count());
+      outgoing.push_back(
+          VersusMessage{session.getFrame() - 1, input, {0, 0}});
+      nextFrame += std::chrono::milliseconds(hello.frameMs);
+    } else if (!isPeerOpen && !session.canAdvance()) {
+      std::cerr << "The other player left" << std::endl;
+      return 1;
+    }
+
+    while (!outgoing.empty() &&
+           outgoing.front().frame + delayFrames < session.getFrame()) {
+      connection.send(&outgoing.front(), sizeof(VersusMessage));
+      outgoing.pop_front();
+    }
+
+    // Sleep until the next frame or a remote input.
+    int waitMs = std::max<int>(
+        0, std::chrono::duration_cast<std::chrono::milliseconds>(
+               nextFrame - std::chrono::steady_clock::now())
+               .count());
+    pollfd waiting{connection.getFd(), POLLIN, 0};
+    poll(&waiting, isPeerOpen ? 1 : 0, std::min(waitMs, hello.frameMs));
+  }
+
+  // The other side may still need the last inputs.
+  for (const VersusMessage &message : outgoing) {
+    connection.send(&message, sizeof(VersusMessage));
+  }
+
+  const VersusGame &game = session.getConfirmedGame();
+  const HeadlessGame &self = game.getPlayer(localPlayer);
+  std::cout << "player=" << localPlayer << " frames=" << game.getFrame()
+            << " winner=" << game.getWinner() << " lines="
+            << self.getDestroyedLines()
+            << " garbage_sent=" << game.getGarbageSent(localPlayer)
+            << " rollbacks=" << session.getRollbacks()
+            << " resimulated_frames=" << session.getResimulatedFrames()
+            << " longest_rollback=" << session.getLongestRollback()
+            << " simulation_us_p50=" << simulationTimes.percentileUs(50)
+            << " simulation_us_p99=" << simulationTimes.percentileUs(99)
+            << " simulation_us_max=" << maxSimulationUs
+            << " frame_budget_us=" << hello.frameMs * 1000
+            << " hash=" << std::hex << game.getHash() << std::dec
+            << std::endl;
+}
@@ -203,4 +203,26 @@ void TetrominoS::rotate([[maybe_unused]] bool left) {
 
     currentAngle_ = 0;
   }
-}
\ No newline at end of file
+}
+// ------------------------------------------------------------------------
+
+NewAbstractTetromino *TetrominoFactory::create(int tetrominoIndex) {
+  if (tetrominoIndex == 0) {
+    return new TetrominoI();
+  } else if (tetrominoIndex == 1) {
+    return new TetrominoJ();
+  } else if (tetrominoIndex == 2) {
+    return new TetrominoL();
+  } else if (tetrominoIndex == 3) {
+    return new TetrominoO();
+  } else if (tetrominoIndex == 4) {
+    return new TetrominoS();
+  } else if (tetrominoIndex == 5) {
+    return new TetrominoZ();
+  } else if (tetrominoIndex == 6) {
+    return new TetrominoT();
+  }
+
+  // Just to supress warning
+  return new TetrominoO();
+}
@@ -74,6 +74,12 @@ struct TetrominoShape {
   }
 };
 
+// Structure to create tetrominos by their index. Order is the same as in
+// statistics: I, J, L, O, S, Z, T.
+struct TetrominoFactory {
+  static NewAbstractTetromino *create(int tetrominoIndex);
+};
+
 // Tetromino classes. I've decided to use inheritence here
 // to avoid code duplication, because for the most part it's the same stuff.
 class TetrominoT : public NewAbstractTetromino {
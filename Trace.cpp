@@ -0,0 +1,95 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+
+std::atomic<bool> Trace::isEnabled_{false};
+std::chrono::steady_clock::time_point Trace::start_;
+std::string Trace::path_;
+std::mutex Trace::buffersMutex_;
+std::vector<std::unique_ptr<Trace::ThreadBuffer>> Trace::buffers_;
+
+void Trace::enable(const std::string &path) {
+  path_ = path;
+  start_ = std::chrono::steady_clock::now();
+  isEnabled_ = true;
+}
+
+int64_t Trace::now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+Trace::ThreadBuffer *Trace::threadBuffer() {
+  thread_local ThreadBuffer *buffer = nullptr;
+  if (buffer == nullptr) {
+    auto owned = std::make_unique<ThreadBuffer>();
+    owned->events.resize(eventsPerThread);
+    buffer = owned.get();
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    buffer->id = buffers_.size() + 1;
+    buffers_.push_back(std::move(owned));
+  }
+  return buffer;
+}
+
+void Trace::setThreadName(const char *name) {
+  if (isEnabled()) {
+    threadBuffer()->name = name;
+  }
+}
+
+void Trace::record(const char *name, int64_t start, int64_t duration) {
+  ThreadBuffer *buffer = threadBuffer();
+  int64_t count = buffer->count.load(std::memory_order_relaxed);
+  buffer->events[count % eventsPerThread] = Event{name, start, duration};
+  // The event is complete before finish() can see it.
+  buffer->count.store(count + 1, std::memory_order_release);
+}
+
+bool Trace::finish() {
+  if (!isEnabled_) {
+    return true;
+  }
+  isEnabled_ = false;
+
+  std::ofstream file(path_);
+  if (!file) {
+    return false;
+  }
+  // Microseconds with nanosecond digits.
+  file << std::fixed << std::setprecision(3);
+  file << "{\"traceEvents\":[";
+  bool isFirst = true;
+  auto separator = [&]() {
+    file << (isFirst ? "\n" : ",\n");
+    isFirst = false;
+  };
+
+  std::lock_guard<std::mutex> lock(buffersMutex_);
+  for (const auto &buffer : buffers_) {
+    if (buffer->name != nullptr) {
+      separator();
+      file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+           << buffer->id << ",\"args\":{\"name\":\"" << buffer->name
+           << "\"}}";
+    }
+    int64_t count = buffer->count.load(std::memory_order_acquire);
+    for (int64_t i = std::max<int64_t>(0, count - eventsPerThread); i < count;
+         i++) {
+      const Event &event = buffer->events[i % eventsPerThread];
+      separator();
+      file << "{\"name\":\"" << event.name
+           << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->id
+           << ",\"ts\":" << event.start / 1000.0
+           << ",\"dur\":" << event.duration / 1000.0 << "}";
+    }
+    buffer->count.store(0, std::memory_order_relaxed);
+  }
+  file << "\n]}\n";
+  return (bool)file;
+}
@@ -0,0 +1,88 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Trace event format (also opened by https://ui.perfetto.dev):
+// https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+//
+
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Timeline of the hot paths of the game, written as Chrome trace JSON when
+// the game ends (chrome://tracing or Perfetto). A TRACE_SCOPE records the
+// time from its start to the end of the enclosing block.
+//
+// Every thread writes into its own buffer, so recording takes no lock. A
+// buffer keeps the last `eventsPerThread` events, older ones are
+// overwritten. While tracing is off a scope only reads one flag.
+class Trace {
+public:
+  static constexpr int eventsPerThread = 1 << 16;
+
+  // Start recording, finish() writes the events to `path`.
+  static void enable(const std::string &path);
+  static bool isEnabled() {
+    return isEnabled_.load(std::memory_order_relaxed);
+  }
+  // Stop recording and write the file. Returns false if it can't be
+  // written. The other threads should not record anymore.
+  static bool finish();
+
+  // Name of the calling thread in the timeline (only while enabled).
+  static void setThreadName(const char *name);
+
+  // `name` must be a string literal without quotes or backslashes.
+  class Scope {
+  public:
+    explicit Scope(const char *name)
+        : name_(isEnabled() ? name : nullptr),
+          start_(name_ != nullptr ? now() : 0) {}
+    ~Scope() {
+      if (name_ != nullptr) {
+        record(name_, start_, now() - start_);
+      }
+    }
+
+  private:
+    const char *name_;
+    int64_t start_;
+  };
+
+  // Nanoseconds since enable().
+  static int64_t now();
+  static void record(const char *name, int64_t start, int64_t duration);
+
+private:
+  struct Event {
+    const char *name;
+    int64_t start;
+    int64_t duration;
+  };
+  struct ThreadBuffer {
+    int id;
+    const char *name = nullptr;
+    std::vector<Event> events;
+    // Number of recorded events, only written by the owning thread.
+    std::atomic<int64_t> count{0};
+  };
+  static ThreadBuffer *threadBuffer();
+
+  static std::atomic<bool> isEnabled_;
+  static std::chrono::steady_clock::time_point start_;
+  static std::string path_;
+  // All buffers, they live until the program ends (a thread may end
+  // before the file is written). The threads only keep a pointer.
+  static std::mutex buffersMutex_;
+  static std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+};
+
+// One variable per line, so scopes can be nested in one block.
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(name) Trace::Scope TRACE_CONCAT(traceScope, __LINE__)(name)
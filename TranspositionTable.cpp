@@ -0,0 +1,89 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./TranspositionTable.h"
+#include <cstring>
+
+TranspositionTable::TranspositionTable(size_t numberOfSlots) {
+  // Round down to a power of two (at least one slot).
+  numberOfSlots_ = 1;
+  while (numberOfSlots_ * 2 <= numberOfSlots) {
+    numberOfSlots_ *= 2;
+  }
+  mask_ = numberOfSlots_ - 1;
+  slots_ = std::make_unique<Slot[]>(numberOfSlots_);
+}
+
+uint64_t TranspositionTable::pack(float score, int depth, int bestMove,
+                                  int generation) {
+  uint32_t scoreBits;
+  std::memcpy(&scoreBits, &score, sizeof(scoreBits));
+
+  uint64_t data = scoreBits;
+  data |= static_cast<uint64_t>(depth & 0xff) << 32;
+  data |= static_cast<uint64_t>((bestMove + 1) & 0xff) << 40;
+  data |= static_cast<uint64_t>(generation & 0xff) << 48;
+  // "Used" flag, so that an empty slot (data == 0) is never a hit.
+  data |= static_cast<uint64_t>(1) << 56;
+  return data;
+}
+
+TranspositionEntry TranspositionTable::unpack(uint64_t data) {
+  uint32_t scoreBits = data & 0xffffffff;
+  TranspositionEntry entry;
+  std::memcpy(&entry.score, &scoreBits, sizeof(scoreBits));
+  entry.depth = depthOf(data);
+  entry.bestMove = static_cast<int>((data >> 40) & 0xff) - 1;
+  return entry;
+}
+
+bool TranspositionTable::probe(uint64_t hash, TranspositionEntry *entry) const {
+  const Slot &slot = slots_[hash & mask_];
+  uint64_t data = slot.data.load(std::memory_order_relaxed);
+  uint64_t check = slot.check.load(std::memory_order_relaxed);
+
+  // If another thread was writing this slot at the same time,
+  // check and data don't belong together and this is a miss.
+  if (data == 0 || (check ^ data) != hash) {
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  hits_.fetch_add(1, std::memory_order_relaxed);
+  *entry = unpack(data);
+  return true;
+}
+
+void TranspositionTable::store(uint64_t hash, float score, int depth,
+                               int bestMove) {
+  Slot &slot = slots_[hash & mask_];
+  int generation = generation_.load(std::memory_order_relaxed);
+
+  uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+  uint64_t oldCheck = slot.check.load(std::memory_order_relaxed);
+  bool samePosition = (oldCheck ^ oldData) == hash;
+
+  // Keep deeper results from the current generation, unless we are
+  // updating the very same position.
+  if (oldData != 0 && !samePosition && generationOf(oldData) == generation &&
+      depthOf(oldData) > depth) {
+    return;
+  }
+
+  uint64_t data = pack(score, depth, bestMove, generation);
+  slot.data.store(data, std::memory_order_relaxed);
+  slot.check.store(hash ^ data, std::memory_order_relaxed);
+}
+
+void TranspositionTable::newGeneration() {
+  generation_.store((generation_.load() + 1) & 0xff);
+}
+
+void TranspositionTable::clear() {
+  for (size_t i = 0; i < numberOfSlots_; i++) {
+    slots_[i].data.store(0, std::memory_order_relaxed);
+    slots_[i].check.store(0, std::memory_order_relaxed);
+  }
+  hits_.store(0);
+  misses_.store(0);
+}
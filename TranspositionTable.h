@@ -0,0 +1,74 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// The "lockless" trick (storing key XOR data) is described here:
+// https://www.chessprogramming.org/Shared_Hash_Table#Lock-less
+//
+
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Result of a successful lookup in the transposition table.
+struct TranspositionEntry {
+  // Evaluation of the position.
+  float score;
+  // How many tetrominos deep the position was searched.
+  int depth;
+  // Index of the best placement found for this position (or -1).
+  int bestMove;
+};
+
+// Fixed-size hash table that maps position hashes (see Zobrist.h) to search
+// results. It is shared by all search threads without any locks: every slot
+// stores the data and (hash XOR data). A reader that sees a slot half-written
+// by another thread gets a mismatching hash and treats it as a miss, so a
+// torn entry can never be returned.
+class TranspositionTable {
+public:
+  // Number of slots is rounded down to a power of two so that
+  // the index can be computed with a mask.
+  explicit TranspositionTable(size_t numberOfSlots = 1 << 20);
+
+  // Look up a position. Returns false if the position is not stored.
+  bool probe(uint64_t hash, TranspositionEntry *entry) const;
+
+  // Store a position. Entries from the current generation are only
+  // replaced by results of at least the same depth.
+  void store(uint64_t hash, float score, int depth, int bestMove);
+
+  // Start a new generation (usually once per placed tetromino).
+  // Entries from older generations are replaced first.
+  void newGeneration();
+
+  // Remove everything.
+  void clear();
+
+  size_t size() const { return numberOfSlots_; }
+
+  // Statistics (relaxed, only meant for debugging / counters).
+  uint64_t hits() const { return hits_.load(std::memory_order_relaxed); }
+  uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+  struct Slot {
+    std::atomic<uint64_t> check{0};
+    std::atomic<uint64_t> data{0};
+  };
+
+  // Data layout: 32 bits score (float bits), 8 bits depth,
+  // 8 bits best move + 1, 8 bits generation, 8 bits "used" flag.
+  static uint64_t pack(float score, int depth, int bestMove, int generation);
+  static TranspositionEntry unpack(uint64_t data);
+  static int generationOf(uint64_t data) { return (data >> 48) & 0xff; }
+  static int depthOf(uint64_t data) { return (data >> 32) & 0xff; }
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t numberOfSlots_;
+  size_t mask_;
+  std::atomic<int> generation_{0};
+
+  mutable std::atomic<uint64_t> hits_{0};
+  mutable std::atomic<uint64_t> misses_{0};
+};
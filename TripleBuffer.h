@@ -0,0 +1,59 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Triple buffering without locks, the idea is from here:
+// https://remis-thoughts.blogspot.com/2012/01/triple-buffering-as-concurrency_30.html
+//
+
+#pragma once
+#include <atomic>
+
+// Hands values (for example whole frames) from one writer thread to one
+// reader thread without locks and without ever blocking either of them.
+// The writer fills back() and publishes it, the reader takes the newest
+// published value as front(). Three slots are enough: one for the writer,
+// one for the reader and one in the middle with the newest value. If the
+// writer publishes twice before the reader looks, the older value is
+// dropped.
+template <typename T> class TripleBuffer {
+public:
+  // All three slots start as copies of `value` (so big values, like
+  // frames, are allocated once here and never again).
+  explicit TripleBuffer(const T &value = T())
+      : slots_{value, value, value} {}
+
+  // Writer: the slot for the next value.
+  T &back() { return slots_[back_]; }
+
+  // Writer: make back() the newest value, back() is another slot then.
+  // Returns false if the previous value was never read (it was dropped).
+  bool publish() {
+    int old = middle_.exchange(back_ | freshBit, std::memory_order_acq_rel);
+    back_ = old & indexMask;
+    return (old & freshBit) == 0;
+  }
+
+  // Reader: switch front() to the newest value. Returns false if nothing
+  // was published since the last call.
+  bool update() {
+    if ((middle_.load(std::memory_order_relaxed) & freshBit) == 0) {
+      return false;
+    }
+    int old = middle_.exchange(front_, std::memory_order_acq_rel);
+    front_ = old & indexMask;
+    return true;
+  }
+
+  // Reader: the newest value it has taken.
+  const T &front() const { return slots_[front_]; }
+
+private:
+  static constexpr int indexMask = 3;
+  // Set in middle_ while its value wasn't read yet.
+  static constexpr int freshBit = 4;
+
+  T slots_[3];
+  int back_ = 0;
+  std::atomic<int> middle_{1};
+  int front_ = 2;
+};
@@ -0,0 +1,176 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./VecEnv.h"
+#include <algorithm>
+
+VecEnv::VecEnv(int numberOfEnvs, int numberOfThreads)
+    : numberOfEnvs_(std::max(1, numberOfEnvs)) {
+  if (numberOfThreads <= 0) {
+    numberOfThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  numberOfThreads_ = std::min(numberOfThreads, numberOfEnvs_);
+  envs_ = std::make_unique<Env[]>(numberOfEnvs_);
+
+  // Part 0 belongs to the calling thread.
+  for (int part = 1; part < numberOfThreads_; part++) {
+    threads_.emplace_back(&VecEnv::worker, this, part);
+  }
+}
+
+VecEnv::~VecEnv() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = Job::Quit;
+    jobNumber_ += 1;
+  }
+  jobReady_.notify_all();
+  for (auto &thread : threads_) {
+    thread.join();
+  }
+}
+
+void VecEnv::reset(const uint64_t *seeds, float *observations,
+                   uint8_t *actionMasks) {
+  seeds_ = seeds;
+  observations_ = observations;
+  actionMasks_ = actionMasks;
+  rewards_ = nullptr;
+  dones_ = nullptr;
+  runJob(Job::Reset);
+}
+
+void VecEnv::step(const int *actions, float *observations, float *rewards,
+                  uint8_t *dones, uint8_t *actionMasks) {
+  actions_ = actions;
+  observations_ = observations;
+  rewards_ = rewards;
+  dones_ = dones;
+  actionMasks_ = actionMasks;
+  runJob(Job::Step);
+  steps_ += numberOfEnvs_;
+}
+
+void VecEnv::runJob(Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    job_ = job;
+    jobNumber_ += 1;
+    runningWorkers_ = numberOfThreads_ - 1;
+  }
+  jobReady_.notify_all();
+
+  runPart(0, numberOfEnvs_ / numberOfThreads_);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  jobDone_.wait(lock, [this]() { return runningWorkers_ == 0; });
+}
+
+void VecEnv::worker(int part) {
+  long long lastJob = 0;
+  int first = (long long)numberOfEnvs_ * part / numberOfThreads_;
+  int last = (long long)numberOfEnvs_ * (part + 1) / numberOfThreads_;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      jobReady_.wait(lock, [&]() { return jobNumber_ != lastJob; });
+      lastJob = jobNumber_;
+      if (job_ == Job::Quit) {
+        return;
+      }
+    }
+
+    runPart(first, last);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      runningWorkers_ -= 1;
+    }
+    jobDone_.notify_one();
+  }
+}
+
+void VecEnv::runPart(int first, int last) {
+  for (int env = first; env < last; env++) {
+    if (job_ == Job::Reset) {
+      resetEnv(env, seeds_[env]);
+    } else {
+      stepEnv(env);
+    }
+    writeOutput(env);
+  }
+}
+
+void VecEnv::resetEnv(int env, uint64_t seed) {
+  envs_[env].seed = seed;
+  envs_[env].game.reset(seed);
+  updateActions(env);
+}
+
+void VecEnv::stepEnv(int env) {
+  Env &e = envs_[env];
+
+  int action = actions_[env];
+  int index = 0;
+  if (action >= 0 && action < numberOfActions &&
+      e.placementOfAction[action] != -1) {
+    index = e.placementOfAction[action];
+  }
+
+  int score = e.game.getScore();
+  bool isDone = e.numberOfPlacements == 0 ||
+                e.game.play(e.placements[index]) == -1;
+  rewards_[env] = e.game.getScore() - score;
+  dones_[env] = isDone;
+
+  if (isDone) {
+    // Next seed of this game slot (64 bit LCG step), so runs are
+    // reproducible from the seeds given to reset().
+    resetEnv(env, e.seed * 6364136223846793005ull + 1442695040888963407ull);
+  } else {
+    updateActions(env);
+  }
+}
+
+void VecEnv::updateActions(int env) {
+  Env &e = envs_[env];
+  std::fill(e.placementOfAction, e.placementOfAction + numberOfActions, -1);
+
+  e.numberOfPlacements = e.game.isGameOver()
+                             ? 0
+                             : e.game.generatePlacements(e.placements);
+  for (int i = 0; i < e.numberOfPlacements; i++) {
+    const Placement &placement = e.placements[i];
+    const Orientation &orientation =
+        BitBoard::getOrientation(placement.piece, placement.orientation);
+    int column = orientation.minCol + placement.shift;
+    e.placementOfAction[placement.orientation * BitBoard::cols + column] = i;
+  }
+}
+
+void VecEnv::writeOutput(int env) {
+  const Env &e = envs_[env];
+  const BitBoard &board = e.game.getBoard();
+
+  float *observation = observations_ + (size_t)env * observationSize;
+  for (int row = 0; row < BitBoard::rows; row++) {
+    uint16_t bits = board.getRow(row);
+    for (int col = 0; col < BitBoard::cols; col++) {
+      *observation++ = (bits >> col) & 1;
+    }
+  }
+  for (int piece = 0; piece < 7; piece++) {
+    *observation++ = piece == e.game.getCurrentPiece();
+  }
+  for (int piece = 0; piece < 7; piece++) {
+    *observation++ = piece == e.game.getNextPiece();
+  }
+
+  if (actionMasks_ != nullptr) {
+    uint8_t *mask = actionMasks_ + (size_t)env * numberOfActions;
+    for (int action = 0; action < numberOfActions; action++) {
+      mask[action] = e.placementOfAction[action] != -1;
+    }
+  }
+}
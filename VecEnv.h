@@ -0,0 +1,109 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Interface is modelled after the vectorized environments of
+// Gymnasium / Stable Baselines:
+// https://gymnasium.farama.org/api/vector/
+//
+
+#pragma once
+#include "./HeadlessGame.h"
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// K independent headless games that are stepped together, for training
+// agents with reinforcement learning.
+//
+// Action a means: turn the tetromino into orientation a / cols and drop it
+// with its leftmost cell in column a % cols. The action mask tells which
+// actions are possible; an impossible action plays the first possible one.
+//
+// Observation of one game: rows * cols cells (0 or 1, row by row),
+// then the current and the next tetromino one-hot encoded (7 + 7 values).
+// Reward is the number of points the placement earned. A finished game is
+// reset right away with a new seed, so the observation after "done" is
+// already the first one of the next game.
+//
+// All results are written to buffers of the caller, laid out game after
+// game. Stepping doesn't allocate memory. The games are split into equal
+// parts, one per thread; the calling thread works on the first part.
+class VecEnv {
+public:
+  static constexpr int numberOfActions = 4 * BitBoard::cols;
+  static constexpr int observationSize = BitBoard::rows * BitBoard::cols + 14;
+
+  // numberOfThreads = 0 means one thread per core.
+  explicit VecEnv(int numberOfEnvs, int numberOfThreads = 0);
+  ~VecEnv();
+
+  VecEnv(const VecEnv &) = delete;
+  VecEnv &operator=(const VecEnv &) = delete;
+
+  // Start new games. Buffers:
+  //   seeds         size()
+  //   observations  size() * observationSize
+  //   actionMasks   size() * numberOfActions (can be nullptr)
+  void reset(const uint64_t *seeds, float *observations, uint8_t *actionMasks);
+
+  // Play one action in every game. Buffers:
+  //   actions       size()
+  //   rewards, dones size()
+  //   the others like in reset()
+  void step(const int *actions, float *observations, float *rewards,
+            uint8_t *dones, uint8_t *actionMasks);
+
+  int size() const { return numberOfEnvs_; }
+  int getNumberOfThreads() const { return numberOfThreads_; }
+  const HeadlessGame &getGame(int env) const { return envs_[env].game; }
+  // Steps of all games together since construction.
+  long long getSteps() const { return steps_; }
+
+private:
+  struct Env {
+    HeadlessGame game;
+    uint64_t seed = 0;
+    int numberOfPlacements = 0;
+    Placement placements[BitBoard::maxPlacements];
+    // Index into placements for each action, -1 if impossible.
+    int placementOfAction[numberOfActions];
+  };
+
+  enum class Job { Reset, Step, Quit };
+
+  // Reset or step games [first, last).
+  void runPart(int first, int last);
+  void resetEnv(int env, uint64_t seed);
+  void stepEnv(int env);
+  void updateActions(int env);
+  void writeOutput(int env);
+
+  // Hand the current job to the workers and work on part 0.
+  void runJob(Job job);
+  void worker(int part);
+
+  int numberOfEnvs_;
+  int numberOfThreads_;
+  std::unique_ptr<Env[]> envs_;
+  long long steps_ = 0;
+
+  // Arguments of the current job.
+  Job job_ = Job::Reset;
+  const uint64_t *seeds_ = nullptr;
+  const int *actions_ = nullptr;
+  float *observations_ = nullptr;
+  float *rewards_ = nullptr;
+  uint8_t *dones_ = nullptr;
+  uint8_t *actionMasks_ = nullptr;
+
+  std::mutex mutex_;
+  std::condition_variable jobReady_;
+  std::condition_variable jobDone_;
+  // Incremented for every job, workers wait for a change.
+  long long jobNumber_ = 0;
+  int runningWorkers_ = 0;
+  std::vector<std::thread> threads_;
+};
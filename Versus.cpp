@@ -0,0 +1,169 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Versus.h"
+#include <algorithm>
+
+VersusGame::VersusGame(uint64_t seed) : seed_(seed), frame_(0) {
+  for (int player = 0; player < 2; player++) {
+    players_[player].reset(seed);
+    garbageSent_[player] = 0;
+  }
+}
+
+void VersusGame::step(const VersusInput inputs[2]) {
+  int garbage[2] = {0, 0};
+  for (int player = 0; player < 2; player++) {
+    HeadlessGame &game = players_[player];
+    Placement placement;
+    if (game.isGameOver() ||
+        !findPlacement(game, inputs[player], &placement)) {
+      continue;
+    }
+    int removedRows = game.play(placement);
+    if (removedRows > 0) {
+      garbage[1 - player] += garbageForRemovedRows(removedRows);
+    }
+  }
+
+  // Both players have placed, so the order doesn't matter.
+  for (int player = 0; player < 2; player++) {
+    if (garbage[player] > 0) {
+      players_[player].addGarbage(garbage[player], holeColumn(player));
+      garbageSent_[1 - player] += garbage[player];
+    }
+  }
+  frame_ += 1;
+}
+
+bool VersusGame::isOver() const {
+  return players_[0].isGameOver() || players_[1].isGameOver();
+}
+
+int VersusGame::getWinner() const {
+  if (players_[0].isGameOver() == players_[1].isGameOver()) {
+    return -1;
+  }
+  return players_[0].isGameOver() ? 1 : 0;
+}
+
+uint64_t VersusGame::getHash() const {
+  uint64_t hash = players_[0].getPositionHash() * 31 +
+                  players_[1].getPositionHash();
+  hash = hash * 31 + frame_;
+  hash = hash * 31 + garbageSent_[0];
+  return hash * 31 + garbageSent_[1];
+}
+
+int VersusGame::garbageForRemovedRows(int removedRows) {
+  static const int garbage[5] = {0, 0, 1, 2, 4};
+  if (removedRows < 0 || removedRows > 4) {
+    return 0;
+  }
+  return garbage[removedRows];
+}
+
+bool VersusGame::findPlacement(const HeadlessGame &game, VersusInput input,
+                               Placement *placement) {
+  Placement placements[BitBoard::maxPlacements];
+  int count = game.generatePlacements(placements);
+  if (count == 0) {
+    return false;
+  }
+  *placement = placements[0];
+  for (int i = 0; i < count; i++) {
+    if (VersusInput::fromPlacement(placements[i]) == input) {
+      *placement = placements[i];
+      break;
+    }
+  }
+  return true;
+}
+
+int VersusGame::holeColumn(int player) const {
+  // SplitMix64 finalizer of seed, frame and player.
+  uint64_t z =
+      seed_ + 0x9e3779b97f4a7c15 * (2 * (uint64_t)frame_ + player + 1);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+  z = z ^ (z >> 31);
+  return static_cast<int>((z >> 32) % BitBoard::cols);
+}
+
+// ____________________________________________________________________________
+RollbackSession::RollbackSession(const VersusGame &start, int localPlayer)
+    : game_(start), localPlayer_(localPlayer) {}
+
+bool RollbackSession::canAdvance() const {
+  return game_.getFrame() - remoteFrames_ < maxRollbackFrames;
+}
+
+void RollbackSession::advance(VersusInput localInput) {
+  synchronize();
+  int frame = game_.getFrame();
+  states_[frame % historySize] = game_;
+  localInputs_[frame % historySize] = localInput;
+  // Inputs that arrived early are real, the others are predicted.
+  if (frame >= remoteFrames_) {
+    remoteInputs_[frame % historySize] = lastRemoteInput_;
+  }
+  simulate(frame);
+}
+
+bool RollbackSession::addRemoteInput(int frame, VersusInput input) {
+  if (frame != remoteFrames_ ||
+      frame >= game_.getFrame() + maxRollbackFrames) {
+    return false;
+  }
+  VersusInput &stored = remoteInputs_[frame % historySize];
+  if (frame < game_.getFrame() && stored != input &&
+      firstWrongFrame_ == -1) {
+    firstWrongFrame_ = frame;
+  }
+  stored = input;
+  lastRemoteInput_ = input;
+  remoteFrames_ += 1;
+  return true;
+}
+
+int RollbackSession::synchronize() {
+  if (firstWrongFrame_ == -1) {
+    return 0;
+  }
+  int end = game_.getFrame();
+  game_ = states_[firstWrongFrame_ % historySize];
+  for (int frame = firstWrongFrame_; frame < end; frame++) {
+    states_[frame % historySize] = game_;
+    // Predict again with the newest remote input.
+    if (frame >= remoteFrames_) {
+      remoteInputs_[frame % historySize] = lastRemoteInput_;
+    }
+    simulate(frame);
+  }
+
+  int frames = end - firstWrongFrame_;
+  firstWrongFrame_ = -1;
+  rollbacks_ += 1;
+  resimulatedFrames_ += frames;
+  longestRollback_ = std::max(longestRollback_, frames);
+  return frames;
+}
+
+int RollbackSession::getConfirmedFrame() const {
+  return std::min(remoteFrames_, game_.getFrame());
+}
+
+const VersusGame &RollbackSession::getConfirmedGame() const {
+  int frame = getConfirmedFrame();
+  if (frame == game_.getFrame()) {
+    return game_;
+  }
+  return states_[frame % historySize];
+}
+
+void RollbackSession::simulate(int frame) {
+  VersusInput inputs[2];
+  inputs[localPlayer_] = localInputs_[frame % historySize];
+  inputs[1 - localPlayer_] = remoteInputs_[frame % historySize];
+  game_.step(inputs);
+}
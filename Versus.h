@@ -0,0 +1,134 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// Rollback netcode as in GGPO:
+// https://www.ggpo.net/
+//
+
+#pragma once
+#include "./HeadlessGame.h"
+#include <cstdint>
+
+// Input of one player for one frame of a versus game: where the current
+// tetromino goes. Piece and drop distance follow from the game, so the
+// receiving side finds the placement again and two bytes are enough.
+struct VersusInput {
+  int8_t orientation = 0;
+  int8_t shift = 0;
+
+  static VersusInput fromPlacement(const Placement &placement) {
+    return VersusInput{static_cast<int8_t>(placement.orientation),
+                       static_cast<int8_t>(placement.shift)};
+  }
+  bool operator==(const VersusInput &other) const {
+    return orientation == other.orientation && shift == other.shift;
+  }
+  bool operator!=(const VersusInput &other) const { return !(*this == other); }
+};
+
+// Message of a versus game on the socket, one per frame and player.
+struct VersusMessage {
+  int32_t frame;
+  VersusInput input;
+  uint8_t reserved[2];
+};
+
+// Two headless games with the same tetrominos that send each other
+// garbage rows. One frame is one placement of each player, afterwards
+// the removed rows of one player arrive as garbage at the other one.
+//
+// The state has a fixed size and no pointers, so it is copied for
+// rollback.
+class VersusGame {
+public:
+  explicit VersusGame(uint64_t seed = 0);
+
+  // Play one frame. Inputs that don't match a placement are replaced by
+  // the first placement, so both sides always simulate the same.
+  void step(const VersusInput inputs[2]);
+
+  const HeadlessGame &getPlayer(int player) const { return players_[player]; }
+  int getFrame() const { return frame_; }
+  int getGarbageSent(int player) const { return garbageSent_[player]; }
+  // One of the players lost.
+  bool isOver() const;
+  // Player that didn't lose, -1 while the game runs or if both lost in
+  // the same frame.
+  int getWinner() const;
+  // Both positions, the frame and the garbage (to compare two sides).
+  uint64_t getHash() const;
+
+  // Garbage rows for removing 1, 2, 3 or 4 rows at once.
+  static int garbageForRemovedRows(int removedRows);
+  // Placement of `input` for the current tetromino of `game`.
+  static bool findPlacement(const HeadlessGame &game, VersusInput input,
+                            Placement *placement);
+
+private:
+  // Same on both sides, derived from the seed and the frame.
+  int holeColumn(int player) const;
+
+  HeadlessGame players_[2];
+  uint64_t seed_;
+  int frame_;
+  int garbageSent_[2];
+};
+
+// One side of a versus game with rollback. The local input of a frame is
+// known at once, the remote input is predicted (the last remote input is
+// repeated). When the real remote input differs, the game goes back to the
+// state before that frame and simulates all frames since then again.
+class RollbackSession {
+public:
+  // Frames that can be simulated with predicted remote inputs before the
+  // session waits for the remote side.
+  static constexpr int maxRollbackFrames = 8;
+
+  RollbackSession(const VersusGame &start, int localPlayer);
+
+  // Frame the next advance() simulates.
+  int getFrame() const { return game_.getFrame(); }
+  // False while too many frames would be predicted.
+  bool canAdvance() const;
+  // Simulate the next frame with the local and the predicted input.
+  void advance(VersusInput localInput);
+  // Remote input of `frame`. They have to arrive in order, returns false
+  // for any other frame.
+  bool addRemoteInput(int frame, VersusInput input);
+  // Roll back and simulate again after wrong predictions. Returns the
+  // number of simulated frames. advance() calls it as well.
+  int synchronize();
+
+  // State after all frames so far, partly predicted.
+  const VersusGame &getGame() const { return game_; }
+  // Frames before this one have the real inputs of both sides.
+  int getConfirmedFrame() const;
+  // State after the confirmed frames, the same on both sides (call
+  // synchronize() before).
+  const VersusGame &getConfirmedGame() const;
+
+  // Statistics.
+  long long getRollbacks() const { return rollbacks_; }
+  long long getResimulatedFrames() const { return resimulatedFrames_; }
+  int getLongestRollback() const { return longestRollback_; }
+
+private:
+  static constexpr int historySize = maxRollbackFrames + 1;
+  void simulate(int frame);
+
+  VersusGame game_;
+  int localPlayer_;
+  // State before frame f and inputs of frame f at f % historySize.
+  VersusGame states_[historySize];
+  VersusInput localInputs_[historySize];
+  // Real inputs before remoteFrames_, predicted ones after it.
+  VersusInput remoteInputs_[historySize];
+  int remoteFrames_ = 0;
+  VersusInput lastRemoteInput_;
+  // First frame that was simulated with a wrong prediction (-1: none).
+  int firstWrongFrame_ = -1;
+
+  long long rollbacks_ = 0;
+  long long resimulatedFrames_ = 0;
+  int longestRollback_ = 0;
+};
@@ -0,0 +1,49 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+
+#include "./Zobrist.h"
+#include <random>
+
+Zobrist::Keys::Keys() {
+  // Fixed seed: the keys have to be the same in every run, otherwise
+  // stored hashes (or hashes from another process) would be useless.
+  std::mt19937_64 generator(0x7e7a15);
+
+  for (int i = 0; i < rows; i++) {
+    for (int j = 0; j < cols; j++) {
+      cells[i][j] = generator();
+    }
+  }
+
+  for (int i = 0; i < numberOfTetrominos; i++) {
+    pieces[i] = generator();
+    previews[i] = generator();
+  }
+}
+
+const Zobrist::Keys &Zobrist::keys() {
+  // Initialized on first use, thread safe since C++11.
+  static const Keys table;
+  return table;
+}
+
+uint64_t Zobrist::cellKey(int row, int col) {
+  if (row < 0 || row >= rows || col < 0 || col >= cols) {
+    return 0;
+  }
+  return keys().cells[row][col];
+}
+
+uint64_t Zobrist::pieceKey(int tetrominoIndex) {
+  if (tetrominoIndex < 0 || tetrominoIndex >= numberOfTetrominos) {
+    return 0;
+  }
+  return keys().pieces[tetrominoIndex];
+}
+
+uint64_t Zobrist::previewKey(int tetrominoIndex) {
+  if (tetrominoIndex < 0 || tetrominoIndex >= numberOfTetrominos) {
+    return 0;
+  }
+  return keys().previews[tetrominoIndex];
+}
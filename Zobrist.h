@@ -0,0 +1,46 @@
+// Copyright: 2024 by Ioan Oleksii Kelier keleralexei@gmail.com
+// Code snippets from the lectures where used
+//
+// This page was used to understand Zobrist hashing:
+// https://www.chessprogramming.org/Zobrist_Hashing
+//
+
+#pragma once
+#include <cstdint>
+
+// Random keys for Zobrist hashing of a game position. A position is hashed
+// by XOR-ing the keys of all occupied cells, the key of the current tetromino
+// and the key of the tetromino in the preview box. Because XOR is its own
+// inverse, placing or removing a single cell only needs one XOR, so the hash
+// can be updated incrementally instead of recomputed.
+//
+// Cells are addressed relative to the playable part of the field
+// (without walls, roof and floor): row 0 is the spawn row,
+// column 0 is the first column to the right of the left wall.
+class Zobrist {
+public:
+  static constexpr int rows = 20;
+  static constexpr int cols = 10;
+  static constexpr int numberOfTetrominos = 7;
+
+  // Key of a single occupied cell. Cells outside of the playable
+  // field have key 0, so they don't change the hash.
+  static uint64_t cellKey(int row, int col);
+
+  // Key of the current (falling) tetromino and of the preview tetromino.
+  // Index is the same as in AbstractTetrisGame::chooseTetromino.
+  static uint64_t pieceKey(int tetrominoIndex);
+  static uint64_t previewKey(int tetrominoIndex);
+
+private:
+  // All keys in one table, generated once with a fixed seed so that
+  // hashes are reproducible between runs (and between processes).
+  struct Keys {
+    Keys();
+    uint64_t cells[rows][cols];
+    uint64_t pieces[numberOfTetrominos];
+    uint64_t previews[numberOfTetrominos];
+  };
+
+  static const Keys &keys();
+};